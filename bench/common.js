@@ -0,0 +1,85 @@
+// Helpers shared by the addon benchmarks: loading the addon, synthetic screens and timing.
+const path = require("path");
+
+/**
+ * Loads the built addon, or exits with a message when there is none (it only builds on Windows).
+ */
+function loadAddon() {
+  try {
+    return require("node-gyp-build")(path.resolve(__dirname, ".."));
+  } catch (error) {
+    console.error(`The native addon is not built (${error.message}); run npm install on Windows first`);
+    process.exit(1);
+  }
+}
+
+/**
+ * Small deterministic random number generator, so every run measures the same images.
+ */
+function random(seed) {
+  let state = seed >>> 0;
+  return () => {
+    state = (Math.imul(state, 1664525) + 1013904223) >>> 0;
+    return state / 4294967296;
+  };
+}
+
+/**
+ * A screen-like BGR(A) image: a flat background with a few hundred filled rectangles of random color, plus noise.
+ */
+function syntheticScreen(width, height, channels = 3, seed = 1) {
+  const next = random(seed);
+  const data = new Uint8Array(width * height * channels).fill(40);
+  for (let i = 0; i < 300; i++) {
+    const w = 8 + Math.floor(next() * 120);
+    const h = 8 + Math.floor(next() * 60);
+    const x0 = Math.floor(next() * (width - w));
+    const y0 = Math.floor(next() * (height - h));
+    const color = [next() * 255, next() * 255, next() * 255, 255];
+    for (let y = y0; y < y0 + h; y++)
+      for (let x = x0; x < x0 + w; x++)
+        for (let c = 0; c < channels; c++) data[(y * width + x) * channels + c] = color[c];
+  }
+  for (let i = 0; i < data.length; i++) data[i] = Math.min(255, data[i] + Math.floor(next() * 6));
+  return { width, height, channels, data };
+}
+
+/**
+ * Copies the [x, y, width, height] part of an image into a new tightly packed image.
+ */
+function crop(image, [x0, y0, width, height]) {
+  const channels = image.channels || image.data.length / (image.width * image.height);
+  const data = new Uint8Array(width * height * channels);
+  for (let y = 0; y < height; y++) {
+    const start = ((y0 + y) * image.width + x0) * channels;
+    data.set(image.data.subarray(start, start + width * channels), y * width * channels);
+  }
+  return { width, height, channels, data };
+}
+
+/**
+ * Mean milliseconds per call of `fn` over `iterations` calls, after `warmup` untimed calls.
+ */
+function timeIt(fn, iterations = 20, warmup = 2) {
+  for (let i = 0; i < warmup; i++) fn();
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < iterations; i++) fn();
+  return Number(process.hrtime.bigint() - start) / 1e6 / iterations;
+}
+
+/**
+ * Same as timeIt for functions returning a Promise; the calls run one after another.
+ */
+async function timeItAsync(fn, iterations = 20, warmup = 2) {
+  for (let i = 0; i < warmup; i++) await fn();
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < iterations; i++) await fn();
+  return Number(process.hrtime.bigint() - start) / 1e6 / iterations;
+}
+
+function report(name, ms, baselineMs) {
+  const speedup = baselineMs ? `  ${(baselineMs / ms).toFixed(2)}x` : "";
+  console.log(`${name.padEnd(40)} ${ms.toFixed(3).padStart(10)} ms${speedup}`);
+}
+
+module.exports = { loadAddon, random, syntheticScreen, crop, timeIt, timeItAsync, report };
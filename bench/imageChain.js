@@ -0,0 +1,47 @@
+// A five step chain (gray, blur, region, rectangle, match) on a 1080p screen: through the ImageData functions the
+// OpenCV class wraps, where every step copies pixels into a new JS buffer, and through Image handles, where the
+// pixels stay native until the match result comes back.
+const { loadAddon, syntheticScreen, crop, timeIt, report } = require("./common");
+
+const addon = loadAddon();
+const screen = syntheticScreen(1920, 1080, 3);
+const region = [200, 100, 1280, 720];
+const templateData = addon.bgrToGray(crop(screen, [700, 400, 64, 48]));
+
+const viaImageData = () => {
+  const gray = addon.bgrToGray(screen);
+  const blurred = addon.blur(gray, 3, 3);
+  const part = addon.getRegion(blurred, region);
+  const marked = addon.drawRectangle(part, [0, 0], [10, 10], [255, 255, 255], 1);
+  return addon.matchTemplate(marked, templateData);
+};
+
+const screenImage = new addon.Image(screen);
+const templateImage = new addon.Image(templateData);
+const viaImage = () =>
+  screenImage
+    .bgrToGray()
+    .blur(3, 3)
+    .getRegion(region)
+    .drawRectangle([0, 0], [10, 10], [255, 255, 255], 1)
+    .matchTemplate(templateImage);
+
+// Loading the screen counts too: the ImageData path pays it inside every step
+const viaImageWithLoad = () =>
+  new addon.Image(screen)
+    .bgrToGray()
+    .blur(3, 3)
+    .getRegion(region)
+    .drawRectangle([0, 0], [10, 10], [255, 255, 255], 1)
+    .matchTemplate(templateImage);
+
+const a = viaImageData();
+const b = viaImage();
+if (a.maxLocation.x !== b.maxLocation.x || a.maxLocation.y !== b.maxLocation.y)
+  console.warn("The two chains found different matches", a.maxLocation, b.maxLocation);
+
+console.log("1920x1080 BGR, gray -> blur 3x3 -> 1280x720 region -> rectangle -> match 64x48");
+const baseline = timeIt(viaImageData);
+report("ImageData functions (OpenCV class)", baseline);
+report("Image handles", timeIt(viaImage), baseline);
+report("Image handles, including new Image()", timeIt(viaImageWithLoad), baseline);
@@ -0,0 +1,39 @@
+// One matchTemplates call against a JS loop of matchTemplate over the same templates, for 4, 16 and 64 small templates
+// and 16 large ones cut from a 1080p screen. The native call converts the screen once, shares it between templates
+// (with its DFT for the large ones) and runs them in parallel on the worker pool; the loop converts and crosses into
+// native code once per template.
+const { loadAddon, syntheticScreen, crop, timeIt, report, random } = require("./common");
+
+const addon = loadAddon();
+const TM_CCOEFF_NORMED = 5;
+const screen = syntheticScreen(1920, 1080, 4);
+const next = random(7);
+
+for (const [count, width, height] of [
+  [4, 48, 32],
+  [16, 48, 32],
+  [64, 48, 32],
+  [16, 128, 96],
+]) {
+  const templates = [];
+  for (let i = 0; i < count; i++) {
+    const x = Math.floor(next() * (1920 - width));
+    const y = Math.floor(next() * (1080 - height));
+    templates.push(crop(screen, [x, y, width, height]));
+  }
+
+  const loop = () => templates.map((template) => addon.matchTemplate(screen, template, TM_CCOEFF_NORMED));
+  const batched = () => addon.matchTemplates(screen, templates, { method: TM_CCOEFF_NORMED });
+
+  const expected = loop();
+  const table = batched();
+  const mismatches = expected.filter(
+    (match, i) => match.maxLocation.x !== table.maxX[i] || match.maxLocation.y !== table.maxY[i]
+  ).length;
+  if (mismatches) console.warn(`${mismatches} of ${count} templates matched elsewhere in the batched call`);
+
+  console.log(`1920x1080 BGRA, ${count} templates of ${width}x${height}, ${addon.getWorkerThreads()} worker threads`);
+  const baseline = timeIt(loop, 5, 1);
+  report("  JS loop of matchTemplate", baseline);
+  report("  matchTemplates", timeIt(batched, 5, 1), baseline);
+}
@@ -0,0 +1,92 @@
+// Builds and runs the native micro-benchmarks in bench/native against the addon's own headers.
+// Usage: node bench/native.js [name...]   (e.g. `node bench/native.js idleWait`; no names runs them all)
+// The compiler is $CXX, or cl on Windows and c++ elsewhere. The headers only need the bundled OpenCV includes;
+// a source with a `// Links: opencv4` line also links the system OpenCV found by pkg-config.
+const { execFileSync } = require("child_process");
+const fs = require("fs");
+const os = require("os");
+const path = require("path");
+
+const root = path.resolve(__dirname, "..");
+const nativeDir = path.join(__dirname, "native");
+const useCl = !process.env.CXX && process.platform === "win32";
+
+/**
+ * Compiler flags of the system OpenCV for a source that asks for it with a `// Links: opencv4` line, [] for one
+ * that does not, or null when it asks but pkg-config does not know OpenCV (or the compiler is cl).
+ */
+function linkFlags(source) {
+  if (!/^\/\/ Links: opencv4$/m.test(fs.readFileSync(source, "utf8"))) return [];
+  if (useCl) return null;
+  try {
+    return execFileSync("pkg-config", ["--cflags", "--libs", "opencv4"], { encoding: "utf8", stdio: ["ignore", "pipe", "ignore"] }).trim().split(/\s+/);
+  } catch (error) {
+    return null;
+  }
+}
+
+/**
+ * Compiles `source` with optimizations into `output`, with the addon headers and the source's own directory on the
+ * include path. Returns false if no compiler could be started, or if the source links an OpenCV that is not found.
+ * Also used by the native unit tests.
+ */
+function compile(source, output) {
+  const includes = [path.join(root, "include"), path.join(root, "src", "cpp"), path.dirname(source)];
+  const compiler = process.env.CXX || (useCl ? "cl" : "c++");
+  const links = linkFlags(source);
+  if (!links) {
+    console.error(`${path.basename(source)} links the system OpenCV, which pkg-config does not find; skipped`);
+    return false;
+  }
+  // The system OpenCV's own headers come first, so they match the libraries linked
+  const args = useCl
+    ? ["/nologo", "/EHsc", "/O2", "/std:c++14", "/DNOMINMAX", ...includes.map((dir) => `/I${dir}`), source, `/Fe${output}`, `/Fo${output}.obj`]
+    : ["-std=c++14", "-O2", "-pthread", ...links.filter((flag) => flag.startsWith("-I")), ...includes.map((dir) => `-I${dir}`), source, "-o", output, ...links.filter((flag) => !flag.startsWith("-I"))];
+  try {
+    execFileSync(compiler, args, { stdio: ["ignore", "inherit", "inherit"] });
+    return true;
+  } catch (error) {
+    if (error.code === "ENOENT") {
+      console.error(`Compiler '${compiler}' not found; set CXX to run the native benchmarks`);
+      return false;
+    }
+    throw error;
+  }
+}
+
+function main() {
+  const names = process.argv.slice(2);
+  const sources = fs
+    .readdirSync(nativeDir)
+    .filter((file) => file.endsWith(".cpp"))
+    .filter((file) => names.length === 0 || names.includes(path.basename(file, ".cpp")));
+  if (sources.length === 0) {
+    console.error(`No native benchmark named ${names.join(", ")}`);
+    process.exit(1);
+  }
+
+  const buildDir = fs.mkdtempSync(path.join(os.tmpdir(), "native-bench-"));
+  for (const file of sources) {
+    const output = path.join(buildDir, path.basename(file, ".cpp") + (process.platform === "win32" ? ".exe" : ""));
+    const source = path.join(nativeDir, file);
+    console.log(`== ${path.basename(file, ".cpp")}`);
+    // A missing OpenCV skips only the benchmarks linking it; a missing compiler fails them all
+    if (!linkFlags(source)) {
+      console.error("  skipped: needs the system OpenCV");
+      continue;
+    }
+    if (!compile(source, output)) process.exit(1);
+    try {
+      execFileSync(output, [], { stdio: "inherit" });
+    } catch (error) {
+      // A benchmark whose output disagrees with its reference exits non-zero; the others still run
+      console.error(`  ${path.basename(file, ".cpp")} exited with code ${error.status}`);
+      process.exitCode = 1;
+    }
+  }
+  fs.rmSync(buildDir, { recursive: true, force: true });
+}
+
+if (require.main === module) main();
+
+module.exports = { compile };
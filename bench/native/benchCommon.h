@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/**
+ * CPU time used by the calling thread so far, in milliseconds.
+ */
+inline double ThreadCpuMs()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+    auto toMs = [](const FILETIME &time)
+    { return ((static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10000.0; };
+    return toMs(kernel) + toMs(user);
+#else
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+#endif
+}
+
+/**
+ * Wall-clock milliseconds since an arbitrary start.
+ */
+inline double WallMs()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Runs `body` `iterations` times after one warm-up call and returns the mean wall time per call in milliseconds.
+ */
+template <typename Body>
+double MeanMs(int iterations, Body &&body)
+{
+    body();
+    const double start = WallMs();
+    for (int i = 0; i < iterations; ++i)
+        body();
+    return (WallMs() - start) / iterations;
+}
+
+/**
+ * Keeps the compiler from dropping a computation whose result is otherwise unused.
+ */
+template <typename T>
+void KeepAlive(const T &value)
+{
+    // The pointer itself is volatile, so every store to it is kept
+    static const void *volatile sink;
+    sink = &value;
+}
@@ -0,0 +1,116 @@
+// Binary matching from binaryMatch.h against the OpenCV path matchTemplateAll takes for a gray image (TM_CCOEFF_NORMED
+// plus peak search), on a thresholded 1080p screen of glyph-like blocks. The binary matcher runs with and without
+// its early rejection, and the mean number of template rows it scores per position shows how much rejection skips.
+// Links: opencv4
+#include <cstdio>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+#include <binaryMatch.h>
+#include "benchCommon.h"
+
+const int WIDTH = 1920;
+const int HEIGHT = 1080;
+const int ITERATIONS = 5;
+const double THRESHOLD = 0.9;
+const cv::Rect TEMPLATE_RECT(1000, 500, 48, 24);
+
+cv::Mat BinaryScreen()
+{
+    cv::Mat screen(HEIGHT, WIDTH, CV_8UC1, cv::Scalar(0));
+    uint32_t state = 12345;
+    auto next = [&state](int range)
+    {
+        state = state * 1664525 + 1013904223;
+        return static_cast<int>((state >> 8) % static_cast<uint32_t>(range));
+    };
+    // Lines of small blocks, like text and icons thresholded from a UI
+    for (int i = 0; i < 20000; ++i)
+        cv::rectangle(screen, cv::Rect(next(WIDTH - 8), next(HEIGHT - 12), 2 + next(6), 4 + next(8)), cv::Scalar(255), cv::FILLED);
+    return screen;
+}
+
+// Mean template rows BinaryDistanceAt scores per position before it rejects it, sampled on every 4th row
+double MeanRowsScored(const BinaryImage &src, const BinaryTemplate &templ, int maxDistance)
+{
+    double rows = 0;
+    long positions = 0;
+    for (int y = 0; y + templ.height <= src.height; y += 4)
+    {
+        for (int x = 0; x + templ.width <= src.width; ++x, ++positions)
+        {
+            const uint64_t *mask = templ.Mask(x & 63);
+            int distance = 0;
+            int row = 0;
+            while (row < templ.height && distance <= maxDistance)
+            {
+                distance += MaskedHammingDistance(src.Row(y + row) + (x >> 6), templ.Row(x & 63, row), mask, templ.wordsPerRow);
+                ++row;
+            }
+            rows += row;
+        }
+    }
+    return rows / positions;
+}
+
+// BinaryMatchTemplate scoring every position in full, as if no position could be rejected early
+std::vector<Peak> BinaryMatchExhaustive(const cv::Mat &srcGray, const cv::Mat &templGray, const PeakOptions &options)
+{
+    const BinaryImage src = PackBinary(srcGray, 127);
+    const BinaryTemplate templ = PackBinaryTemplate(templGray, 127);
+    const int area = templ.width * templ.height;
+    cv::Mat scores(srcGray.rows - templGray.rows + 1, srcGray.cols - templGray.cols + 1, CV_32F);
+    cv::parallel_for_(cv::Range(0, scores.rows), [&](const cv::Range &range)
+                      {
+        for (int y = range.start; y < range.end; ++y)
+        {
+            float *row = scores.ptr<float>(y);
+            for (int x = 0; x < scores.cols; ++x)
+                row[x] = 1.0f - static_cast<float>(BinaryDistanceAt(src, templ, x, y, area)) / area;
+        } });
+    return FindPeaks(scores, templGray.size(), options);
+}
+
+bool Finds(const std::vector<Peak> &peaks, cv::Point location)
+{
+    for (const Peak &peak : peaks)
+        if (peak.x == location.x && peak.y == location.y)
+            return true;
+    return false;
+}
+
+int main()
+{
+    const cv::Mat screen = BinaryScreen();
+    const cv::Mat templ = screen(TEMPLATE_RECT).clone();
+    PeakOptions options;
+    options.threshold = THRESHOLD;
+
+    std::vector<Peak> opencvPeaks, binaryPeaks;
+    const double opencvMs = MeanMs(ITERATIONS, [&]
+                                   {
+        cv::Mat response;
+        cv::matchTemplate(screen, templ, response, cv::TM_CCOEFF_NORMED);
+        opencvPeaks = FindPeaks(response, templ.size(), options); });
+    const double exhaustiveMs = MeanMs(ITERATIONS, [&]
+                                       { KeepAlive(BinaryMatchExhaustive(screen, templ, options)); });
+    const double binaryMs = MeanMs(ITERATIONS, [&]
+                                   { binaryPeaks = BinaryMatchTemplate(screen, templ, 127, options); });
+
+    const bool found = Finds(opencvPeaks, TEMPLATE_RECT.tl()) && Finds(binaryPeaks, TEMPLATE_RECT.tl());
+    if (!found)
+        printf("MISMATCH: a matcher missed the template's own location\n");
+
+    const BinaryImage packedScreen = PackBinary(screen, 127);
+    const BinaryTemplate packedTempl = PackBinaryTemplate(templ, 127);
+    const int area = templ.cols * templ.rows;
+
+    printf("%dx%d binary screen, %dx%d template, threshold %.2f, CV_SIMD %s, %d threads, %d iterations\n", WIDTH, HEIGHT,
+           templ.cols, templ.rows, THRESHOLD, CV_SIMD ? "on" : "off", cv::getNumThreads(), ITERATIONS);
+    printf("TM_CCOEFF_NORMED + peaks    %7.2f ms   %zu matches\n", opencvMs, opencvPeaks.size());
+    printf("binary, no early rejection  %7.2f ms   %.1f of %d rows per position   %.1fx\n", exhaustiveMs,
+           MeanRowsScored(packedScreen, packedTempl, area), templ.rows, opencvMs / exhaustiveMs);
+    printf("binary, early rejection     %7.2f ms   %.1f of %d rows per position   %.1fx   %zu matches\n", binaryMs,
+           MeanRowsScored(packedScreen, packedTempl, static_cast<int>((1.0 - THRESHOLD) * area)), templ.rows,
+           opencvMs / binaryMs, binaryPeaks.size());
+    return found ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+// CPU time spent waiting for frames from a source that delivers them late, which is what a capture sees while a
+// window is idle. The baseline spins on a flag the way the original capture loop did; the frame source sleeps on
+// its condition variable until the frame is pushed.
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <frameSource.h>
+#include "benchCommon.h"
+
+const int FRAMES = 20;
+const int DELAY_MS = 50;
+const int WIDTH = 64;
+const int HEIGHT = 64;
+
+/**
+ * Stand-in for a window that produces a frame every DELAY_MS.
+ */
+template <typename Push>
+std::thread DelayedProducer(Push push)
+{
+    return std::thread([push]
+                       {
+        for (int i = 0; i < FRAMES; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(DELAY_MS));
+            push();
+        } });
+}
+
+void Report(const char *name, double wallMs, double cpuMs)
+{
+    printf("%-22s wall %7.1f ms   waiting thread CPU %7.1f ms (%5.1f%%)\n", name, wallMs, cpuMs, 100.0 * cpuMs / wallMs);
+}
+
+void SpinWait()
+{
+    std::atomic<int> arrived{0};
+    std::thread producer = DelayedProducer([&]
+                                           { arrived.fetch_add(1); });
+    const double wall = WallMs();
+    const double cpu = ThreadCpuMs();
+    for (int seen = 0; seen < FRAMES;)
+    {
+        while (arrived.load() == seen)
+        {
+        }
+        ++seen;
+    }
+    Report("spin on flag", WallMs() - wall, ThreadCpuMs() - cpu);
+    producer.join();
+}
+
+void ConditionWait()
+{
+    MemoryFrameSource source(WIDTH, HEIGHT, 4);
+    std::vector<uint8_t> pixels(WIDTH * HEIGHT * 4, 128);
+    std::thread producer = DelayedProducer([&]
+                                           { source.PushFrame(pixels.data(), WIDTH * 4); });
+    const double wall = WallMs();
+    const double cpu = ThreadCpuMs();
+    uint64_t after = 0;
+    for (int i = 0; i < FRAMES; ++i)
+    {
+        FrameView frame;
+        if (!source.AcquireFrame(frame, 5000, after))
+        {
+            printf("frame %d timed out\n", i);
+            break;
+        }
+        after = frame.sequence;
+        source.ReleaseFrame();
+    }
+    Report("condition variable", WallMs() - wall, ThreadCpuMs() - cpu);
+    producer.join();
+}
+
+int main()
+{
+    printf("%d frames, one every %d ms\n", FRAMES, DELAY_MS);
+    SpinWait();
+    ConditionWait();
+    return 0;
+}
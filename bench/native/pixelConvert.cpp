@@ -0,0 +1,100 @@
+// Frame conversion kernels from pixelConvert.h against straightforward per-pixel loops, on a 1080p BGRA frame
+// with a padded row pitch like a mapped texture. Both sides produce identical output, which is checked first.
+#include <cstring>
+#include <vector>
+#include <pixelConvert.h>
+#include "benchCommon.h"
+
+const int WIDTH = 1920;
+const int HEIGHT = 1080;
+const size_t STRIDE = WIDTH * 4 + 64;
+const int ITERATIONS = 50;
+
+void NaiveBgraToBgr(const uint8_t *src, size_t stride, uint8_t *dst, int width, int height)
+{
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t *row = src + y * stride;
+        for (int x = 0; x < width; ++x)
+            for (int c = 0; c < 3; ++c)
+                *dst++ = row[x * 4 + c];
+    }
+}
+
+void NaiveBgraToGray(const uint8_t *src, size_t stride, uint8_t *dst, int width, int height)
+{
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t *row = src + y * stride;
+        for (int x = 0; x < width; ++x)
+            *dst++ = GrayPixel(row[x * 4], row[x * 4 + 1], row[x * 4 + 2]);
+    }
+}
+
+// Converts the whole frame to gray first, then averages 2x2 blocks: two passes over memory
+void NaiveBgraToHalfGray(const uint8_t *src, size_t stride, uint8_t *dst, int width, int height)
+{
+    std::vector<uint8_t> gray(static_cast<size_t>(width) * height);
+    NaiveBgraToGray(src, stride, gray.data(), width, height);
+    for (int y = 0; y < height / 2; ++y)
+    {
+        const uint8_t *row0 = gray.data() + (2 * y) * width;
+        const uint8_t *row1 = row0 + width;
+        for (int x = 0; x < width / 2; ++x)
+            *dst++ = static_cast<uint8_t>((row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1] + 2) >> 2);
+    }
+}
+
+// Returns false, without timing anything, when the kernel's output differs from the naive loop's
+template <typename Naive, typename Kernel>
+bool Compare(const char *name, size_t outputBytes, Naive naive, Kernel kernel)
+{
+    std::vector<uint8_t> expected(outputBytes), actual(outputBytes);
+    naive(expected.data());
+    kernel(actual.data());
+    if (expected != actual)
+    {
+        printf("%-14s MISMATCH between the naive loop and the kernel\n", name);
+        return false;
+    }
+
+    const double naiveMs = MeanMs(ITERATIONS, [&]
+                                  { naive(expected.data()); KeepAlive(expected[0]); });
+    const double kernelMs = MeanMs(ITERATIONS, [&]
+                                   { kernel(actual.data()); KeepAlive(actual[0]); });
+    const double megapixels = WIDTH * HEIGHT / 1e6;
+    printf("%-14s naive %6.2f ms (%6.0f MP/s)   kernel %6.2f ms (%6.0f MP/s)   %.1fx\n", name, naiveMs,
+           megapixels / naiveMs * 1000, kernelMs, megapixels / kernelMs * 1000, naiveMs / kernelMs);
+    return true;
+}
+
+int main()
+{
+    std::vector<uint8_t> frame(STRIDE * HEIGHT);
+    uint32_t state = 12345;
+    for (uint8_t &byte : frame)
+    {
+        state = state * 1664525 + 1013904223;
+        byte = static_cast<uint8_t>(state >> 24);
+    }
+    const uint8_t *src = frame.data();
+
+    printf("%dx%d BGRA, row pitch %zu, CV_SIMD %s, %d iterations\n", WIDTH, HEIGHT, STRIDE, CV_SIMD ? "on" : "off", ITERATIONS);
+    bool matched = true;
+    matched &= Compare("bgra -> bgr", static_cast<size_t>(WIDTH) * HEIGHT * 3,
+            [&](uint8_t *dst)
+            { NaiveBgraToBgr(src, STRIDE, dst, WIDTH, HEIGHT); },
+            [&](uint8_t *dst)
+            { ConvertBgraToBgr(src, STRIDE, dst, WIDTH, HEIGHT); });
+    matched &= Compare("bgra -> gray", static_cast<size_t>(WIDTH) * HEIGHT,
+            [&](uint8_t *dst)
+            { NaiveBgraToGray(src, STRIDE, dst, WIDTH, HEIGHT); },
+            [&](uint8_t *dst)
+            { ConvertColorToGray(src, STRIDE, 4, dst, WIDTH, HEIGHT); });
+    matched &= Compare("bgra -> gray/2", static_cast<size_t>(WIDTH / 2) * (HEIGHT / 2),
+            [&](uint8_t *dst)
+            { NaiveBgraToHalfGray(src, STRIDE, dst, WIDTH, HEIGHT); },
+            [&](uint8_t *dst)
+            { ConvertColorToHalfGray(src, STRIDE, 4, dst, WIDTH, HEIGHT); });
+    return matched ? 0 : 1;
+}
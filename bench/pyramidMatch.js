@@ -0,0 +1,64 @@
+// Accuracy and speed of the coarse-to-fine pyramid search against the exhaustive search it replaces. Each case
+// cuts a template from a synthetic 1080p screen, adds noise to it and matches it at several pyramid settings.
+// A pyramid result counts as a hit when it lands within one pixel of the exhaustive best match.
+const { loadAddon, syntheticScreen, crop, timeIt, report, random } = require("./common");
+
+const addon = loadAddon();
+const TM_CCOEFF_NORMED = 5;
+const SCREENS = 8;
+const TEMPLATES_PER_SCREEN = 8;
+const settings = [
+  { levels: 1, candidates: 1 },
+  { levels: 1, candidates: 4 },
+  { levels: 2, candidates: 1 },
+  { levels: 2, candidates: 4 },
+  { levels: 2, candidates: 16 },
+  { levels: 3, candidates: 4 },
+  { levels: 3, candidates: 16 },
+];
+
+function noisy(image, next, amplitude) {
+  const data = Uint8Array.from(image.data, (value) => Math.max(0, Math.min(255, value + Math.round((next() - 0.5) * amplitude))));
+  return { ...image, data };
+}
+
+for (const [width, height] of [[64, 48], [24, 16]]) {
+  const cases = [];
+  const next = random(width * 1000 + height);
+  for (let s = 0; s < SCREENS; s++) {
+    const screen = addon.bgrToGray(syntheticScreen(1920, 1080, 3, s + 1));
+    for (let t = 0; t < TEMPLATES_PER_SCREEN; t++) {
+      const x = Math.floor(next() * (1920 - width));
+      const y = Math.floor(next() * (1080 - height));
+      cases.push({ screen, template: noisy(crop(screen, [x, y, width, height]), next, 16) });
+    }
+  }
+  const exhaustive = cases.map(({ screen, template }) => addon.matchTemplate(screen, template, TM_CCOEFF_NORMED));
+
+  console.log(`${cases.length} templates of ${width}x${height} on 1920x1080 gray screens`);
+  let caseIndex = 0;
+  const nextCase = () => cases[caseIndex++ % cases.length];
+  const baseline = timeIt(() => {
+    const { screen, template } = nextCase();
+    addon.matchTemplate(screen, template, TM_CCOEFF_NORMED);
+  }, cases.length, 1);
+  report("  exhaustive (hit rate 100%)", baseline);
+
+  for (const pyramid of settings) {
+    let hits = 0;
+    let scoreLoss = 0;
+    cases.forEach(({ screen, template }, i) => {
+      const match = addon.matchTemplate(screen, template, TM_CCOEFF_NORMED, null, { pyramid });
+      const best = exhaustive[i];
+      if (Math.abs(match.maxLocation.x - best.maxLocation.x) <= 1 && Math.abs(match.maxLocation.y - best.maxLocation.y) <= 1) hits++;
+      scoreLoss += best.maxValue - match.maxValue;
+    });
+    const ms = timeIt(() => {
+      const { screen, template } = nextCase();
+      addon.matchTemplate(screen, template, TM_CCOEFF_NORMED, null, { pyramid });
+    }, cases.length, 1);
+    const hitRate = ((100 * hits) / cases.length).toFixed(0);
+    const meanLoss = (scoreLoss / cases.length).toFixed(4);
+    report(`  levels ${pyramid.levels}, candidates ${String(pyramid.candidates).padEnd(2)} (hit ${hitRate.padStart(3)}%, score -${meanLoss})`, ms, baseline);
+  }
+}
@@ -0,0 +1,30 @@
+// A compiled Template against plain matchTemplate on repeated same-sized gray frames, with and without the cached
+// DFT, for template sizes around the DFT crossover. Shows whether compiling pays off and where `dft` starts to.
+const { loadAddon, syntheticScreen, crop, timeIt, report } = require("./common");
+
+const addon = loadAddon();
+const TM_CCOEFF_NORMED = 5;
+
+for (const [width, height] of [[640, 480], [1920, 1080]]) {
+  const frame = addon.bgrToGray(syntheticScreen(width, height, 3));
+  const frameImage = new addon.Image(frame);
+  for (const size of [16, 32, 64, 128, 256]) {
+    if (size * 2 > height) continue;
+    const templateData = crop(frame, [Math.floor(width / 3), Math.floor(height / 3), size, size]);
+    const compiled = new addon.Template(templateData, { method: TM_CCOEFF_NORMED });
+    const compiledDft = new addon.Template(templateData, { method: TM_CCOEFF_NORMED, dft: true });
+
+    const expected = addon.matchTemplate(frame, templateData, TM_CCOEFF_NORMED).maxLocation;
+    for (const template of [compiled, compiledDft]) {
+      const found = template.match(frameImage).maxLocation;
+      if (found.x !== expected.x || found.y !== expected.y) console.warn(`${size}x${size}: compiled template matched elsewhere`);
+    }
+
+    console.log(`${width}x${height} gray frame, ${size}x${size} template`);
+    const iterations = width * size > 1920 * 128 ? 5 : 20;
+    const baseline = timeIt(() => addon.matchTemplate(frame, templateData, TM_CCOEFF_NORMED), iterations);
+    report("  matchTemplate", baseline);
+    report("  Template", timeIt(() => compiled.match(frameImage), iterations), baseline);
+    report("  Template { dft: true }", timeIt(() => compiledDft.match(frameImage), iterations), baseline);
+  }
+}
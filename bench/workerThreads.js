@@ -0,0 +1,40 @@
+// Tiled matching on worker pools of 1, 4 and 16 threads against the untiled call, plus eight async tiled matches
+// in flight at once, which queue their tiles on the same pool. Also checks that tiling finds the same matches.
+const { loadAddon, syntheticScreen, crop, timeIt, timeItAsync, report } = require("./common");
+
+const addon = loadAddon();
+const TM_CCOEFF_NORMED = 5;
+const screen = syntheticScreen(1920, 1080, 4);
+const template = crop(screen, [700, 400, 64, 48]);
+const allOptions = { method: TM_CCOEFF_NORMED, threshold: 0.9 };
+
+async function main() {
+  const untiledAll = addon.matchTemplateAll(screen, template, allOptions);
+  const baseline = timeIt(() => addon.matchTemplate(screen, template, TM_CCOEFF_NORMED), 10, 1);
+  const baselineAll = timeIt(() => addon.matchTemplateAll(screen, template, allOptions), 10, 1);
+  const restore = addon.getWorkerThreads();
+
+  for (const threads of [1, 4, 16]) {
+    addon.setWorkerThreads(threads);
+    const tiledAll = addon.matchTemplateAll(screen, template, { ...allOptions, tiles: true });
+    const same =
+      tiledAll.count === untiledAll.count &&
+      tiledAll.x.every((x, i) => x === untiledAll.x[i] && tiledAll.y[i] === untiledAll.y[i]);
+    if (!same) console.warn(`${threads} threads: tiled matchTemplateAll found different matches than untiled`);
+
+    console.log(`1920x1080 BGRA, 64x48 template, ${threads} worker threads`);
+    report("  matchTemplate", baseline);
+    report("  matchTemplate, tiled", timeIt(() => addon.matchTemplate(screen, template, TM_CCOEFF_NORMED, null, { tiles: true }), 10, 1), baseline);
+    report("  matchTemplateAll", baselineAll);
+    report("  matchTemplateAll, tiled", timeIt(() => addon.matchTemplateAll(screen, template, { ...allOptions, tiles: true }), 10, 1), baselineAll);
+    const concurrent = () =>
+      Promise.all(
+        Array.from({ length: 8 }, () => addon.matchTemplateAsync(screen, template, TM_CCOEFF_NORMED, null, { tiles: true }))
+      );
+    report("  8 x matchTemplateAsync, tiled (per call)", (await timeItAsync(concurrent, 5, 1)) / 8, baseline);
+  }
+
+  addon.setWorkerThreads(restore);
+}
+
+main();
@@ -28,7 +28,8 @@
             "conditions": [
                 ["OS=='win'", {
                     "defines": [
-                        "_CRT_SECURE_NO_WARNINGS"
+                        "_CRT_SECURE_NO_WARNINGS",
+                        "NOMINMAX"
                     ],
                     "msvs_settings": {
                         "VCCLCompilerTool": {
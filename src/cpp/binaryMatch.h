@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <peaks.h>
+#include <stopCondition.h>
+
+/**
+ * Template matching on thresholded images. Source and template are packed to one bit per pixel, and a position
+ * is scored by the Hamming distance between the template and the source under it: XOR the packed rows and count
+ * the set bits. The score is the fraction of template pixels that agree, 1 for a perfect match.
+ *
+ * The template is packed once for each of the 64 bit offsets within a source word, so scoring a position only
+ * reads whole source words. A position stops being scored as soon as its distance can no longer pass the
+ * threshold, which on typical UI frames rejects most positions after a row or two.
+ */
+
+inline int PopCount64(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(value);
+#else
+    value = value - ((value >> 1) & 0x5555555555555555ULL);
+    value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+    value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((value * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * Number of bits set in (a ^ b) & mask over `count` words.
+ */
+inline int MaskedHammingDistance(const uint64_t *a, const uint64_t *b, const uint64_t *mask, int count)
+{
+    int distance = 0;
+    int i = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint64>::vlanes();
+    if (count >= lanes)
+    {
+        cv::v_uint64 sum = cv::vx_setzero_u64();
+        for (; i <= count - lanes; i += lanes)
+            sum = cv::v_add(sum, cv::v_popcount(cv::v_and(cv::v_xor(cv::vx_load(a + i), cv::vx_load(b + i)), cv::vx_load(mask + i))));
+        distance = static_cast<int>(cv::v_reduce_sum(sum));
+    }
+#endif
+    for (; i < count; ++i)
+        distance += PopCount64((a[i] ^ b[i]) & mask[i]);
+    return distance;
+}
+
+/**
+ * One bit per pixel, least significant bit first, set where the pixel is above the binarization level.
+ * Rows carry two spare zero words so a template can be read at any offset without bounds checks.
+ */
+struct BinaryImage
+{
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> bits;
+
+    const uint64_t *Row(int y) const
+    {
+        return bits.data() + static_cast<size_t>(y) * wordsPerRow;
+    }
+};
+
+inline BinaryImage PackBinary(const cv::Mat &gray, int level)
+{
+    BinaryImage image;
+    image.width = gray.cols;
+    image.height = gray.rows;
+    image.wordsPerRow = (gray.cols + 63) / 64 + 2;
+    image.bits.assign(static_cast<size_t>(image.wordsPerRow) * gray.rows, 0);
+    for (int y = 0; y < gray.rows; ++y)
+    {
+        const uint8_t *src = gray.ptr<uint8_t>(y);
+        uint64_t *dst = image.bits.data() + static_cast<size_t>(y) * image.wordsPerRow;
+        for (int x = 0; x < gray.cols; ++x)
+            if (src[x] > level)
+                dst[x >> 6] |= uint64_t(1) << (x & 63);
+    }
+    return image;
+}
+
+/**
+ * A packed template shifted to each of the 64 bit offsets, with the mask of the bits it covers at that offset.
+ */
+struct BinaryTemplate
+{
+    int width = 0;
+    int height = 0;
+    // Words a template row spans at any offset
+    int wordsPerRow = 0;
+    std::vector<uint64_t> shifted;
+    std::vector<uint64_t> masks;
+
+    const uint64_t *Row(int shift, int y) const
+    {
+        return shifted.data() + (static_cast<size_t>(shift) * height + y) * wordsPerRow;
+    }
+
+    const uint64_t *Mask(int shift) const
+    {
+        return masks.data() + static_cast<size_t>(shift) * wordsPerRow;
+    }
+};
+
+inline BinaryTemplate PackBinaryTemplate(const cv::Mat &gray, int level)
+{
+    BinaryTemplate templ;
+    templ.width = gray.cols;
+    templ.height = gray.rows;
+    templ.wordsPerRow = (gray.cols + 63 + 63) / 64;
+    templ.shifted.assign(static_cast<size_t>(64) * gray.rows * templ.wordsPerRow, 0);
+    templ.masks.assign(static_cast<size_t>(64) * templ.wordsPerRow, 0);
+
+    for (int shift = 0; shift < 64; ++shift)
+    {
+        uint64_t *mask = templ.masks.data() + static_cast<size_t>(shift) * templ.wordsPerRow;
+        for (int x = 0; x < gray.cols; ++x)
+            mask[(x + shift) >> 6] |= uint64_t(1) << ((x + shift) & 63);
+
+        for (int y = 0; y < gray.rows; ++y)
+        {
+            const uint8_t *src = gray.ptr<uint8_t>(y);
+            uint64_t *dst = templ.shifted.data() + (static_cast<size_t>(shift) * gray.rows + y) * templ.wordsPerRow;
+            for (int x = 0; x < gray.cols; ++x)
+                if (src[x] > level)
+                    dst[(x + shift) >> 6] |= uint64_t(1) << ((x + shift) & 63);
+        }
+    }
+    return templ;
+}
+
+/**
+ * Hamming distance of the template placed at (x, y). Stops once the distance exceeds `maxDistance` and
+ * returns the partial count, which is then also above `maxDistance`.
+ */
+inline int BinaryDistanceAt(const BinaryImage &src, const BinaryTemplate &templ, int x, int y, int maxDistance)
+{
+    const int word = x >> 6;
+    const int shift = x & 63;
+    const uint64_t *mask = templ.Mask(shift);
+    int distance = 0;
+    for (int row = 0; row < templ.height; ++row)
+    {
+        distance += MaskedHammingDistance(src.Row(y + row) + word, templ.Row(shift, row), mask, templ.wordsPerRow);
+        if (distance > maxDistance)
+            break;
+    }
+    return distance;
+}
+
+/**
+ * Matches the binarized template over the binarized source and returns the matches passing `options.threshold`
+ * (a fraction of agreeing pixels), best first, with overlapping ones suppressed. Both images must be 8-bit gray.
+ * `stop` is checked before each row of positions; once it fires the remaining rows are skipped and OperationStopped
+ * is thrown.
+ */
+inline std::vector<Peak> BinaryMatchTemplate(const cv::Mat &srcGray, const cv::Mat &templGray, int level, const PeakOptions &options,
+                                             const StopCondition *stop = nullptr)
+{
+    CV_Assert(srcGray.type() == CV_8UC1 && templGray.type() == CV_8UC1);
+    if (templGray.cols > srcGray.cols || templGray.rows > srcGray.rows)
+        CV_Error(cv::Error::StsBadSize, "The template is larger than the image");
+
+    const BinaryImage src = PackBinary(srcGray, level);
+    const BinaryTemplate templ = PackBinaryTemplate(templGray, level);
+    const int area = templ.width * templ.height;
+    // Positions with more differing pixels than this can never reach the threshold
+    const int maxDistance = options.threshold <= 0 ? area : static_cast<int>((1.0 - options.threshold) * area);
+
+    cv::Mat scores(srcGray.rows - templGray.rows + 1, srcGray.cols - templGray.cols + 1, CV_32F);
+    cv::parallel_for_(cv::Range(0, scores.rows), [&](const cv::Range &range)
+                      {
+        for (int y = range.start; y < range.end; ++y)
+        {
+            if (stop && stop->ShouldStop())
+                return;
+            float *row = scores.ptr<float>(y);
+            for (int x = 0; x < scores.cols; ++x)
+            {
+                const int distance = BinaryDistanceAt(src, templ, x, y, maxDistance);
+                row[x] = distance > maxDistance ? 0.0f : 1.0f - static_cast<float>(distance) / area;
+            }
+        } });
+    if (stop)
+        stop->ThrowIfStopped();
+
+    return FindPeaks(scores, templGray.size(), options);
+}
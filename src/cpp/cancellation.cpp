@@ -0,0 +1,177 @@
+#include <napi.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <errors.h>
+#include <stopCondition.h>
+
+/**
+ * Reads `{ signal, timeout }` from an options object: an AbortSignal (or any object with an `aborted` flag) and a
+ * deadline in milliseconds from now. A signal that is already aborted stops the operation before it starts.
+ * Throws a TypeError and returns false on bad input.
+ */
+bool ParseStopOptions(Napi::Env env, const Napi::Object &optionsObj, StopCondition &stop)
+{
+    if (optionsObj.Has("timeout") && !optionsObj.Get("timeout").IsUndefined())
+    {
+        if (!optionsObj.Get("timeout").IsNumber() || optionsObj.Get("timeout").ToNumber().Int32Value() < 0)
+        {
+            Napi::TypeError::New(env, "'timeout' must be a non-negative number of milliseconds").ThrowAsJavaScriptException();
+            return false;
+        }
+        stop.SetTimeout(optionsObj.Get("timeout").ToNumber().Int32Value());
+    }
+
+    if (optionsObj.Has("signal") && !optionsObj.Get("signal").IsUndefined() && !optionsObj.Get("signal").IsNull())
+    {
+        Napi::Value signal = optionsObj.Get("signal");
+        if (!signal.IsObject() || !signal.As<Napi::Object>().Get("aborted").IsBoolean())
+        {
+            Napi::TypeError::New(env, "'signal' must be an AbortSignal").ThrowAsJavaScriptException();
+            return false;
+        }
+        stop.CancelFlag()->store(signal.As<Napi::Object>().Get("aborted").As<Napi::Boolean>().Value());
+    }
+    return true;
+}
+
+/**
+ * Reads stop options from info[index] if present. Throws a TypeError and returns false on bad input.
+ */
+bool ParseStopOptions(const Napi::CallbackInfo &info, size_t index, StopCondition &stop)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() <= index || info[index].IsUndefined() || info[index].IsNull())
+        return true;
+
+    if (!info[index].IsObject())
+    {
+        Napi::TypeError::New(env, "Options must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    return ParseStopOptions(env, info[index].As<Napi::Object>(), stop);
+}
+
+/**
+ * Sets the cancel flag of an async operation when its AbortSignal fires. A synchronous call blocks the event
+ * loop, so the signal cannot fire during it; only async operations listen.
+ */
+class AbortListener
+{
+public:
+    /**
+     * Starts listening to `options.signal`, if there is one with addEventListener. Returns null otherwise.
+     */
+    static std::unique_ptr<AbortListener> Attach(Napi::Env env, Napi::Value options, StopCondition &stop)
+    {
+        if (!options.IsObject())
+            return nullptr;
+        Napi::Value signal = options.As<Napi::Object>().Get("signal");
+        if (!signal.IsObject() || !signal.As<Napi::Object>().Get("addEventListener").IsFunction())
+            return nullptr;
+
+        std::shared_ptr<std::atomic<bool>> flag = stop.CancelFlag();
+        Napi::Function listener = Napi::Function::New(env, [flag](const Napi::CallbackInfo &)
+                                                      { flag->store(true); }, "onAbort");
+        signal.As<Napi::Object>().Get("addEventListener").As<Napi::Function>().Call(signal, {Napi::String::New(env, "abort"), listener});
+
+        std::unique_ptr<AbortListener> attached(new AbortListener());
+        attached->m_signal = Napi::Persistent(signal.As<Napi::Object>());
+        attached->m_listener = Napi::Persistent(listener);
+        return attached;
+    }
+
+    /**
+     * Stops listening, so a signal shared by many calls does not collect listeners. Must run on the JS thread.
+     */
+    void Detach()
+    {
+        if (m_signal.IsEmpty())
+            return;
+        Napi::Env env = m_signal.Env();
+        try
+        {
+            Napi::Object signal = m_signal.Value();
+            signal.Get("removeEventListener").As<Napi::Function>().Call(signal, {Napi::String::New(env, "abort"), m_listener.Value()});
+        }
+        catch (const Napi::Error &)
+        {
+            // The signal is the caller's object; a broken removeEventListener must not fail the operation
+        }
+        m_signal.Reset();
+        m_listener.Reset();
+    }
+
+private:
+    AbortListener() = default;
+
+    Napi::ObjectReference m_signal;
+    Napi::FunctionReference m_listener;
+};
+
+/**
+ * Runs a stoppable input operation (a drag, typed text) on a libuv worker thread and settles a Promise with true.
+ * These operations mostly sleep, so they run here rather than on the matching pool, where they would hold threads
+ * that tiles are waiting for.
+ */
+class StoppableWorker : public Napi::AsyncWorker
+{
+public:
+    using Work = std::function<void(const StopCondition &)>;
+
+    StoppableWorker(Napi::Env env, const char *name, const StopCondition &stop, Work work, std::unique_ptr<AbortListener> listener)
+        : Napi::AsyncWorker(env, name), m_deferred(Napi::Promise::Deferred::New(env)), m_stop(stop),
+          m_work(std::move(work)), m_listener(std::move(listener))
+    {
+    }
+
+    Napi::Promise Promise()
+    {
+        return m_deferred.Promise();
+    }
+
+protected:
+    void Execute() override
+    {
+        try
+        {
+            m_work(m_stop);
+        }
+        catch (const OperationStopped &e)
+        {
+            m_stopped.reset(new OperationStopped(e));
+        }
+        catch (const std::exception &e)
+        {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        if (m_listener)
+            m_listener->Detach();
+        if (m_stopped)
+            m_deferred.Reject(StoppedError(env, *m_stopped).Value());
+        else
+            m_deferred.Resolve(Napi::Boolean::New(env, true));
+    }
+
+    void OnError(const Napi::Error &e) override
+    {
+        if (m_listener)
+            m_listener->Detach();
+        m_deferred.Reject(e.Value());
+    }
+
+private:
+    Napi::Promise::Deferred m_deferred;
+    StopCondition m_stop;
+    Work m_work;
+    std::unique_ptr<AbortListener> m_listener;
+    std::unique_ptr<OperationStopped> m_stopped;
+};
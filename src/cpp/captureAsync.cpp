@@ -0,0 +1,119 @@
+#include <napi.h>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <frameSource.h>
+
+/**
+ * Captures one frame on a libuv worker thread and settles a Promise with it.
+ * Works either on an open shared source (CaptureSession.grabAsync) or opens the window itself (captureWindowAsync).
+ */
+class CaptureWorker : public Napi::AsyncWorker
+{
+public:
+    CaptureWorker(Napi::Env env, std::shared_ptr<SharedFrameSource> shared, const CaptureOptions &options)
+        : Napi::AsyncWorker(env, "CaptureWorker"), m_deferred(Napi::Promise::Deferred::New(env)),
+          m_shared(std::move(shared)), m_options(options)
+    {
+    }
+
+    CaptureWorker(Napi::Env env, const std::string &windowName, const CaptureOptions &options)
+        : Napi::AsyncWorker(env, "CaptureWorker"), m_deferred(Napi::Promise::Deferred::New(env)),
+          m_windowName(windowName), m_options(options)
+    {
+    }
+
+    Napi::Promise Promise()
+    {
+        return m_deferred.Promise();
+    }
+
+protected:
+    void Execute() override
+    {
+        try
+        {
+            std::shared_ptr<SharedFrameSource> shared = m_shared;
+            if (!shared)
+            {
+                std::unique_ptr<FrameSource> source = OpenWindowFrameSource(m_windowName);
+                if (!source)
+                {
+                    SetError("Window not found");
+                    return;
+                }
+                shared = std::make_shared<SharedFrameSource>(std::move(source));
+            }
+
+            std::vector<FrameView> views;
+            const SharedCaptureStatus status = CaptureShared(
+                *shared, [&](FrameSource &source)
+                { return AcquireCapture(source, m_options, views); },
+                [&]
+                {
+                    m_frames.resize(views.size());
+                    for (size_t i = 0; i < views.size(); ++i)
+                    {
+                        if (!ReadFrame(views[i], m_options, m_frames[i]))
+                            throw std::runtime_error(PNG_ENCODE_ERROR);
+                    } });
+            if (status == SharedCaptureStatus::Closed)
+                SetError("Capture session is closed");
+            else if (status == SharedCaptureStatus::TimedOut)
+                m_timedOut = true;
+        }
+        catch (const std::exception &e)
+        {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        if (m_timedOut)
+        {
+            m_deferred.Reject(CaptureTimeoutError(env, m_options.timeoutMs).Value());
+            return;
+        }
+        m_deferred.Resolve(CapturedFramesToValue(env, m_frames, m_options));
+    }
+
+    void OnError(const Napi::Error &error) override
+    {
+        m_deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred m_deferred;
+    std::shared_ptr<SharedFrameSource> m_shared;
+    std::string m_windowName;
+    CaptureOptions m_options;
+    std::vector<CapturedFrame> m_frames;
+    bool m_timedOut = false;
+};
+
+Napi::Value CaptureWindowAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Window name must be provided as a string").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string windowName = info[0].As<Napi::String>().Utf8Value();
+
+    // Same default as captureWindowN
+    CaptureOptions options;
+    options.format = CaptureFormat::Png;
+    if (!ParseCaptureOptions(info, 1, options))
+        return env.Null();
+
+    CaptureWorker *worker = new CaptureWorker(env, windowName, options);
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
@@ -0,0 +1,371 @@
+#include <napi.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <errors.h>
+#include <frameSource.h>
+
+/**
+ * What a capture hands back to JS: raw pixels in an ImageData-shaped object, or an encoded PNG buffer.
+ */
+enum class CaptureFormat
+{
+    Bgra,
+    Bgr,
+    Gray,
+    GrayHalf,
+    Png
+};
+
+struct CaptureOptions
+{
+    CaptureFormat format = CaptureFormat::Bgra;
+    int timeoutMs = DEFAULT_FRAME_TIMEOUT_MS;
+    // Parts of the frame to return instead of the whole frame
+    std::vector<FrameRect> regions;
+    // Whether the regions were given as a list (`regions`) and come back as an array
+    bool regionList = false;
+};
+
+/**
+ * Reads an [x, y, width, height] array. Returns false if it is not one.
+ */
+bool ParseFrameRect(Napi::Value value, FrameRect &rect)
+{
+    if (!value.IsArray())
+        return false;
+    Napi::Array array = value.As<Napi::Array>();
+    if (array.Length() < 4)
+        return false;
+    rect.x = array.Get((uint32_t)0).ToNumber().Int32Value();
+    rect.y = array.Get((uint32_t)1).ToNumber().Int32Value();
+    rect.width = array.Get((uint32_t)2).ToNumber().Int32Value();
+    rect.height = array.Get((uint32_t)3).ToNumber().Int32Value();
+    return true;
+}
+
+/**
+ * Reads `{ format, timeout, region, regions }` from info[index] if present. Throws a TypeError and returns false on bad input.
+ */
+bool ParseCaptureOptions(const Napi::CallbackInfo &info, size_t index, CaptureOptions &options)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() <= index || info[index].IsUndefined() || info[index].IsNull())
+        return true;
+
+    if (!info[index].IsObject())
+    {
+        Napi::TypeError::New(env, "Capture options must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object optionsObj = info[index].As<Napi::Object>();
+    if (optionsObj.Has("format") && !optionsObj.Get("format").IsUndefined())
+    {
+        std::string format = optionsObj.Get("format").ToString().Utf8Value();
+        if (format == "bgra")
+            options.format = CaptureFormat::Bgra;
+        else if (format == "bgr")
+            options.format = CaptureFormat::Bgr;
+        else if (format == "gray")
+            options.format = CaptureFormat::Gray;
+        else if (format == "gray_half")
+            options.format = CaptureFormat::GrayHalf;
+        else if (format == "png")
+            options.format = CaptureFormat::Png;
+        else
+        {
+            Napi::TypeError::New(env, "Invalid capture format. Expected: 'bgra', 'bgr', 'gray', 'gray_half' or 'png'").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    if (optionsObj.Has("timeout") && !optionsObj.Get("timeout").IsUndefined())
+    {
+        if (!optionsObj.Get("timeout").IsNumber() || optionsObj.Get("timeout").ToNumber().Int32Value() < 0)
+        {
+            Napi::TypeError::New(env, "Capture timeout must be a non-negative number of milliseconds").ThrowAsJavaScriptException();
+            return false;
+        }
+        options.timeoutMs = optionsObj.Get("timeout").ToNumber().Int32Value();
+    }
+
+    if (optionsObj.Has("region") && !optionsObj.Get("region").IsUndefined())
+    {
+        FrameRect region;
+        if (!ParseFrameRect(optionsObj.Get("region"), region))
+        {
+            Napi::TypeError::New(env, "Invalid capture region. Expected: [x, y, width, height]").ThrowAsJavaScriptException();
+            return false;
+        }
+        options.regions.push_back(region);
+    }
+    else if (optionsObj.Has("regions") && !optionsObj.Get("regions").IsUndefined())
+    {
+        if (!optionsObj.Get("regions").IsArray())
+        {
+            Napi::TypeError::New(env, "Capture regions must be an array of [x, y, width, height]").ThrowAsJavaScriptException();
+            return false;
+        }
+        Napi::Array regions = optionsObj.Get("regions").As<Napi::Array>();
+        for (uint32_t i = 0; i < regions.Length(); ++i)
+        {
+            FrameRect region;
+            if (!ParseFrameRect(regions.Get(i), region))
+            {
+                Napi::TypeError::New(env, "Invalid capture region. Expected: [x, y, width, height]").ThrowAsJavaScriptException();
+                return false;
+            }
+            options.regions.push_back(region);
+        }
+        if (options.regions.empty())
+        {
+            Napi::TypeError::New(env, "Capture regions must not be empty").ThrowAsJavaScriptException();
+            return false;
+        }
+        options.regionList = true;
+    }
+
+    return true;
+}
+
+/**
+ * Size and channel count of a frame once converted to a raw `format`.
+ */
+struct PixelLayout
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+};
+
+PixelLayout RawLayout(const FrameView &frame, CaptureFormat format)
+{
+    switch (format)
+    {
+    case CaptureFormat::Bgr:
+        return {frame.width, frame.height, 3};
+    case CaptureFormat::Gray:
+        return {frame.width, frame.height, 1};
+    case CaptureFormat::GrayHalf:
+        return {frame.width / 2, frame.height / 2, 1};
+    default:
+        return {frame.width, frame.height, 4};
+    }
+}
+
+/**
+ * Converts a mapped frame to a raw `format` into a tightly packed buffer sized by RawLayout().
+ */
+void ConvertFrame(const FrameView &frame, CaptureFormat format, uint8_t *dst)
+{
+    if (format == CaptureFormat::GrayHalf)
+        CopyFrameHalfGray(frame, dst);
+    else
+        CopyFrame(frame, RawLayout(frame, format).channels, dst);
+}
+
+/**
+ * Acquires the whole frame, or only the regions requested in `options`, from one frame of `source`.
+ * Returns false on timeout or when the source is closed.
+ */
+bool AcquireCapture(FrameSource &source, const CaptureOptions &options, std::vector<FrameView> &views)
+{
+    if (options.regions.empty())
+    {
+        views.resize(1);
+        return source.AcquireFrame(views[0], options.timeoutMs);
+    }
+    return source.AcquireRegions(options.regions, views, options.timeoutMs);
+}
+
+// Same message on the sync and async paths
+const char *const PNG_ENCODE_ERROR = "Failed to encode the frame as PNG";
+
+/**
+ * Turns a mapped frame into the JS value requested by `options`.
+ * Raw formats are written straight from the frame into the returned ArrayBuffer without an intermediate copy.
+ * Throws std::runtime_error if PNG encoding fails.
+ */
+Napi::Value FrameToValue(Napi::Env env, const FrameView &frame, const CaptureOptions &options)
+{
+    if (options.format == CaptureFormat::Png)
+    {
+        std::vector<uchar> encodedImage;
+        if (!EncodeFramePng(frame, encodedImage))
+            throw std::runtime_error(PNG_ENCODE_ERROR);
+        return Napi::Buffer<uchar>::Copy(env, encodedImage.data(), encodedImage.size());
+    }
+
+    PixelLayout layout = RawLayout(frame, options.format);
+    size_t totalBytes = static_cast<size_t>(layout.width) * layout.height * layout.channels;
+    Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, totalBytes);
+    ConvertFrame(frame, options.format, static_cast<uint8_t *>(arrayBuffer.Data()));
+    return NewImageData(env, layout.width, layout.height, layout.channels, Napi::Uint8Array::New(env, totalBytes, arrayBuffer, 0));
+}
+
+/**
+ * Turns the views from AcquireCapture() into one value, or into an array when a list of regions was requested.
+ */
+Napi::Value CaptureToValue(Napi::Env env, const std::vector<FrameView> &views, const CaptureOptions &options)
+{
+    if (!options.regionList)
+        return FrameToValue(env, views[0], options);
+
+    Napi::Array result = Napi::Array::New(env, views.size());
+    for (size_t i = 0; i < views.size(); ++i)
+        result.Set(static_cast<uint32_t>(i), FrameToValue(env, views[i], options));
+    return result;
+}
+
+/**
+ * A frame copied out of its source, so it can be produced on a worker thread and handed to JS later.
+ */
+struct CapturedFrame
+{
+    CaptureFormat format = CaptureFormat::Bgra;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * Copies or encodes a mapped frame into `captured`. Safe to call off the JS thread.
+ * Returns false if PNG encoding failed.
+ */
+bool ReadFrame(const FrameView &frame, const CaptureOptions &options, CapturedFrame &captured)
+{
+    captured.format = options.format;
+
+    if (options.format == CaptureFormat::Png)
+    {
+        captured.width = frame.width;
+        captured.height = frame.height;
+        captured.channels = frame.channels;
+        return EncodeFramePng(frame, captured.data);
+    }
+
+    PixelLayout layout = RawLayout(frame, options.format);
+    captured.width = layout.width;
+    captured.height = layout.height;
+    captured.channels = layout.channels;
+    captured.data.resize(static_cast<size_t>(layout.width) * layout.height * layout.channels);
+    ConvertFrame(frame, options.format, captured.data.data());
+    return true;
+}
+
+/**
+ * Copies tightly packed pixels into a new ImageData-shaped object.
+ */
+Napi::Object PixelsToImageData(Napi::Env env, const uint8_t *pixels, int width, int height, int channels)
+{
+    size_t totalBytes = static_cast<size_t>(width) * height * channels;
+    Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, totalBytes);
+    memcpy(arrayBuffer.Data(), pixels, totalBytes);
+    return NewImageData(env, width, height, channels, Napi::Uint8Array::New(env, totalBytes, arrayBuffer, 0));
+}
+
+/**
+ * Hands a frame read on a worker thread to JS. Raw pixels are moved into the returned object, not copied.
+ */
+Napi::Value CapturedFrameToValue(Napi::Env env, CapturedFrame &captured)
+{
+    if (captured.format == CaptureFormat::Png)
+        return Napi::Buffer<uchar>::Copy(env, captured.data.data(), captured.data.size());
+
+    return VectorToImageData(env, std::move(captured.data), captured.width, captured.height, captured.channels);
+}
+
+/**
+ * Same shape as CaptureToValue(), for frames read on a worker thread.
+ */
+Napi::Value CapturedFramesToValue(Napi::Env env, std::vector<CapturedFrame> &captured, const CaptureOptions &options)
+{
+    if (!options.regionList)
+        return CapturedFrameToValue(env, captured[0]);
+
+    Napi::Array result = Napi::Array::New(env, captured.size());
+    for (size_t i = 0; i < captured.size(); ++i)
+        result.Set(static_cast<uint32_t>(i), CapturedFrameToValue(env, captured[i]));
+    return result;
+}
+
+/**
+ * Opens a frame source for a window name, or for an ImageData that is replayed as the only frame.
+ * `{ width, height, channels }` without `data` opens an in-memory source with no frame yet; frames are pushed later.
+ * Throws a JS exception and returns nullptr on failure.
+ */
+std::unique_ptr<FrameSource> OpenFrameSource(Napi::Env env, Napi::Value value, int bufferCount = 2)
+{
+    if (value.IsString())
+    {
+        std::string windowName = value.As<Napi::String>().Utf8Value();
+        std::unique_ptr<FrameSource> source;
+        try
+        {
+            source = OpenWindowFrameSource(windowName, bufferCount);
+        }
+        catch (const std::runtime_error &e)
+        {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return nullptr;
+        }
+
+        if (!source)
+        {
+            Napi::TypeError::New(env, "Window not found").ThrowAsJavaScriptException();
+            return nullptr;
+        }
+        return source;
+    }
+
+    if (!value.IsObject())
+    {
+        Napi::TypeError::New(env, "Window name or image data must be provided").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+
+    Napi::Object imageData = value.As<Napi::Object>();
+    if (imageData.Has("width") && imageData.Has("height") && (!imageData.Has("data") || imageData.Get("data").IsUndefined()))
+    {
+        int width = imageData.Get("width").ToNumber().Int32Value();
+        int height = imageData.Get("height").ToNumber().Int32Value();
+        int channels = imageData.Has("channels") && !imageData.Get("channels").IsUndefined() ? imageData.Get("channels").ToNumber().Int32Value() : 4;
+        if (width <= 0 || height <= 0 || !SupportedFrameChannels(channels))
+        {
+            Napi::TypeError::New(env, "Invalid image size").ThrowAsJavaScriptException();
+            return nullptr;
+        }
+        return std::make_unique<MemoryFrameSource>(width, height, channels);
+    }
+
+    if (!imageData.Has("width") || !imageData.Has("height") || !imageData.Has("data") || !imageData.Get("data").IsTypedArray())
+    {
+        Napi::TypeError::New(env, "Invalid image data object. Expected properties: 'width', 'height', 'data'").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+
+    int width = imageData.Get("width").ToNumber().Int32Value();
+    int height = imageData.Get("height").ToNumber().Int32Value();
+    Napi::TypedArray typedArray = imageData.Get("data").As<Napi::TypedArray>();
+    if (width <= 0 || height <= 0)
+    {
+        Napi::TypeError::New(env, "Invalid image size").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+
+    const size_t pixels = static_cast<size_t>(width) * height;
+    int channels = static_cast<int>(typedArray.ByteLength() / pixels);
+    if (!SupportedFrameChannels(channels) || typedArray.ByteLength() != pixels * channels)
+    {
+        Napi::TypeError::New(env, "Image data size does not match its width and height").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+
+    auto source = std::make_unique<MemoryFrameSource>(width, height, channels);
+    const uint8_t *data = static_cast<const uint8_t *>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+    source->PushFrame(data, static_cast<size_t>(width) * channels);
+    return source;
+}
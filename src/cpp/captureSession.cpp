@@ -0,0 +1,173 @@
+#include <napi.h>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <frameSource.h>
+
+/**
+ * JS object that keeps a capture open between grabs.
+ * Created either from a window name or from an ImageData, which is replayed through an in-memory frame source.
+ * In-memory sessions take further frames through push().
+ */
+class CaptureSession : public Napi::ObjectWrap<CaptureSession>
+{
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports)
+    {
+        Napi::Function func = DefineClass(env, "CaptureSession",
+                                          {InstanceMethod("grab", &CaptureSession::Grab),
+                                           InstanceMethod("grabAsync", &CaptureSession::GrabAsync),
+                                           InstanceMethod("push", &CaptureSession::Push),
+                                           InstanceMethod("close", &CaptureSession::Close),
+                                           InstanceAccessor("closed", &CaptureSession::IsClosed, nullptr)});
+        exports.Set("CaptureSession", func);
+        return exports;
+    }
+
+    CaptureSession(const Napi::CallbackInfo &info) : Napi::ObjectWrap<CaptureSession>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Window name or image data must be provided").ThrowAsJavaScriptException();
+            return;
+        }
+
+        std::unique_ptr<FrameSource> source = OpenFrameSource(env, info[0]);
+        if (!source)
+            return;
+        // OpenFrameSource() opens an in-memory source for everything but a window name
+        if (!info[0].IsString())
+            m_memory = static_cast<MemoryFrameSource *>(source.get());
+        m_shared = std::make_shared<SharedFrameSource>(std::move(source));
+    }
+
+private:
+    Napi::Value Grab(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (!m_shared || m_shared->source->IsClosed())
+        {
+            Napi::Error::New(env, "Capture session is closed").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        CaptureOptions options;
+        if (!ParseCaptureOptions(info, 0, options))
+            return env.Null();
+
+        try
+        {
+            // grab() runs on the JS thread, so it must not sit behind a grabAsync() waiting for a frame
+            std::vector<FrameView> views;
+            Napi::Value result;
+            const SharedCaptureStatus status = CaptureShared(
+                *m_shared, [&](FrameSource &source)
+                { return AcquireCapture(source, options, views); },
+                [&]
+                { result = CaptureToValue(env, views, options); },
+                false);
+            if (status == SharedCaptureStatus::Busy)
+            {
+                Napi::Error::New(env, "Capture session is busy with a grabAsync()").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            if (status == SharedCaptureStatus::Closed)
+            {
+                Napi::Error::New(env, "Capture session is closed").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            if (status == SharedCaptureStatus::TimedOut)
+            {
+                CaptureTimeoutError(env, options.timeoutMs).ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            return result;
+        }
+        catch (const cv::Exception &e)
+        {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        catch (const std::runtime_error &e)
+        {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    Napi::Value GrabAsync(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (!m_shared || m_shared->source->IsClosed())
+        {
+            Napi::Error::New(env, "Capture session is closed").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        CaptureOptions options;
+        if (!ParseCaptureOptions(info, 0, options))
+            return env.Null();
+
+        CaptureWorker *worker = new CaptureWorker(env, m_shared, options);
+        Napi::Promise promise = worker->Promise();
+        worker->Queue();
+        return promise;
+    }
+
+    /**
+     * Queues an ImageData as the next frame of an in-memory session. It must match the session's size and channels.
+     */
+    Napi::Value Push(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (!m_memory)
+        {
+            Napi::Error::New(env, "Only sessions created from image data accept pushed frames").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        if (info.Length() < 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("data").IsTypedArray())
+        {
+            Napi::TypeError::New(env, "Image data must be provided").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        Napi::Object imageData = info[0].As<Napi::Object>();
+        Napi::TypedArray typedArray = imageData.Get("data").As<Napi::TypedArray>();
+        const size_t rowBytes = static_cast<size_t>(m_memory->Width()) * m_memory->Channels();
+        if (imageData.Get("width").ToNumber().Int32Value() != m_memory->Width() ||
+            imageData.Get("height").ToNumber().Int32Value() != m_memory->Height() ||
+            typedArray.ByteLength() != rowBytes * m_memory->Height())
+        {
+            Napi::TypeError::New(env, "Image data does not match the session's size and channels").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        // Not under the shared mutex: a pending grab holds it while it waits for this frame
+        const uint8_t *data = static_cast<const uint8_t *>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+        m_memory->PushFrame(data, rowBytes);
+        return env.Undefined();
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo &info)
+    {
+        // Not under the mutex: closing wakes up a worker that is waiting for a frame
+        if (m_shared)
+            m_shared->source->Close();
+        return info.Env().Undefined();
+    }
+
+    Napi::Value IsClosed(const Napi::CallbackInfo &info)
+    {
+        return Napi::Boolean::New(info.Env(), !m_shared || m_shared->source->IsClosed());
+    }
+
+    std::shared_ptr<SharedFrameSource> m_shared;
+    // The source of m_shared when it is in memory, otherwise null
+    MemoryFrameSource *m_memory = nullptr;
+};
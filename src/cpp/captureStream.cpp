@@ -0,0 +1,268 @@
+#include <napi.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <frameRing.h>
+#include <frameSource.h>
+
+// How long the stream thread waits for a frame before checking whether it was stopped
+const int STREAM_POLL_MS = 250;
+
+/**
+ * Continuous capture into a FrameRing on a dedicated thread.
+ * JS either pulls the newest frame with read() or gets every queued frame through the callback passed at construction.
+ */
+class CaptureStream : public Napi::ObjectWrap<CaptureStream>
+{
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports)
+    {
+        Napi::Function func = DefineClass(env, "CaptureStream",
+                                          {InstanceMethod("read", &CaptureStream::Read),
+                                           InstanceMethod("stats", &CaptureStream::GetStats),
+                                           InstanceMethod("stop", &CaptureStream::StopStream),
+                                           InstanceAccessor("running", &CaptureStream::IsRunning, nullptr)});
+        exports.Set("CaptureStream", func);
+        return exports;
+    }
+
+    CaptureStream(const Napi::CallbackInfo &info) : Napi::ObjectWrap<CaptureStream>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Window name or image data must be provided").ThrowAsJavaScriptException();
+            return;
+        }
+
+        CaptureOptions options;
+        if (!ParseCaptureOptions(info, 1, options))
+            return;
+        if (options.format == CaptureFormat::Png)
+        {
+            Napi::TypeError::New(env, "Capture streams only support raw formats, not 'png'").ThrowAsJavaScriptException();
+            return;
+        }
+        if (options.regionList)
+        {
+            Napi::TypeError::New(env, "Capture streams support a single 'region', not a list").ThrowAsJavaScriptException();
+            return;
+        }
+        m_format = options.format;
+        m_regions = options.regions;
+
+        size_t maxQueued = 2;
+        if (info.Length() > 1 && info[1].IsObject())
+        {
+            Napi::Object optionsObj = info[1].As<Napi::Object>();
+            if (optionsObj.Has("fps") && !optionsObj.Get("fps").IsUndefined())
+            {
+                m_fps = optionsObj.Get("fps").ToNumber().DoubleValue();
+                if (!(m_fps >= 0))
+                {
+                    Napi::TypeError::New(env, "'fps' must be a non-negative number").ThrowAsJavaScriptException();
+                    return;
+                }
+            }
+            if (optionsObj.Has("maxQueued") && !optionsObj.Get("maxQueued").IsUndefined())
+            {
+                int value = optionsObj.Get("maxQueued").ToNumber().Int32Value();
+                if (value < 1)
+                {
+                    Napi::TypeError::New(env, "'maxQueued' must be at least 1").ThrowAsJavaScriptException();
+                    return;
+                }
+                maxQueued = static_cast<size_t>(value);
+            }
+        }
+
+        if (info.Length() > 2 && !info[2].IsUndefined())
+        {
+            if (!info[2].IsFunction())
+            {
+                Napi::TypeError::New(env, "Frame callback must be a function").ThrowAsJavaScriptException();
+                return;
+            }
+
+            // The stream stays alive until the last queued callback has run
+            Ref();
+            m_onFrame = Napi::ThreadSafeFunction::New(
+                env,
+                info[2].As<Napi::Function>(),
+                "CaptureStreamCallback",
+                0,
+                1,
+                [this](Napi::Env)
+                { Unref(); });
+            m_hasCallback = true;
+        }
+
+        // One extra buffer lets the capture keep producing while the stream thread copies a frame out
+        m_source = OpenFrameSource(env, info[0], 3);
+        if (!m_source)
+        {
+            if (m_hasCallback)
+                m_onFrame.Release();
+            m_hasCallback = false;
+            return;
+        }
+
+        m_ring = std::make_unique<FrameRing>(maxQueued);
+        m_running = true;
+        m_thread = std::thread(&CaptureStream::Run, this);
+    }
+
+    ~CaptureStream()
+    {
+        Stop();
+    }
+
+private:
+    void Run()
+    {
+        const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(m_fps > 0 ? 1.0 / m_fps : 0.0));
+        auto nextDue = std::chrono::steady_clock::now();
+        uint64_t lastSequence = 0;
+
+        while (m_running)
+        {
+            FrameView frame;
+            try
+            {
+                if (!AcquireStreamFrame(frame, lastSequence))
+                {
+                    if (m_source->IsClosed())
+                        break;
+                    continue;
+                }
+            }
+            catch (const std::exception &)
+            {
+                break;
+            }
+            lastSequence = frame.sequence;
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now < nextDue)
+            {
+                m_source->ReleaseFrame();
+                m_ring->CountSkipped();
+                continue;
+            }
+            nextDue = std::max(nextDue + interval, now);
+
+            PixelLayout layout = RawLayout(frame, m_format);
+            FrameSlot *slot = m_ring->BeginWrite(layout.width, layout.height, layout.channels);
+            try
+            {
+                ConvertFrame(frame, m_format, slot->data.data());
+            }
+            catch (const std::exception &)
+            {
+                m_source->ReleaseFrame();
+                break;
+            }
+            m_source->ReleaseFrame();
+            m_ring->CommitWrite(slot, frame.sequence);
+
+            // One wakeup drains everything that queued up since the previous one
+            if (m_hasCallback && !m_notifyPending.exchange(true))
+            {
+                m_onFrame.NonBlockingCall([this](Napi::Env env, Napi::Function jsCallback)
+                                          { Drain(env, jsCallback); });
+            }
+        }
+        m_running = false;
+    }
+
+    bool AcquireStreamFrame(FrameView &frame, uint64_t after)
+    {
+        if (m_regions.empty())
+            return m_source->AcquireFrame(frame, STREAM_POLL_MS, after);
+
+        if (!m_source->AcquireRegions(m_regions, m_regionViews, STREAM_POLL_MS, after))
+            return false;
+        frame = m_regionViews[0];
+        return true;
+    }
+
+    void Drain(Napi::Env env, Napi::Function jsCallback)
+    {
+        m_notifyPending = false;
+        while (FrameSlot *slot = m_ring->BeginReadNext())
+        {
+            Napi::Object frame = PixelsToImageData(env, slot->data.data(), slot->width, slot->height, slot->channels);
+            m_ring->EndRead(slot);
+            jsCallback.Call({frame});
+        }
+    }
+
+    void Stop()
+    {
+        m_running = false;
+        if (m_source)
+            m_source->Close();
+        if (m_thread.joinable())
+            m_thread.join();
+        if (m_hasCallback)
+        {
+            m_hasCallback = false;
+            m_onFrame.Release();
+        }
+    }
+
+    Napi::Value Read(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        if (!m_ring)
+            return env.Null();
+
+        FrameSlot *slot = m_ring->BeginReadLatest();
+        if (!slot)
+            return env.Null();
+
+        Napi::Object frame = PixelsToImageData(env, slot->data.data(), slot->width, slot->height, slot->channels);
+        m_ring->EndRead(slot);
+        return frame;
+    }
+
+    Napi::Value GetStats(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        FrameRingStats stats = m_ring ? m_ring->Stats() : FrameRingStats();
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("delivered", Napi::Number::New(env, static_cast<double>(stats.delivered)));
+        result.Set("dropped", Napi::Number::New(env, static_cast<double>(stats.dropped)));
+        result.Set("skipped", Napi::Number::New(env, static_cast<double>(stats.skipped)));
+        result.Set("queued", Napi::Number::New(env, static_cast<double>(stats.queued)));
+        return result;
+    }
+
+    Napi::Value StopStream(const Napi::CallbackInfo &info)
+    {
+        Stop();
+        return info.Env().Undefined();
+    }
+
+    Napi::Value IsRunning(const Napi::CallbackInfo &info)
+    {
+        return Napi::Boolean::New(info.Env(), m_running);
+    }
+
+    std::unique_ptr<FrameSource> m_source;
+    std::unique_ptr<FrameRing> m_ring;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_notifyPending{false};
+    Napi::ThreadSafeFunction m_onFrame;
+    bool m_hasCallback = false;
+    CaptureFormat m_format = CaptureFormat::Bgra;
+    std::vector<FrameRect> m_regions;
+    std::vector<FrameView> m_regionViews;
+    double m_fps = 0;
+};
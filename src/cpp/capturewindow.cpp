@@ -1,5 +1,12 @@
 #include <napi.h>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <Windows.h>
 #include <dxgi.h>
 #include <inspectable.h>
@@ -15,159 +22,365 @@
 #include <dwmapi.h>
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
+#include <frameSource.h>
 
 #pragma comment(lib, "Dwmapi.lib")
 #pragma comment(lib, "windowsapp.lib")
 
-Napi::Value CaptureWindow(const Napi::CallbackInfo &info)
+struct __declspec(uuid("A9B3D012-3DF2-4EE3-B8D1-8695F457D3C1"))
+    IDirect3DDxgiInterfaceAccess : ::IUnknown
 {
-    Napi::Env env = info.Env();
+    virtual HRESULT __stdcall GetInterface(GUID const &id, void **object) = 0;
+};
 
-    if (info.Length() < 1 || !info[0].IsString())
+// Joins the calling thread to the multithreaded apartment; threads already in an STA keep it
+static void EnsureApartment()
+{
+    try
     {
-        Napi::TypeError::New(env, "Window name must be provided as a string").ThrowAsJavaScriptException();
-        return env.Null();
+        winrt::init_apartment(winrt::apartment_type::multi_threaded);
     }
+    catch (const winrt::hresult_error &e)
+    {
+        if (e.code() != RPC_E_CHANGED_MODE)
+            throw;
+    }
+}
 
-    std::string windowName = info[0].As<Napi::String>().Utf8Value();
-    HWND hwndTarget = FindWindowA(NULL, windowName.c_str());
-    if (!hwndTarget)
+/**
+ * Window capture through Windows Graphics Capture.
+ * The D3D device, frame pool, capture session and staging texture are created once and reused for every frame.
+ * The frame pool is free-threaded, so frames arrive without a message pump and the source can be read from any thread.
+ */
+class WindowFrameSource : public FrameSource
+{
+public:
+    WindowFrameSource(HWND hwndTarget, int bufferCount) : m_bufferCount(bufferCount)
     {
-        Napi::TypeError::New(env, "Window not found").ThrowAsJavaScriptException();
-        return env.Null();
+        // Init COM
+        EnsureApartment();
+
+        // Create Direct 3D Device
+        winrt::check_hresult(D3D11CreateDevice(
+            nullptr,
+            D3D_DRIVER_TYPE_HARDWARE,
+            nullptr,
+            D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+            nullptr,
+            0,
+            D3D11_SDK_VERSION,
+            m_d3dDevice.put(),
+            nullptr,
+            nullptr));
+
+        const auto dxgiDevice = m_d3dDevice.as<IDXGIDevice>();
+        {
+            winrt::com_ptr<::IInspectable> inspectable;
+            winrt::check_hresult(CreateDirect3D11DeviceFromDXGIDevice(dxgiDevice.get(), inspectable.put()));
+            m_device = inspectable.as<winrt::Windows::Graphics::DirectX::Direct3D11::IDirect3DDevice>();
+        }
+
+        m_d3dDevice->GetImmediateContext(m_d3dContext.put());
+
+        RECT rect{};
+        DwmGetWindowAttribute(hwndTarget, DWMWA_EXTENDED_FRAME_BOUNDS, &rect, sizeof(RECT));
+        m_poolSize = winrt::Windows::Graphics::SizeInt32{rect.right - rect.left, rect.bottom - rect.top};
+
+        m_framePool = winrt::Windows::Graphics::Capture::Direct3D11CaptureFramePool::CreateFreeThreaded(
+            m_device,
+            winrt::Windows::Graphics::DirectX::DirectXPixelFormat::B8G8R8A8UIntNormalized,
+            m_bufferCount,
+            m_poolSize);
+
+        const auto activationFactory = winrt::get_activation_factory<
+            winrt::Windows::Graphics::Capture::GraphicsCaptureItem>();
+        auto interopFactory = activationFactory.as<IGraphicsCaptureItemInterop>();
+        winrt::check_hresult(interopFactory->CreateForWindow(hwndTarget, winrt::guid_of<ABI::Windows::Graphics::Capture::IGraphicsCaptureItem>(),
+                                                             reinterpret_cast<void **>(winrt::put_abi(m_captureItem))));
+
+        m_session = m_framePool.CreateCaptureSession(m_captureItem);
+        m_callbackGate = std::make_shared<CallbackGate>();
+        m_callbackGate->source = this;
+        // The handler holds the gate, not the source, so a callback that fires while the source is being destroyed
+        // finds the source gone instead of touching freed memory
+        std::shared_ptr<CallbackGate> gate = m_callbackGate;
+        m_frameArrivedToken = m_framePool.FrameArrived([gate](auto &framePool, auto &)
+                                                       {
+            std::lock_guard<std::mutex> lock(gate->mutex);
+            if (gate->source)
+                gate->source->OnFrameArrived(framePool); });
+
+        m_session.IsCursorCaptureEnabled(false);
+        m_session.StartCapture();
     }
 
-    // Init COM
-    winrt::init_apartment(winrt::apartment_type::single_threaded);
+    ~WindowFrameSource() override
+    {
+        ReleaseFrame();
+        Close();
+    }
 
-    // Create Direct 3D Device
-    winrt::com_ptr<ID3D11Device> d3dDevice;
-    winrt::check_hresult(D3D11CreateDevice(
-        nullptr,
-        D3D_DRIVER_TYPE_HARDWARE,
-        nullptr,
-        D3D11_CREATE_DEVICE_BGRA_SUPPORT,
-        nullptr,
-        0,
-        D3D11_SDK_VERSION,
-        d3dDevice.put(),
-        nullptr,
-        nullptr));
+    bool AcquireFrame(FrameView &frame, int timeoutMs, uint64_t after = 0) override
+    {
+        std::vector<FrameView> views;
+        if (!ReadBack({}, views, timeoutMs, after))
+            return false;
+        frame = views[0];
+        return true;
+    }
 
-    winrt::Windows::Graphics::DirectX::Direct3D11::IDirect3DDevice device;
-    const auto dxgiDevice = d3dDevice.as<IDXGIDevice>();
+    bool AcquireRegions(const std::vector<FrameRect> &regions, std::vector<FrameView> &views, int timeoutMs, uint64_t after = 0) override
     {
-        winrt::com_ptr<::IInspectable> inspectable;
-        winrt::check_hresult(CreateDirect3D11DeviceFromDXGIDevice(dxgiDevice.get(), inspectable.put()));
-        device = inspectable.as<winrt::Windows::Graphics::DirectX::Direct3D11::IDirect3DDevice>();
+        return ReadBack(regions, views, timeoutMs, after);
     }
 
-    auto idxgiDevice2 = dxgiDevice.as<IDXGIDevice2>();
-    winrt::com_ptr<IDXGIAdapter> adapter;
-    winrt::check_hresult(idxgiDevice2->GetParent(winrt::guid_of<IDXGIAdapter>(), adapter.put_void()));
-    winrt::com_ptr<IDXGIFactory2> factory;
-    winrt::check_hresult(adapter->GetParent(winrt::guid_of<IDXGIFactory2>(), factory.put_void()));
+    void ReleaseFrame() override
+    {
+        if (!m_mapped)
+            return;
+        m_d3dContext->Unmap(m_stagingTexture.get(), 0);
+        m_mapped = false;
+    }
 
-    ID3D11DeviceContext *d3dContext = nullptr;
-    d3dDevice->GetImmediateContext(&d3dContext);
+    void Close() override
+    {
+        if (m_closed.exchange(true))
+            return;
+        {
+            // Waits for a FrameArrived callback that is already running, and keeps later ones out. The pool is closed
+            // after the gate is released, so a callback blocked on the gate cannot hold up the close
+            std::lock_guard<std::mutex> lock(m_callbackGate->mutex);
+            m_callbackGate->source = nullptr;
+        }
+        if (m_framePool)
+            m_framePool.FrameArrived(m_frameArrivedToken);
+        if (m_session)
+            m_session.Close();
+        if (m_framePool)
+            m_framePool.Close();
+        {
+            std::lock_guard<std::mutex> lock(m_frameMutex);
+            m_latestTexture = nullptr;
+            m_latestFrame = nullptr;
+        }
+        m_frameArrived.notify_all();
+    }
 
-    RECT rect{};
-    DwmGetWindowAttribute(hwndTarget, DWMWA_EXTENDED_FRAME_BOUNDS, &rect, sizeof(RECT));
-    const auto size = winrt::Windows::Graphics::SizeInt32{rect.right - rect.left, rect.bottom - rect.top};
+    bool IsClosed() const override
+    {
+        return m_closed;
+    }
 
-    winrt::Windows::Graphics::Capture::Direct3D11CaptureFramePool m_framePool =
-        winrt::Windows::Graphics::Capture::Direct3D11CaptureFramePool::Create(
-            device,
-            winrt::Windows::Graphics::DirectX::DirectXPixelFormat::B8G8R8A8UIntNormalized,
-            2,
-            size);
-
-    const auto activationFactory = winrt::get_activation_factory<
-        winrt::Windows::Graphics::Capture::GraphicsCaptureItem>();
-    auto interopFactory = activationFactory.as<IGraphicsCaptureItemInterop>();
-    winrt::Windows::Graphics::Capture::GraphicsCaptureItem captureItem = {nullptr};
-    interopFactory->CreateForWindow(hwndTarget, winrt::guid_of<ABI::Windows::Graphics::Capture::IGraphicsCaptureItem>(),
-                                    reinterpret_cast<void **>(winrt::put_abi(captureItem)));
-
-    auto isFrameArrived = false;
-    winrt::com_ptr<ID3D11Texture2D> texture;
-    const auto session = m_framePool.CreateCaptureSession(captureItem);
-    m_framePool.FrameArrived([&](auto &framePool, auto &)
-                             {
-        if (isFrameArrived) return;
-        auto frame = framePool.TryGetNextFrame();
+private:
+    /**
+     * Shared between the source and its FrameArrived handler. `source` is cleared by Close() under `mutex`, which
+     * callbacks hold while they run.
+     */
+    struct CallbackGate
+    {
+        std::mutex mutex;
+        WindowFrameSource *source = nullptr;
+    };
 
-        struct __declspec(uuid("A9B3D012-3DF2-4EE3-B8D1-8695F457D3C1"))
-            IDirect3DDxgiInterfaceAccess : ::IUnknown
-        {
-            virtual HRESULT __stdcall GetInterface(GUID const& id, void** object) = 0;
-        };
+    // Runs on a frame pool thread with the callback gate held, so Close() cannot run at the same time
+    void OnFrameArrived(winrt::Windows::Graphics::Capture::Direct3D11CaptureFramePool const &framePool)
+    {
+        auto frame = framePool.TryGetNextFrame();
+        if (!frame)
+            return;
 
+        winrt::com_ptr<ID3D11Texture2D> texture;
         auto access = frame.Surface().as<IDirect3DDxgiInterfaceAccess>();
         access->GetInterface(winrt::guid_of<ID3D11Texture2D>(), texture.put_void());
-        isFrameArrived = true; });
 
-    session.IsCursorCaptureEnabled(false);
-    session.StartCapture();
+        // Keep the frame alive until the next one replaces it so its surface stays valid
+        {
+            std::lock_guard<std::mutex> lock(m_frameMutex);
+            m_latestFrame = frame;
+            m_latestTexture = texture;
+            ++m_latestSequence;
+        }
+        m_frameArrived.notify_all();
+
+        const auto contentSize = frame.ContentSize();
+        if (contentSize.Width != m_poolSize.Width || contentSize.Height != m_poolSize.Height)
+        {
+            m_poolSize = contentSize;
+            m_framePool.Recreate(
+                m_device,
+                winrt::Windows::Graphics::DirectX::DirectXPixelFormat::B8G8R8A8UIntNormalized,
+                m_bufferCount,
+                m_poolSize);
+        }
+    }
 
-    // Message pump
-    MSG msg;
-    clock_t timer = clock();
-    while (!isFrameArrived)
+    /**
+     * Waits for a frame newer than `after`, copies `regions` of it (or all of it) into the staging texture and maps it.
+     */
+    bool ReadBack(const std::vector<FrameRect> &regions, std::vector<FrameView> &views, int timeoutMs, uint64_t after)
     {
-        if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE) > 0)
-            DispatchMessage(&msg);
+        // Holding the frame keeps its surface out of the pool while it is copied
+        winrt::Windows::Graphics::Capture::Direct3D11CaptureFrame latestFrame{nullptr};
+        winrt::com_ptr<ID3D11Texture2D> latestTexture;
+        uint64_t sequence;
+        {
+            // Sleeps until FrameArrived or Close() signals, instead of polling
+            std::unique_lock<std::mutex> lock(m_frameMutex);
+            auto ready = [&]
+            { return m_closed || m_latestSequence > after; };
+            if (!m_frameArrived.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready) || m_closed)
+                return false;
+
+            latestFrame = m_latestFrame;
+            latestTexture = m_latestTexture;
+            sequence = m_latestSequence;
+        }
+        if (!latestTexture)
+            return false;
+
+        D3D11_TEXTURE2D_DESC capturedTextureDesc;
+        latestTexture->GetDesc(&capturedTextureDesc);
+        ReadbackPlan plan = PlanReadback(capturedTextureDesc.Width, capturedTextureDesc.Height, regions);
+        EnsureStagingTexture(capturedTextureDesc, plan.width, plan.height);
 
-        if (clock() - timer > 20000)
+        // Only the planned rectangles leave the GPU
+        for (const RegionCopy &copy : plan.copies)
         {
-            // TODO: try to make here a better error handling
-            return env.Null();
+            D3D11_BOX box{};
+            box.left = copy.source.x;
+            box.top = copy.source.y;
+            box.front = 0;
+            box.right = copy.source.x + copy.source.width;
+            box.bottom = copy.source.y + copy.source.height;
+            box.back = 1;
+            m_d3dContext->CopySubresourceRegion(m_stagingTexture.get(), 0, copy.dstX, copy.dstY, 0, latestTexture.get(), 0, &box);
         }
-    }
 
-    session.Close();
+        D3D11_MAPPED_SUBRESOURCE resource;
+        if (FAILED(m_d3dContext->Map(m_stagingTexture.get(), 0, D3D11_MAP_READ, 0, &resource)))
+            throw std::runtime_error("Failed to map the captured frame");
+        m_mapped = true;
 
-    D3D11_TEXTURE2D_DESC capturedTextureDesc;
-    texture->GetDesc(&capturedTextureDesc);
+        FrameView staging;
+        staging.width = plan.width;
+        staging.height = plan.height;
+        staging.channels = 4;
+        staging.stride = resource.RowPitch;
+        staging.sequence = sequence;
+        staging.data = static_cast<const uint8_t *>(resource.pData);
 
-    capturedTextureDesc.Usage = D3D11_USAGE_STAGING;
-    capturedTextureDesc.BindFlags = 0;
-    capturedTextureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-    capturedTextureDesc.MiscFlags = 0;
+        views.clear();
+        for (const FrameRect &region : plan.regions)
+            views.push_back(CropFrame(staging, region));
+        return true;
+    }
 
-    winrt::com_ptr<ID3D11Texture2D> userTexture = nullptr;
-    winrt::check_hresult(d3dDevice->CreateTexture2D(&capturedTextureDesc, NULL, userTexture.put()));
+    // The staging texture only grows, so alternating between full frames and small regions does not recreate it
+    void EnsureStagingTexture(D3D11_TEXTURE2D_DESC desc, int width, int height)
+    {
+        if (m_stagingTexture)
+        {
+            D3D11_TEXTURE2D_DESC stagingDesc;
+            m_stagingTexture->GetDesc(&stagingDesc);
+            if (stagingDesc.Width >= static_cast<UINT>(width) && stagingDesc.Height >= static_cast<UINT>(height) && stagingDesc.Format == desc.Format)
+                return;
+            width = std::max<int>(width, stagingDesc.Width);
+            height = std::max<int>(height, stagingDesc.Height);
+            m_stagingTexture = nullptr;
+        }
 
-    d3dContext->CopyResource(userTexture.get(), texture.get());
+        desc.Width = width;
+        desc.Height = height;
+        desc.Usage = D3D11_USAGE_STAGING;
+        desc.BindFlags = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        desc.MiscFlags = 0;
+        if (FAILED(m_d3dDevice->CreateTexture2D(&desc, NULL, m_stagingTexture.put())))
+            throw std::runtime_error("Failed to create the staging texture");
+    }
 
-    D3D11_MAPPED_SUBRESOURCE resource;
-    winrt::check_hresult(d3dContext->Map(userTexture.get(), NULL, D3D11_MAP_READ, 0, &resource));
+    int m_bufferCount;
+    winrt::com_ptr<ID3D11Device> m_d3dDevice;
+    winrt::com_ptr<ID3D11DeviceContext> m_d3dContext;
+    winrt::Windows::Graphics::DirectX::Direct3D11::IDirect3DDevice m_device{nullptr};
+    winrt::Windows::Graphics::Capture::Direct3D11CaptureFramePool m_framePool{nullptr};
+    winrt::Windows::Graphics::Capture::GraphicsCaptureItem m_captureItem{nullptr};
+    winrt::Windows::Graphics::Capture::GraphicsCaptureSession m_session{nullptr};
+    winrt::event_token m_frameArrivedToken{};
+    std::shared_ptr<CallbackGate> m_callbackGate;
+    winrt::Windows::Graphics::SizeInt32 m_poolSize{};
+    winrt::Windows::Graphics::Capture::Direct3D11CaptureFrame m_latestFrame{nullptr};
+    winrt::com_ptr<ID3D11Texture2D> m_latestTexture;
+    winrt::com_ptr<ID3D11Texture2D> m_stagingTexture;
+    std::mutex m_frameMutex;
+    std::condition_variable m_frameArrived;
+    uint64_t m_latestSequence = 0;
+    std::atomic<bool> m_closed{false};
+    bool m_mapped = false;
+};
 
-    BITMAPINFO lBmpInfo;
+std::unique_ptr<FrameSource> OpenWindowFrameSource(const std::string &windowName, int bufferCount)
+{
+    HWND hwndTarget = FindWindowA(NULL, windowName.c_str());
+    if (!hwndTarget)
+        return nullptr;
 
-    // BMP 32 bpp
-    ZeroMemory(&lBmpInfo, sizeof(BITMAPINFO));
-    lBmpInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    lBmpInfo.bmiHeader.biBitCount = 32;
-    lBmpInfo.bmiHeader.biCompression = BI_RGB;
-    lBmpInfo.bmiHeader.biWidth = capturedTextureDesc.Width;
-    lBmpInfo.bmiHeader.biHeight = capturedTextureDesc.Height;
-    lBmpInfo.bmiHeader.biPlanes = 1;
-    lBmpInfo.bmiHeader.biSizeImage = capturedTextureDesc.Width * capturedTextureDesc.Height * 4;
+    try
+    {
+        return std::make_unique<WindowFrameSource>(hwndTarget, bufferCount);
+    }
+    catch (const winrt::hresult_error &e)
+    {
+        throw std::runtime_error(winrt::to_string(e.message()));
+    }
+}
 
-    auto imageBuffer = cv::Mat(capturedTextureDesc.Height, capturedTextureDesc.Width, CV_8UC4, resource.pData, resource.RowPitch);
-    std::vector<uchar> encodedImage;
-    cv::imencode(".png", imageBuffer, encodedImage);
+Napi::Value CaptureWindow(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
 
-    if (encodedImage.empty())
+    if (info.Length() < 1 || !info[0].IsString())
     {
-        return env.Null(); // Error handling for encoding failure
+        Napi::TypeError::New(env, "Window name must be provided as a string").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    auto data = encodedImage.data();
+    std::string windowName = info[0].As<Napi::String>().Utf8Value();
+
+    // PNG stays the default here so existing callers keep getting an encoded buffer
+    CaptureOptions options;
+    options.format = CaptureFormat::Png;
+    if (!ParseCaptureOptions(info, 1, options))
+        return env.Null();
 
-    d3dContext->Unmap(userTexture.get(), 0);
-    Napi::Buffer<uchar> resultBuffer = Napi::Buffer<uchar>::Copy(env, data, encodedImage.size());
+    try
+    {
+        std::unique_ptr<FrameSource> source = OpenWindowFrameSource(windowName);
+        if (!source)
+        {
+            Napi::TypeError::New(env, "Window not found").ThrowAsJavaScriptException();
+            return env.Null();
+        }
 
-    return resultBuffer;
+        std::vector<FrameView> views;
+        if (!AcquireCapture(*source, options, views))
+        {
+            CaptureTimeoutError(env, options.timeoutMs).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        Napi::Value result = CaptureToValue(env, views, options);
+        source->ReleaseFrame();
+        return result;
+    }
+    catch (const cv::Exception &e)
+    {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    catch (const std::runtime_error &e)
+    {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
 }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <napi.h>
+#include <string>
+#include <stopCondition.h>
+
+// Values of `error.code` for failures JS callers need to tell apart. Mirrored in src/index.ts.
+#define ERR_CAPTURE_TIMEOUT "ERR_CAPTURE_TIMEOUT"
+#define ERR_CANCELLED "ERR_CANCELLED"
+#define ERR_DEADLINE_EXCEEDED "ERR_DEADLINE_EXCEEDED"
+
+/**
+ * Creates an Error with a `code` property and a matching `name`, e.g. ("ERR_CAPTURE_TIMEOUT", "CaptureTimeoutError").
+ */
+inline Napi::Error CodedError(Napi::Env env, const char *code, const char *name, const std::string &message)
+{
+    Napi::Error error = Napi::Error::New(env, message);
+    error.Value().Set("code", Napi::String::New(env, code));
+    error.Value().Set("name", Napi::String::New(env, name));
+    return error;
+}
+
+inline Napi::Error CaptureTimeoutError(Napi::Env env, int timeoutMs)
+{
+    return CodedError(env, ERR_CAPTURE_TIMEOUT, "CaptureTimeoutError",
+                      "No frame arrived within " + std::to_string(timeoutMs) + " ms");
+}
+
+inline Napi::Error StoppedError(Napi::Env env, const OperationStopped &stopped)
+{
+    if (stopped.Reason() == StopReason::Cancelled)
+        return CodedError(env, ERR_CANCELLED, "CancelledError", stopped.what());
+    return CodedError(env, ERR_DEADLINE_EXCEEDED, "DeadlineExceededError", stopped.what());
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * One preallocated frame buffer of a FrameRing. Pixels are tightly packed: `width * channels` bytes per row.
+ */
+struct FrameSlot
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    uint64_t sequence = 0;
+    std::vector<uint8_t> data;
+};
+
+struct FrameRingStats
+{
+    uint64_t delivered = 0; // frames handed to a reader
+    uint64_t dropped = 0;   // frames thrown away before anyone read them
+    uint64_t skipped = 0;   // frames the producer chose not to store, e.g. to honour an fps limit
+    size_t queued = 0;      // frames currently waiting to be read
+};
+
+/**
+ * Bounded queue of reusable frame buffers between one producer thread and one reader.
+ * Holds at most `maxQueued` unread frames; when the reader falls behind, the oldest unread frame is dropped
+ * and its buffer reused, so the ring never grows. Buffers are only reallocated when the frame size grows.
+ */
+class FrameRing
+{
+public:
+    explicit FrameRing(size_t maxQueued)
+        : m_slots(maxQueued + 2), m_queue(maxQueued)
+    {
+        // One slot can be in the producer's hands and one in the reader's on top of the queued ones
+        m_free.reserve(m_slots.size());
+        for (size_t i = 0; i < m_slots.size(); ++i)
+            m_free.push_back(i);
+    }
+
+    /**
+     * Producer: returns a buffer for the next frame, sized for `width * height * channels` bytes.
+     * Never waits: if every buffer is queued, the oldest queued frame is dropped.
+     */
+    FrameSlot *BeginWrite(int width, int height, int channels)
+    {
+        size_t index;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_free.empty())
+            {
+                index = PopOldest();
+                ++m_stats.dropped;
+            }
+            else
+            {
+                index = m_free.back();
+                m_free.pop_back();
+            }
+        }
+
+        FrameSlot &slot = m_slots[index];
+        slot.width = width;
+        slot.height = height;
+        slot.channels = channels;
+        const size_t bytes = static_cast<size_t>(width) * height * channels;
+        if (slot.data.size() < bytes)
+            slot.data.resize(bytes);
+        return &slot;
+    }
+
+    /**
+     * Producer: queues the frame written into `slot`, dropping the oldest queued frame if the queue is full.
+     */
+    void CommitWrite(FrameSlot *slot, uint64_t sequence)
+    {
+        slot->sequence = sequence;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queued == m_queue.size())
+        {
+            m_free.push_back(PopOldest());
+            ++m_stats.dropped;
+        }
+        m_queue[(m_head + m_queued) % m_queue.size()] = IndexOf(slot);
+        ++m_queued;
+    }
+
+    /**
+     * Producer: records a frame that was seen but not stored.
+     */
+    void CountSkipped()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.skipped;
+    }
+
+    /**
+     * Reader: takes the oldest unread frame, or nullptr if there is none. Give it back with EndRead().
+     */
+    FrameSlot *BeginReadNext()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queued == 0)
+            return nullptr;
+        ++m_stats.delivered;
+        return &m_slots[PopOldest()];
+    }
+
+    /**
+     * Reader: takes the newest unread frame and drops the older ones, or returns nullptr if there is none.
+     */
+    FrameSlot *BeginReadLatest()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queued == 0)
+            return nullptr;
+        while (m_queued > 1)
+        {
+            m_free.push_back(PopOldest());
+            ++m_stats.dropped;
+        }
+        ++m_stats.delivered;
+        return &m_slots[PopOldest()];
+    }
+
+    void EndRead(FrameSlot *slot)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(IndexOf(slot));
+    }
+
+    FrameRingStats Stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FrameRingStats stats = m_stats;
+        stats.queued = m_queued;
+        return stats;
+    }
+
+private:
+    // Caller holds m_mutex and has checked that the queue is not empty
+    size_t PopOldest()
+    {
+        size_t index = m_queue[m_head];
+        m_head = (m_head + 1) % m_queue.size();
+        --m_queued;
+        return index;
+    }
+
+    size_t IndexOf(const FrameSlot *slot) const
+    {
+        return static_cast<size_t>(slot - m_slots.data());
+    }
+
+    std::vector<FrameSlot> m_slots;
+    std::vector<size_t> m_free;
+    std::vector<size_t> m_queue;
+    size_t m_head = 0;
+    size_t m_queued = 0;
+    FrameRingStats m_stats;
+    mutable std::mutex m_mutex;
+};
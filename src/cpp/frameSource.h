@@ -0,0 +1,312 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <pixelConvert.h>
+#include <readbackPlan.h>
+
+// How long a capture waits for the first frame before giving up
+const int DEFAULT_FRAME_TIMEOUT_MS = 20000;
+
+/**
+ * A view over one frame owned by a FrameSource.
+ * `data` stays valid until FrameSource::ReleaseFrame() is called.
+ */
+struct FrameView
+{
+    int width = 0;
+    int height = 0;
+    int channels = 4;
+    size_t stride = 0;
+    uint64_t sequence = 0;
+    const uint8_t *data = nullptr;
+};
+
+/**
+ * Frames are gray, BGR or BGRA; CopyFrame() and the encoders have no conversion for anything else.
+ */
+inline bool SupportedFrameChannels(int channels)
+{
+    return channels == 1 || channels == 3 || channels == 4;
+}
+
+/**
+ * Narrows a frame view to `region`, which must lie inside the frame.
+ */
+inline FrameView CropFrame(const FrameView &frame, const FrameRect &region)
+{
+    FrameView view = frame;
+    view.width = region.width;
+    view.height = region.height;
+    view.data = frame.data + region.y * frame.stride + static_cast<size_t>(region.x) * frame.channels;
+    return view;
+}
+
+/**
+ * Something that produces BGRA frames for a capture session.
+ * Frames are numbered by `sequence`, starting at 1, so callers can tell a new frame from a repeated one.
+ */
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    /**
+     * Waits up to `timeoutMs` for a frame newer than `after` and exposes it through `frame`.
+     * Returns false on timeout or when the source has been closed.
+     */
+    virtual bool AcquireFrame(FrameView &frame, int timeoutMs, uint64_t after = 0) = 0;
+
+    /**
+     * Like AcquireFrame(), but only exposes `regions` of the frame, one view per region, in the same order.
+     * Throws std::runtime_error if a region is not inside the frame. Release with ReleaseFrame().
+     * Sources that have to copy frames out of the GPU override this to read back only the requested pixels.
+     */
+    virtual bool AcquireRegions(const std::vector<FrameRect> &regions, std::vector<FrameView> &views, int timeoutMs, uint64_t after = 0)
+    {
+        FrameView frame;
+        if (!AcquireFrame(frame, timeoutMs, after))
+            return false;
+
+        views.clear();
+        for (const FrameRect &region : regions)
+        {
+            if (!RegionInsideFrame(region, frame.width, frame.height))
+            {
+                ReleaseFrame();
+                throw std::runtime_error("Capture region is empty or outside the window");
+            }
+            views.push_back(CropFrame(frame, region));
+        }
+        return true;
+    }
+
+    /**
+     * Gives back the frame exposed by the last successful AcquireFrame() or AcquireRegions().
+     */
+    virtual void ReleaseFrame() = 0;
+
+    virtual void Close() = 0;
+    virtual bool IsClosed() const = 0;
+};
+
+/**
+ * In-memory stand-in for a window capture. Frames are pushed by the owner (or by a producer thread)
+ * and handed out exactly like captured frames, so everything built on FrameSource can run without a window.
+ */
+class MemoryFrameSource : public FrameSource
+{
+public:
+    MemoryFrameSource(int width, int height, int channels = 4)
+        : m_width(width), m_height(height), m_channels(channels),
+          m_pending(static_cast<size_t>(width) * height * channels),
+          m_current(m_pending.size())
+    {
+    }
+
+    /**
+     * Copies one frame into the source. `stride` is the distance in bytes between rows of `data`.
+     */
+    void PushFrame(const uint8_t *data, size_t stride)
+    {
+        const size_t rowBytes = static_cast<size_t>(m_width) * m_channels;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_closed)
+                return;
+            for (int y = 0; y < m_height; ++y)
+                memcpy(m_pending.data() + y * rowBytes, data + y * stride, rowBytes);
+            m_pendingSequence = ++m_lastSequence;
+        }
+        m_frameArrived.notify_all();
+    }
+
+    bool AcquireFrame(FrameView &frame, int timeoutMs, uint64_t after = 0) override
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto ready = [&]
+        { return m_closed || m_lastSequence > after; };
+        if (!m_frameArrived.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready) || m_closed)
+            return false;
+
+        if (m_pendingSequence != 0)
+        {
+            m_pending.swap(m_current);
+            m_currentSequence = m_pendingSequence;
+            m_pendingSequence = 0;
+        }
+
+        frame.width = m_width;
+        frame.height = m_height;
+        frame.channels = m_channels;
+        frame.stride = static_cast<size_t>(m_width) * m_channels;
+        frame.sequence = m_currentSequence;
+        frame.data = m_current.data();
+        return true;
+    }
+
+    void ReleaseFrame() override {}
+
+    int Width() const { return m_width; }
+    int Height() const { return m_height; }
+    int Channels() const { return m_channels; }
+
+    void Close() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_frameArrived.notify_all();
+    }
+
+    bool IsClosed() const override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_closed;
+    }
+
+private:
+    int m_width;
+    int m_height;
+    int m_channels;
+    std::vector<uint8_t> m_pending;
+    std::vector<uint8_t> m_current;
+    uint64_t m_pendingSequence = 0;
+    uint64_t m_currentSequence = 0;
+    uint64_t m_lastSequence = 0;
+    bool m_closed = false;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_frameArrived;
+};
+
+/**
+ * A frame source shared between a JS object and the workers reading from it.
+ * AcquireFrame/ReleaseFrame pairs must hold `mutex`, since a source hands out one frame at a time.
+ */
+struct SharedFrameSource
+{
+    explicit SharedFrameSource(std::unique_ptr<FrameSource> frameSource) : source(std::move(frameSource)) {}
+
+    std::unique_ptr<FrameSource> source;
+    std::mutex mutex;
+};
+
+/**
+ * How a capture from a SharedFrameSource ended.
+ */
+enum class SharedCaptureStatus
+{
+    Captured,
+    TimedOut,
+    Closed,
+    // Another capture held the source and `wait` was false
+    Busy
+};
+
+/**
+ * Takes one frame from a shared source: holds its mutex while `acquire(source)` exposes a frame and `read()` copies
+ * what it needs out of it, then releases the frame, also when `read` throws.
+ * This is the body of the capture workers, kept free of N-API so it runs on any thread. With `wait` false it returns
+ * Busy instead of queuing behind a capture that holds the source, which is what the JS thread needs.
+ */
+template <typename Acquire, typename Read>
+SharedCaptureStatus CaptureShared(SharedFrameSource &shared, Acquire acquire, Read read, bool wait = true)
+{
+    std::unique_lock<std::mutex> lock(shared.mutex, std::defer_lock);
+    if (wait)
+        lock.lock();
+    else if (!lock.try_lock())
+        return SharedCaptureStatus::Busy;
+    if (shared.source->IsClosed())
+        return SharedCaptureStatus::Closed;
+    if (!acquire(*shared.source))
+        return shared.source->IsClosed() ? SharedCaptureStatus::Closed : SharedCaptureStatus::TimedOut;
+
+    try
+    {
+        read();
+    }
+    catch (...)
+    {
+        shared.source->ReleaseFrame();
+        throw;
+    }
+    shared.source->ReleaseFrame();
+    return SharedCaptureStatus::Captured;
+}
+
+/**
+ * Opens a capture of the window with the given title. Returns nullptr when no such window exists.
+ * `bufferCount` is how many frames the capture can have in flight before it has to wait for the reader.
+ * Implemented next to the Windows Graphics Capture code in capturewindow.cpp.
+ */
+std::unique_ptr<FrameSource> OpenWindowFrameSource(const std::string &windowName, int bufferCount = 2);
+
+/**
+ * Encodes a frame as PNG. Returns false if OpenCV could not encode it.
+ */
+inline bool EncodeFramePng(const FrameView &frame, std::vector<uchar> &encoded)
+{
+    const int type = CV_MAKETYPE(CV_8U, frame.channels);
+    cv::Mat image(frame.height, frame.width, type, const_cast<uint8_t *>(frame.data), frame.stride);
+    cv::imencode(".png", image, encoded);
+    return !encoded.empty();
+}
+
+/**
+ * Copies a frame into a tightly packed buffer of `width * height * dstChannels` bytes,
+ * converting between gray, BGR and BGRA on the way.
+ * The conversions captures need most (BGRA to BGR, color to gray) run straight off the mapped rows in one pass.
+ */
+inline void CopyFrame(const FrameView &frame, int dstChannels, uint8_t *dst)
+{
+    if (frame.channels == 4 && dstChannels == 3)
+    {
+        ConvertBgraToBgr(frame.data, frame.stride, dst, frame.width, frame.height);
+        return;
+    }
+    if (frame.channels >= 3 && dstChannels == 1)
+    {
+        ConvertColorToGray(frame.data, frame.stride, frame.channels, dst, frame.width, frame.height);
+        return;
+    }
+
+    const int srcType = CV_MAKETYPE(CV_8U, frame.channels);
+    cv::Mat src(frame.height, frame.width, srcType, const_cast<uint8_t *>(frame.data), frame.stride);
+    cv::Mat out(frame.height, frame.width, CV_MAKETYPE(CV_8U, dstChannels), dst);
+
+    if (frame.channels == dstChannels)
+    {
+        src.copyTo(out);
+        return;
+    }
+
+    int code = -1;
+    if (frame.channels == 4)
+        code = dstChannels == 3 ? cv::COLOR_BGRA2BGR : cv::COLOR_BGRA2GRAY;
+    else if (frame.channels == 3)
+        code = dstChannels == 4 ? cv::COLOR_BGR2BGRA : cv::COLOR_BGR2GRAY;
+    else
+        code = dstChannels == 4 ? cv::COLOR_GRAY2BGRA : cv::COLOR_GRAY2BGR;
+    // cvtColor writes into `out` in place since it already has the right size and type
+    cv::cvtColor(src, out, code);
+}
+
+/**
+ * Copies a frame as gray at half resolution into a tightly packed buffer of `(width / 2) * (height / 2)` bytes.
+ */
+inline void CopyFrameHalfGray(const FrameView &frame, uint8_t *dst)
+{
+    ConvertColorToHalfGray(frame.data, frame.stride, frame.channels, dst, frame.width, frame.height);
+}
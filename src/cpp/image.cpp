@@ -0,0 +1,323 @@
+#include <napi.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <errors.h>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+/**
+ * JS handle to a refcounted cv::Mat, so chains like `image.bgrToGray().blur(3, 3).getRegion(roi)` stay in native
+ * memory. Every operation returns a new Image; getRegion() shares the pixels of its parent instead of copying them.
+ * Pixels only cross into JS when toImageData() is called.
+ */
+class Image : public Napi::ObjectWrap<Image>
+{
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports)
+    {
+        Napi::Function func = DefineClass(env, "Image",
+                                          {InstanceMethod("matchTemplate", &Image::MatchTemplate),
+                                           InstanceMethod("blur", &Image::Blur),
+                                           InstanceMethod("bgrToGray", &Image::BgrToGray),
+                                           InstanceMethod("drawRectangle", &Image::DrawRectangle),
+                                           InstanceMethod("getRegion", &Image::GetRegion),
+                                           InstanceMethod("toPng", &Image::ToPng),
+                                           InstanceMethod("toImageData", &Image::ToImageData),
+                                           InstanceAccessor("width", &Image::GetWidth, nullptr),
+                                           InstanceAccessor("height", &Image::GetHeight, nullptr),
+                                           InstanceAccessor("channels", &Image::GetChannels, nullptr)});
+        constructor = Napi::Persistent(func);
+        constructor.SuppressDestruct();
+        exports.Set("Image", func);
+        return exports;
+    }
+
+    /**
+     * Wraps `mat` in a new JS Image without copying it.
+     */
+    static Napi::Object NewInstance(Napi::Env env, const cv::Mat &mat)
+    {
+        cv::Mat shared = mat;
+        return constructor.New({Napi::External<cv::Mat>::New(env, &shared)});
+    }
+
+    /**
+     * Returns the Mat behind `value` if it is an Image, or nullptr.
+     */
+    static const cv::Mat *MatOf(Napi::Value value)
+    {
+        if (!value.IsObject() || !value.As<Napi::Object>().InstanceOf(constructor.Value()))
+            return nullptr;
+        return &Unwrap(value.As<Napi::Object>())->m_mat;
+    }
+
+    /**
+     * Accepts `new Image(path)`, `new Image(imageData)` or an Image created natively by NewInstance().
+     */
+    Image(const Napi::CallbackInfo &info) : Napi::ObjectWrap<Image>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() > 0 && info[0].IsExternal())
+        {
+            m_mat = *info[0].As<Napi::External<cv::Mat>>().Data();
+        }
+        else if (info.Length() > 0 && info[0].IsString())
+        {
+            int flags = cv::IMREAD_COLOR;
+            if (info.Length() > 1 && info[1].IsNumber())
+                flags = info[1].ToNumber().Int32Value();
+
+            m_mat = cv::imread(info[0].ToString().Utf8Value(), flags);
+            if (m_mat.empty())
+            {
+                Napi::TypeError::New(env, "Failed to load image").ThrowAsJavaScriptException();
+                return;
+            }
+        }
+        else if (info.Length() > 0)
+        {
+            cv::Mat view;
+            if (!ImageDataToMat(env, info[0], view))
+                return;
+            // The JS buffer can be collected at any time, so the handle keeps its own copy
+            m_mat = view.clone();
+        }
+        else
+        {
+            Napi::TypeError::New(env, "Image path or image data must be provided").ThrowAsJavaScriptException();
+            return;
+        }
+
+        // ROIs share their parent's buffer, so only whole buffers are reported
+        if (!m_mat.isSubmatrix())
+        {
+            m_externalBytes = static_cast<int64_t>(m_mat.total() * m_mat.elemSize());
+            Napi::MemoryManagement::AdjustExternalMemory(env, m_externalBytes);
+        }
+    }
+
+    ~Image()
+    {
+        if (m_externalBytes != 0)
+            Napi::MemoryManagement::AdjustExternalMemory(Env(), -m_externalBytes);
+    }
+
+    /**
+     * Reads an Image or an ImageData argument. Throws a TypeError and returns false on bad input.
+     * A Mat read from an ImageData points at JS memory and is only valid during the call.
+     */
+    static bool ImageArgument(Napi::Env env, Napi::Value value, cv::Mat &mat)
+    {
+        if (const cv::Mat *image = MatOf(value))
+        {
+            mat = *image;
+            return true;
+        }
+        return ImageDataToMat(env, value, mat);
+    }
+
+private:
+    static Napi::FunctionReference constructor;
+
+    Napi::Value MatchTemplate(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Invalid arguments. Expected: (template[, method[, mask[, options]]])").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        cv::Mat templ;
+        if (!ImageArgument(env, info[0], templ))
+            return env.Null();
+
+        int method = cv::TM_CCOEFF_NORMED;
+        if (info.Length() > 1 && info[1].IsNumber())
+            method = info[1].ToNumber().Int32Value();
+        if (method < cv::TM_SQDIFF || method > cv::TM_CCOEFF_NORMED)
+        {
+            Napi::TypeError::New(env, "Invalid template matching method").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        cv::Mat mask;
+        if (info.Length() > 2 && !info[2].IsUndefined() && !info[2].IsNull() && !ImageArgument(env, info[2], mask))
+            return env.Null();
+
+        MatchOptions options;
+        if (!ParseMatchOptions(info, 3, options))
+            return env.Null();
+
+        try
+        {
+            return ExtremesToValue(env, RunMatch(m_mat, templ, method, mask, options));
+        }
+        catch (const cv::Exception &e)
+        {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        catch (const OperationStopped &e)
+        {
+            StoppedError(env, e).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        catch (const std::runtime_error &e)
+        {
+            Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    Napi::Value Blur(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber())
+        {
+            Napi::TypeError::New(env, "Invalid arguments. Expected: (number, number)").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        cv::Mat blurred;
+        cv::blur(m_mat, blurred, cv::Size(info[0].ToNumber().Int32Value(), info[1].ToNumber().Int32Value()));
+        return NewInstance(env, blurred);
+    }
+
+    Napi::Value BgrToGray(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        // Images never change, so a gray image is its own gray version
+        if (m_mat.channels() == 1)
+            return info.This();
+
+        cv::Mat gray;
+        cv::cvtColor(m_mat, gray, m_mat.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+        return NewInstance(env, gray);
+    }
+
+    Napi::Value DrawRectangle(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 4 || !info[0].IsArray() || !info[1].IsArray() || !info[2].IsArray() || !info[3].IsNumber())
+        {
+            Napi::TypeError::New(env, "Invalid arguments. Expected: (array, array, array, number)").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        Napi::Array point1Array = info[0].As<Napi::Array>();
+        Napi::Array point2Array = info[1].As<Napi::Array>();
+        Napi::Array colorArray = info[2].As<Napi::Array>();
+        if (point1Array.Length() < 2 || point2Array.Length() < 2)
+        {
+            Napi::TypeError::New(env, "Invalid point array length. Expected: [x, y]").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (colorArray.Length() < 3)
+        {
+            Napi::TypeError::New(env, "Invalid color array length. Expected: [r, g, b]").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        cv::Point point1(point1Array.Get((uint32_t)0).ToNumber().Int32Value(), point1Array.Get((uint32_t)1).ToNumber().Int32Value());
+        cv::Point point2(point2Array.Get((uint32_t)0).ToNumber().Int32Value(), point2Array.Get((uint32_t)1).ToNumber().Int32Value());
+        int r = colorArray.Get((uint32_t)0).ToNumber().Int32Value();
+        int g = colorArray.Get((uint32_t)1).ToNumber().Int32Value();
+        int b = colorArray.Get((uint32_t)2).ToNumber().Int32Value();
+
+        // Other handles may share these pixels, so draw on a copy
+        cv::Mat image = m_mat.clone();
+        cv::rectangle(image, point1, point2, cv::Scalar(b, g, r, 255), info[3].ToNumber().Int32Value());
+        return NewInstance(env, image);
+    }
+
+    Napi::Value GetRegion(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        FrameRect region;
+        if (info.Length() < 1 || !ParseFrameRect(info[0], region))
+        {
+            Napi::TypeError::New(env, "Invalid arguments. Expected: ([x, y, width, height])").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (!RegionInsideFrame(region, m_mat.cols, m_mat.rows))
+        {
+            Napi::TypeError::New(env, "Invalid region coordinates or size").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        return NewInstance(env, m_mat(cv::Rect(region.x, region.y, region.width, region.height)));
+    }
+
+    Napi::Value ToPng(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        std::vector<uchar> buffer;
+        cv::imencode(".png", m_mat, buffer);
+        return Napi::Buffer<uchar>::Copy(env, buffer.data(), buffer.size());
+    }
+
+    /**
+     * Copies the pixels out. Sharing them would let JS write into an image that other handles, views and compiled
+     * templates still read.
+     */
+    Napi::Value ToImageData(const Napi::CallbackInfo &info)
+    {
+        return MatToImageData(info.Env(), m_mat.clone());
+    }
+
+    Napi::Value GetWidth(const Napi::CallbackInfo &info)
+    {
+        return Napi::Number::New(info.Env(), m_mat.cols);
+    }
+
+    Napi::Value GetHeight(const Napi::CallbackInfo &info)
+    {
+        return Napi::Number::New(info.Env(), m_mat.rows);
+    }
+
+    Napi::Value GetChannels(const Napi::CallbackInfo &info)
+    {
+        return Napi::Number::New(info.Env(), m_mat.channels());
+    }
+
+    cv::Mat m_mat;
+    int64_t m_externalBytes = 0;
+};
+
+Napi::FunctionReference Image::constructor;
+
+// Defined after Image so it takes an Image handle as well as an ImageData
+Napi::Value Imwrite(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    cv::Mat image;
+    if (info.Length() < 1 || !Image::ImageArgument(env, info[0], image))
+    {
+        if (!env.IsExceptionPending())
+            Napi::TypeError::New(env, "Invalid arguments. Expected: object").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::vector<uchar> buffer;
+    try
+    {
+        cv::imencode(".png", image, buffer);
+    }
+    catch (const cv::Exception &e)
+    {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Napi::Buffer<uchar>::Copy(env, buffer.data(), buffer.size());
+}
@@ -0,0 +1,118 @@
+#include <napi.h>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Wraps `length` bytes at `data` in a Uint8Array without copying them. `owner` keeps the bytes alive and is
+ * deleted when the ArrayBuffer is garbage collected. The bytes are reported to V8 as external memory, so large
+ * images still put pressure on the GC even though they live outside the JS heap.
+ */
+template <typename Owner>
+Napi::Uint8Array ExternalBytes(Napi::Env env, Owner *owner, uint8_t *data, size_t length)
+{
+#ifdef NODE_API_NO_EXTERNAL_BUFFERS_ALLOWED
+    // Runtimes with a V8 sandbox (e.g. Electron) reject external buffers
+    Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, length);
+    memcpy(arrayBuffer.Data(), data, length);
+    delete owner;
+#else
+    const int64_t bytes = static_cast<int64_t>(length);
+    Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(
+        env, data, length,
+        [bytes](Napi::Env env, void *, Owner *owner)
+        {
+            delete owner;
+            Napi::MemoryManagement::AdjustExternalMemory(env, -bytes);
+        },
+        owner);
+    Napi::MemoryManagement::AdjustExternalMemory(env, bytes);
+#endif
+    return Napi::Uint8Array::New(env, length, arrayBuffer, 0);
+}
+
+Napi::Object NewImageData(Napi::Env env, int width, int height, int channels, Napi::Uint8Array data)
+{
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("width", width);
+    result.Set("height", height);
+    result.Set("channels", channels);
+    result.Set("stride", Napi::Number::New(env, static_cast<double>(static_cast<size_t>(width) * channels)));
+    result.Set("data", data);
+    return result;
+}
+
+/**
+ * Returns an 8-bit Mat to JS as an ImageData-shaped object that shares the Mat's pixels.
+ * The JS object holds a reference to the Mat's buffer until it is collected. A Mat that does not own its
+ * pixels (a header over JS memory) or is not continuous (an ROI) is cloned once first.
+ */
+Napi::Object MatToImageData(Napi::Env env, const cv::Mat &mat)
+{
+    cv::Mat *owned = new cv::Mat(mat.u != nullptr && mat.isContinuous() ? mat : mat.clone());
+    const size_t totalBytes = owned->total() * owned->elemSize();
+    Napi::Uint8Array data = ExternalBytes(env, owned, owned->data, totalBytes);
+    return NewImageData(env, owned->cols, owned->rows, owned->channels(), data);
+}
+
+/**
+ * Hands tightly packed pixels to JS as an ImageData-shaped object without copying them.
+ */
+Napi::Object VectorToImageData(Napi::Env env, std::vector<uint8_t> &&pixels, int width, int height, int channels)
+{
+    auto *owned = new std::vector<uint8_t>(std::move(pixels));
+    Napi::Uint8Array data = ExternalBytes(env, owned, owned->data(), owned->size());
+    return NewImageData(env, width, height, channels, data);
+}
+
+/**
+ * Points `mat` at the pixels of an ImageData-shaped object without copying them, so `mat` is only valid while
+ * the object is. Honors `channels` and `stride` when they are set and otherwise infers the channel count from the
+ * size of `data`. Throws a TypeError and returns false on bad input.
+ */
+bool ImageDataToMat(Napi::Env env, Napi::Value value, cv::Mat &mat)
+{
+    if (!value.IsObject())
+    {
+        Napi::TypeError::New(env, "Image data must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object imageData = value.As<Napi::Object>();
+    if (!imageData.Has("width") || !imageData.Has("height") || !imageData.Has("data") || !imageData.Get("data").IsTypedArray())
+    {
+        Napi::TypeError::New(env, "Invalid image data object. Expected properties: 'width', 'height', 'data'").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    int width = imageData.Get("width").ToNumber().Int32Value();
+    int height = imageData.Get("height").ToNumber().Int32Value();
+    Napi::TypedArray typedArray = imageData.Get("data").As<Napi::TypedArray>();
+    if (width <= 0 || height <= 0)
+    {
+        Napi::TypeError::New(env, "Invalid image size").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    int channels = 0;
+    if (imageData.Has("channels") && imageData.Get("channels").IsNumber())
+        channels = imageData.Get("channels").ToNumber().Int32Value();
+    else
+        channels = static_cast<int>(typedArray.ByteLength() / (static_cast<size_t>(width) * height));
+
+    size_t stride = static_cast<size_t>(width) * channels;
+    if (imageData.Has("stride") && imageData.Get("stride").IsNumber())
+        stride = static_cast<size_t>(imageData.Get("stride").ToNumber().Int64Value());
+
+    if (channels < 1 || channels > 4 || stride < static_cast<size_t>(width) * channels ||
+        typedArray.ByteLength() < stride * (height - 1) + static_cast<size_t>(width) * channels)
+    {
+        Napi::TypeError::New(env, "Image data size does not match its width and height").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    uint8_t *data = static_cast<uint8_t *>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+    mat = cv::Mat(height, width, CV_MAKETYPE(CV_8U, channels), data, stride);
+    return true;
+}
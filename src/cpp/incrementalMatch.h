@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <stopCondition.h>
+#include <workerPool.h>
+
+// Side of the square tiles frames are compared in, when not given
+const int INCREMENTAL_DEFAULT_TILE_SIZE = 64;
+
+struct IncrementalStats
+{
+    // Frames matched so far
+    uint64_t frames = 0;
+    // Frames matched from scratch: the first one and any after a size or layout change
+    uint64_t fullFrames = 0;
+    // Tiles of the last frame, and how many of them differed from the frame before
+    int tiles = 0;
+    int changedTiles = 0;
+    // Share of the response recomputed for the last frame and on average over all frames, 0 to 1
+    double recomputed = 0;
+    double averageRecomputed = 0;
+};
+
+/**
+ * matchTemplate over a sequence of frames of the same window that only recomputes what changed. Each frame is
+ * compared with the previous one in fixed-size tiles; a changed tile invalidates every template position whose
+ * window touches it, i.e. the tile grown by the template size minus one to the left and top. Only those parts of
+ * the cached response are matched again, the rest is kept from earlier frames.
+ * Every position of the response depends only on the pixels under the template there, so the cached response is
+ * always exactly what a full match of the current frame would give.
+ */
+class IncrementalMatch
+{
+public:
+    IncrementalMatch(const cv::Mat &templ, int method, int tileSize)
+        : m_templ(templ.clone()), m_method(method), m_tileSize(std::max(tileSize, 8))
+    {
+    }
+
+    /**
+     * Matches `frame` and returns the response for it. The frame must have the template's type. `stop` is checked
+     * before each changed area is matched. When it fires, or matching fails, the cache is dropped and the next frame
+     * is matched in full.
+     */
+    const cv::Mat &Update(const cv::Mat &frame, WorkerPool &pool, const StopCondition *stop = nullptr)
+    {
+        try
+        {
+            return Match(frame, pool, stop);
+        }
+        catch (...)
+        {
+            // Changed tiles may already be copied without the response being updated for them
+            Reset();
+            throw;
+        }
+    }
+
+    /**
+     * Forgets the previous frame, so the next one is matched from scratch.
+     */
+    void Reset()
+    {
+        m_previous.release();
+        m_response.release();
+    }
+
+    const IncrementalStats &Stats() const
+    {
+        return m_stats;
+    }
+
+    const cv::Mat &Template() const
+    {
+        return m_templ;
+    }
+
+    int Method() const
+    {
+        return m_method;
+    }
+
+private:
+    const cv::Mat &Match(const cv::Mat &frame, WorkerPool &pool, const StopCondition *stop)
+    {
+        CV_Assert(frame.type() == m_templ.type());
+        if (frame.cols < m_templ.cols || frame.rows < m_templ.rows)
+            CV_Error(cv::Error::StsBadSize, "The template is larger than the frame");
+
+        const int tileCols = (frame.cols + m_tileSize - 1) / m_tileSize;
+        const int tileRows = (frame.rows + m_tileSize - 1) / m_tileSize;
+        ++m_stats.frames;
+        m_stats.tiles = tileCols * tileRows;
+
+        if (m_previous.size() != frame.size() || m_previous.type() != frame.type())
+        {
+            if (stop)
+                stop->ThrowIfStopped();
+            frame.copyTo(m_previous);
+            cv::matchTemplate(m_previous, m_templ, m_response, m_method);
+            ++m_stats.fullFrames;
+            m_stats.changedTiles = m_stats.tiles;
+            RecordRecomputed(1.0);
+            return m_response;
+        }
+
+        // Runs of changed tiles along each tile row, in tile units
+        std::vector<cv::Rect> runs;
+        m_stats.changedTiles = 0;
+        for (int row = 0; row < tileRows; ++row)
+        {
+            int start = -1;
+            for (int col = 0; col <= tileCols; ++col)
+            {
+                const bool changed = col < tileCols && TileChanged(frame, TileRect(col, row, frame.size()));
+                if (changed)
+                {
+                    ++m_stats.changedTiles;
+                    if (start < 0)
+                        start = col;
+                }
+                else if (start >= 0)
+                {
+                    runs.emplace_back(start, row, col - start, 1);
+                    start = -1;
+                }
+            }
+        }
+
+        // The part of the response each run invalidates
+        std::vector<cv::Rect> dirty;
+        const cv::Rect responseBounds(0, 0, m_response.cols, m_response.rows);
+        for (const cv::Rect &run : runs)
+        {
+            const cv::Rect pixels = TileRect(run.x, run.y, frame.size()) | TileRect(run.x + run.width - 1, run.y, frame.size());
+            const cv::Rect affected(pixels.x - m_templ.cols + 1, pixels.y - m_templ.rows + 1,
+                                    pixels.width + m_templ.cols - 1, pixels.height + m_templ.rows - 1);
+            const cv::Rect clipped = affected & responseBounds;
+            if (!clipped.empty())
+                dirty.push_back(clipped);
+        }
+
+        // Changed tiles are copied before matching, so the windows below read the new pixels
+        for (const cv::Rect &run : runs)
+        {
+            const cv::Rect pixels = TileRect(run.x, run.y, frame.size()) | TileRect(run.x + run.width - 1, run.y, frame.size());
+            frame(pixels).copyTo(m_previous(pixels));
+        }
+
+        std::vector<cv::Mat> results(dirty.size());
+        pool.ParallelFor(dirty.size(), [&](size_t i)
+                         {
+            if (stop)
+                stop->ThrowIfStopped();
+            const cv::Rect &area = dirty[i];
+            const cv::Rect window(area.x, area.y, area.width + m_templ.cols - 1, area.height + m_templ.rows - 1);
+            cv::matchTemplate(m_previous(window), m_templ, results[i], m_method); });
+
+        // Dirty areas of neighbouring rows overlap, so they are written back one at a time
+        double recomputedArea = 0;
+        for (size_t i = 0; i < dirty.size(); ++i)
+        {
+            results[i].copyTo(m_response(dirty[i]));
+            recomputedArea += dirty[i].area();
+        }
+        RecordRecomputed(std::min(1.0, recomputedArea / responseBounds.area()));
+        return m_response;
+    }
+
+    cv::Rect TileRect(int col, int row, cv::Size frameSize) const
+    {
+        const int x = col * m_tileSize;
+        const int y = row * m_tileSize;
+        return cv::Rect(x, y, std::min(m_tileSize, frameSize.width - x), std::min(m_tileSize, frameSize.height - y));
+    }
+
+    bool TileChanged(const cv::Mat &frame, const cv::Rect &tile) const
+    {
+        const size_t rowBytes = static_cast<size_t>(tile.width) * frame.elemSize();
+        for (int y = tile.y; y < tile.y + tile.height; ++y)
+        {
+            if (std::memcmp(frame.ptr(y, tile.x), m_previous.ptr(y, tile.x), rowBytes) != 0)
+                return true;
+        }
+        return false;
+    }
+
+    void RecordRecomputed(double share)
+    {
+        m_stats.recomputed = share;
+        m_stats.averageRecomputed += (share - m_stats.averageRecomputed) / static_cast<double>(m_stats.frames);
+    }
+
+    cv::Mat m_templ;
+    int m_method;
+    int m_tileSize;
+    cv::Mat m_previous;
+    cv::Mat m_response;
+    IncrementalStats m_stats;
+};
@@ -0,0 +1,163 @@
+#include <napi.h>
+#include <memory>
+#include <opencv2/core.hpp>
+#include <errors.h>
+#include <incrementalMatch.h>
+#include <peaks.h>
+#include <pixelConvert.h>
+#include <stopCondition.h>
+#include <workerPool.h>
+
+/**
+ * A template bound to a sequence of frames of one window, e.g. the frames of a CaptureStream. Each match only
+ * recomputes the parts of the response touched by tiles that changed since the previous frame.
+ */
+class IncrementalMatcher : public Napi::ObjectWrap<IncrementalMatcher>
+{
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports)
+    {
+        Napi::Function func = DefineClass(env, "IncrementalMatcher",
+                                          {InstanceMethod("match", &IncrementalMatcher::Match),
+                                           InstanceMethod("matchAll", &IncrementalMatcher::MatchAll),
+                                           InstanceMethod("stats", &IncrementalMatcher::GetStats),
+                                           InstanceMethod("reset", &IncrementalMatcher::Reset)});
+        exports.Set("IncrementalMatcher", func);
+        return exports;
+    }
+
+    /**
+     * new IncrementalMatcher(template, { method = TM_CCOEFF_NORMED, tileSize = 64 })
+     */
+    IncrementalMatcher(const Napi::CallbackInfo &info) : Napi::ObjectWrap<IncrementalMatcher>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Template image must be provided").ThrowAsJavaScriptException();
+            return;
+        }
+
+        cv::Mat templ;
+        if (!Image::ImageArgument(env, info[0], templ))
+            return;
+
+        int method = cv::TM_CCOEFF_NORMED;
+        PeakOptions unused;
+        if (!ParsePeakOptions(info, 1, method, unused))
+            return;
+
+        int tileSize = INCREMENTAL_DEFAULT_TILE_SIZE;
+        if (info.Length() > 1 && info[1].IsObject() && info[1].As<Napi::Object>().Has("tileSize"))
+        {
+            tileSize = info[1].As<Napi::Object>().Get("tileSize").ToNumber().Int32Value();
+            if (tileSize < 8)
+            {
+                Napi::TypeError::New(env, "'tileSize' must be at least 8").ThrowAsJavaScriptException();
+                return;
+            }
+        }
+
+        m_match = std::make_unique<IncrementalMatch>(templ, method, tileSize);
+    }
+
+private:
+    /**
+     * Reads the frame argument and `{ signal, timeout }` from info[1], and updates the response. Throws a JS error
+     * and returns nullptr on failure.
+     */
+    const cv::Mat *Update(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Frame must be provided").ThrowAsJavaScriptException();
+            return nullptr;
+        }
+
+        cv::Mat frame;
+        if (!Image::ImageArgument(env, info[0], frame))
+            return nullptr;
+        if (frame.channels() < m_match->Template().channels())
+        {
+            Napi::TypeError::New(env, "Frame has fewer channels than the template").ThrowAsJavaScriptException();
+            return nullptr;
+        }
+        StopCondition stop;
+        if (!ParseStopOptions(info, 1, stop))
+            return nullptr;
+
+        try
+        {
+            // BGRA frames are compared without their alpha when the template is BGR, and in gray for gray templates
+            const std::shared_ptr<WorkerPool> pool = SharedWorkerPool();
+            return &m_match->Update(ReduceChannels(frame, m_match->Template().channels()), *pool, &stop);
+        }
+        catch (const cv::Exception &e)
+        {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return nullptr;
+        }
+        catch (const OperationStopped &e)
+        {
+            StoppedError(env, e).ThrowAsJavaScriptException();
+            return nullptr;
+        }
+    }
+
+    /**
+     * match(frame, { signal, timeout }): same result as matchTemplate(frame, template, method).
+     */
+    Napi::Value Match(const Napi::CallbackInfo &info)
+    {
+        const cv::Mat *response = Update(info);
+        if (!response)
+            return info.Env().Null();
+        return ExtremesToValue(info.Env(), FindExtremes(*response));
+    }
+
+    /**
+     * matchAll(frame, { threshold, maxResults, nmsOverlap, signal, timeout }): same result as matchTemplateAll.
+     */
+    Napi::Value MatchAll(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        int method = m_match->Method();
+        PeakOptions options;
+        if (!ParsePeakOptions(info, 1, method, options))
+            return env.Null();
+        // The method is fixed when the matcher is created
+        options.lowerIsBetter = m_match->Method() == cv::TM_SQDIFF || m_match->Method() == cv::TM_SQDIFF_NORMED;
+
+        const cv::Mat *response = Update(info);
+        if (!response)
+            return env.Null();
+        return PeaksToValue(env, FindPeaks(*response, m_match->Template().size(), options));
+    }
+
+    Napi::Value GetStats(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        const IncrementalStats &stats = m_match->Stats();
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("frames", Napi::Number::New(env, static_cast<double>(stats.frames)));
+        result.Set("fullFrames", Napi::Number::New(env, static_cast<double>(stats.fullFrames)));
+        result.Set("tiles", Napi::Number::New(env, stats.tiles));
+        result.Set("changedTiles", Napi::Number::New(env, stats.changedTiles));
+        result.Set("recomputed", Napi::Number::New(env, stats.recomputed));
+        result.Set("averageRecomputed", Napi::Number::New(env, stats.averageRecomputed));
+        return result;
+    }
+
+    Napi::Value Reset(const Napi::CallbackInfo &info)
+    {
+        m_match->Reset();
+        return info.Env().Undefined();
+    }
+
+    std::unique_ptr<IncrementalMatch> m_match;
+};
@@ -2,17 +2,138 @@
 #include <Windows.h>
 #include <thread>
 #include <iostream>
-
-// Global variable to store the JavaScript callback function
-Napi::ThreadSafeFunction globalJsCallbackKeyDown;
-Napi::ThreadSafeFunction globalJsCallbackKeyUp;
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <errors.h>
+#include <spscRing.h>
+#include <stopCondition.h>
+
+// One key transition seen by the hook, as queued for the JS thread. The fields are those of KBDLLHOOKSTRUCT;
+// LLKHF_UP in `flags` tells a release from a press.
+struct KeyEvent
+{
+  uint32_t keyCode;
+  uint32_t scanCode;
+  uint32_t flags;
+  uint32_t time;
+};
+
+// Key events the hook can queue while the JS thread is busy; more are dropped and counted
+const size_t KEY_EVENT_RING_SIZE = 1024;
+// Values per event in the arrays passed to the batch handler: key code, scan code, flags, time
+const size_t KEY_EVENT_FIELDS = 4;
+// Batch handler defaults: no coalescing delay, so batches only form while the JS thread is busy
+const int DEFAULT_KEY_BATCH_INTERVAL_MS = 0;
+const int DEFAULT_KEY_BATCH_MAX_EVENTS = 256;
+
+// Filled by the hook thread, drained on the JS thread
+SpscRing<KeyEvent, KEY_EVENT_RING_SIZE> keyEventRing;
+// Wakes the JS thread to drain the ring, created with the first handler
+Napi::ThreadSafeFunction keyEventWakeup;
+Napi::FunctionReference keyDownCallback;
+Napi::FunctionReference keyUpCallback;
+Napi::FunctionReference keyBatchCallback;
+// Drained events, kept between drains so draining does not allocate
+std::vector<KeyEvent> drainedKeyEvents;
 
 // Global variable to store the previous key state
 bool isKeyPressed = false;
-bool handleKeyUp = false;
-bool handleKeyDown = false;
+std::atomic<bool> handleKeyUp{false};
+std::atomic<bool> handleKeyDown{false};
+std::atomic<bool> handleKeyBatch{false};
+std::atomic<int> keyBatchIntervalMs{DEFAULT_KEY_BATCH_INTERVAL_MS};
+std::atomic<int> keyBatchMaxEvents{DEFAULT_KEY_BATCH_MAX_EVENTS};
 bool monitorThreadRunning = false;
 int previousKeyState;
+
+// Hook thread only: events queued since the JS thread was last woken, and the timer that wakes it for a batch
+int keyBatchPending = 0;
+UINT_PTR keyBatchTimer = 0;
+
+// Runs on the JS thread; hands the queued events to the batch handler in one call, then to the per-key callbacks
+void DrainKeyEvents(Napi::Env env)
+{
+  Napi::HandleScope scope(env);
+  keyEventRing.BeginDrain();
+  drainedKeyEvents.clear();
+  keyEventRing.Drain([](const KeyEvent &event)
+                     { drainedKeyEvents.push_back(event); });
+  if (drainedKeyEvents.empty())
+    return;
+
+  if (!keyBatchCallback.IsEmpty())
+  {
+    Napi::Uint32Array batch = Napi::Uint32Array::New(env, drainedKeyEvents.size() * KEY_EVENT_FIELDS);
+    uint32_t *fields = batch.Data();
+    for (const KeyEvent &event : drainedKeyEvents)
+    {
+      *fields++ = event.keyCode;
+      *fields++ = event.scanCode;
+      *fields++ = event.flags;
+      *fields++ = event.time;
+    }
+    keyBatchCallback.Call({batch});
+  }
+
+  for (const KeyEvent &event : drainedKeyEvents)
+  {
+    Napi::FunctionReference &callback = (event.flags & LLKHF_UP) ? keyUpCallback : keyDownCallback;
+    if (!callback.IsEmpty())
+      callback.Call({Napi::Number::New(env, event.keyCode)});
+  }
+}
+
+// Hook thread: wakes the JS thread, unless a wakeup is already pending, and ends the current batch
+void WakeKeyEventDrain()
+{
+  keyBatchPending = 0;
+  if (keyBatchTimer)
+  {
+    KillTimer(NULL, keyBatchTimer);
+    keyBatchTimer = 0;
+  }
+  if (keyEventRing.RequestWakeup())
+  {
+    keyEventWakeup.NonBlockingCall([](Napi::Env env, Napi::Function)
+                                   { DrainKeyEvents(env); });
+  }
+}
+
+VOID CALLBACK KeyBatchTimerProc(HWND, UINT, UINT_PTR, DWORD)
+{
+  WakeKeyEventDrain();
+}
+
+// Runs on the hook thread, which Windows unhooks if it stalls: queues the event without blocking or allocating.
+// Per-key handlers are woken right away; a batch handler alone is woken when the batch fills or its interval,
+// counted from the first event of the batch, runs out.
+void QueueKeyEvent(const KBDLLHOOKSTRUCT &key)
+{
+  if (!keyEventRing.TryPush(KeyEvent{key.vkCode, key.scanCode, key.flags, key.time}))
+  {
+    // Dropped and counted by the ring. Only events in the ring count towards the batch; a full ring is drained now
+    WakeKeyEventDrain();
+    return;
+  }
+  ++keyBatchPending;
+
+  const int interval = keyBatchIntervalMs;
+  if (handleKeyDown || handleKeyUp || interval <= 0 || keyBatchPending >= keyBatchMaxEvents)
+  {
+    WakeKeyEventDrain();
+    return;
+  }
+  // The hook thread's message loop dispatches the timer
+  if (!keyBatchTimer)
+    keyBatchTimer = SetTimer(NULL, 0, static_cast<UINT>(interval), KeyBatchTimerProc);
+  if (!keyBatchTimer)
+    WakeKeyEventDrain();
+}
+
 LRESULT CALLBACK KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam)
 {
   if (nCode >= 0)
@@ -29,24 +150,9 @@ LRESULT CALLBACK KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam)
       {
         isKeyPressed = true;
         previousKeyState = keyCode;
-        if (handleKeyDown)
+        if (handleKeyDown || handleKeyBatch)
         {
-          int *keyCodeCopy = new int(keyCode); // Create a copy of the keyCode value
-
-          napi_status status = globalJsCallbackKeyDown.BlockingCall(
-              keyCodeCopy,
-              [](Napi::Env env, Napi::Function jsCallback, int *keyCodePtr)
-              {
-                Napi::HandleScope scope(env);
-                int keyCode = *keyCodePtr;
-                jsCallback.Call({Napi::Number::New(env, keyCode)});
-                delete keyCodePtr; // Clean up the dynamically allocated keyCode copy
-              });
-
-          if (status != napi_ok)
-          {
-            // Handle the error
-          }
+          QueueKeyEvent(*kbdStruct);
         }
       }
     }
@@ -58,23 +164,9 @@ LRESULT CALLBACK KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam)
       if (keyCode == previousKeyState)
       {
         isKeyPressed = false;
-        if (handleKeyUp)
+        if (handleKeyUp || handleKeyBatch)
         {
-          int *keyCodeCopy = new int(keyCode); // Create a copy of the keyCode value
-          napi_status status = globalJsCallbackKeyUp.BlockingCall(
-              keyCodeCopy,
-              [](Napi::Env env, Napi::Function jsCallback, int *keyCodePtr)
-              {
-                Napi::HandleScope scope(env);
-                int keyCode = *keyCodePtr;
-                jsCallback.Call({Napi::Number::New(env, keyCode)});
-                delete keyCodePtr; // Clean up the dynamically allocated keyCode copy
-              });
-
-          if (status != napi_ok)
-          {
-            // Handle the error
-          }
+          QueueKeyEvent(*kbdStruct);
         }
       }
     }
@@ -104,33 +196,30 @@ void MonitorKeyboardEvents()
   UnhookWindowsHookEx(keyboardHook);
 }
 
+// Creates the wakeup and starts the hook thread on first use
+void StartKeyboardMonitor(Napi::Env env)
+{
+  if (monitorThreadRunning)
+    return;
+
+  drainedKeyEvents.reserve(KEY_EVENT_RING_SIZE);
+  keyEventWakeup = Napi::ThreadSafeFunction::New(env, Napi::Function(), "KeyEventWakeup", 0, 1);
+  std::thread monitorThread(MonitorKeyboardEvents);
+  monitorThread.detach();
+  monitorThreadRunning = true;
+}
+
 // Function called from JavaScript to set the callback function
 Napi::Value SetKeyDownCallback(const Napi::CallbackInfo &info)
 {
   Napi::Env env = info.Env();
 
   // Get the callback function from the arguments
-  Napi::Function jsCallback = info[0].As<Napi::Function>();
-
-  // Create a ThreadSafeFunction with the JavaScript callback
-  globalJsCallbackKeyDown = Napi::ThreadSafeFunction::New(
-      env,
-      jsCallback,
-      "KeyDownCallback",
-      0,
-      1,
-      [](Napi::Env)
-      {
-        // Finalizer callback (optional)
-      });
+  keyDownCallback = Napi::Persistent(info[0].As<Napi::Function>());
+  // Lives until the process exits, when the environment may already be gone
+  keyDownCallback.SuppressDestruct();
   handleKeyDown = true;
-  if (!monitorThreadRunning)
-  {
-    std::thread monitorThread(MonitorKeyboardEvents);
-    monitorThread.detach();
-
-    monitorThreadRunning = true;
-  }
+  StartKeyboardMonitor(env);
 
   return env.Undefined();
 }
@@ -141,44 +230,74 @@ Napi::Value SetKeyUpCallback(const Napi::CallbackInfo &info)
   Napi::Env env = info.Env();
 
   // Get the callback function from the arguments
-  Napi::Function jsCallback = info[0].As<Napi::Function>();
-
-  // Create a ThreadSafeFunction with the JavaScript callback
-  globalJsCallbackKeyUp = Napi::ThreadSafeFunction::New(
-      env,
-      jsCallback,
-      "KeyUpCallback",
-      0,
-      1,
-      [](Napi::Env)
-      {
-        // Finalizer callback (optional)
-      });
+  keyUpCallback = Napi::Persistent(info[0].As<Napi::Function>());
+  keyUpCallback.SuppressDestruct();
   handleKeyUp = true;
-  if (!monitorThreadRunning)
-  {
-    std::thread monitorThread(MonitorKeyboardEvents);
-    monitorThread.detach();
-    monitorThreadRunning = true;
-  }
+  StartKeyboardMonitor(env);
+
   return env.Undefined();
 }
 
-Napi::Value TypeString(const Napi::CallbackInfo &info) {
-    Napi::Env env = info.Env();
+/**
+ * keyBatchHandler(callback, { interval = 0, maxEvents = 256 }): delivers key events in batches instead of one call
+ * per key. The callback gets a Uint32Array of [keyCode, scanCode, flags, time] per event, oldest first; LLKHF_UP
+ * (0x80) in flags marks a release. A batch is delivered `interval` ms after its first event or once it holds
+ * `maxEvents` events, whichever comes first. While a keyDown or keyUp handler is also set, every event wakes the
+ * JS thread, so batches only hold what queued up while it was busy.
+ */
+Napi::Value SetKeyBatchCallback(const Napi::CallbackInfo &info)
+{
+  Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsString()) {
-        Napi::TypeError::New(env, "You should provide a string to type").ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
-    }
+  if (info.Length() < 1 || !info[0].IsFunction())
+  {
+    Napi::TypeError::New(env, "You should provide a callback function").ThrowAsJavaScriptException();
+    return env.Null();
+  }
 
-    int delay = 15;
-    std::u16string text = info[0].As<Napi::String>().Utf16Value();
-    if (info.Length() > 1 && info[1].IsNumber()) {
-        delay = info[1].As<Napi::Number>().Int32Value();
-    }
+  int interval = DEFAULT_KEY_BATCH_INTERVAL_MS;
+  int maxEvents = DEFAULT_KEY_BATCH_MAX_EVENTS;
+  if (info.Length() > 1 && info[1].IsObject())
+  {
+    Napi::Object optionsObj = info[1].As<Napi::Object>();
+    if (optionsObj.Get("interval").IsNumber())
+      interval = optionsObj.Get("interval").ToNumber().Int32Value();
+    if (optionsObj.Get("maxEvents").IsNumber())
+      maxEvents = optionsObj.Get("maxEvents").ToNumber().Int32Value();
+  }
+  if (interval < 0 || maxEvents < 1 || maxEvents > static_cast<int>(KEY_EVENT_RING_SIZE))
+  {
+    Napi::TypeError::New(env, "'interval' must be non-negative and 'maxEvents' from 1 to " + std::to_string(KEY_EVENT_RING_SIZE)).ThrowAsJavaScriptException();
+    return env.Null();
+  }
 
+  keyBatchCallback = Napi::Persistent(info[0].As<Napi::Function>());
+  keyBatchCallback.SuppressDestruct();
+  keyBatchIntervalMs = interval;
+  keyBatchMaxEvents = maxEvents;
+  handleKeyBatch = true;
+  StartKeyboardMonitor(env);
+
+  return env.Undefined();
+}
+
+/**
+ * getDroppedKeyEvents(): key events dropped so far because the JS thread fell more than KEY_EVENT_RING_SIZE
+ * events behind.
+ */
+Napi::Value GetDroppedKeyEvents(const Napi::CallbackInfo &info)
+{
+  return Napi::Number::New(info.Env(), static_cast<double>(keyEventRing.Overflow()));
+}
+
+/**
+ * Types `text` as Unicode key events, waiting `delay` ms after each character. Checks `stop` before every
+ * character, so a stopped call has typed a prefix of the text.
+ */
+void TypeText(const std::u16string &text, int delay, const StopCondition &stop) {
     for (const auto &character : text) {
+        stop.ThrowIfStopped();
+
         INPUT keyboardInput = {0};
         keyboardInput.type = INPUT_KEYBOARD;
         keyboardInput.ki.wVk = 0;
@@ -195,12 +314,77 @@ Napi::Value TypeString(const Napi::CallbackInfo &info) {
         SendInput(1, &keyboardInput, sizeof(INPUT));
 
         // Sleep for the specified delay between keystrokes
-        Sleep(delay);
+        stop.SleepFor(std::chrono::milliseconds(delay));
+    }
+}
+
+/**
+ * Reads (text, delay = 15, options) for typeString and typeStringAsync. Throws a TypeError and returns false on bad input.
+ */
+bool ParseTypeArgs(const Napi::CallbackInfo &info, std::u16string &text, int &delay, StopCondition &stop) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "You should provide a string to type").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    delay = 15;
+    text = info[0].As<Napi::String>().Utf16Value();
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        delay = info[1].As<Napi::Number>().Int32Value();
+    }
+
+    return ParseStopOptions(info, 2, stop);
+}
+
+/**
+ * typeString(text, delay = 15, { timeout }): types the text. Throws an ERR_DEADLINE_EXCEEDED error once typing
+ * takes longer than `timeout` ms.
+ */
+Napi::Value TypeString(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+
+    std::u16string text;
+    int delay;
+    StopCondition stop;
+    if (!ParseTypeArgs(info, text, delay, stop)) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    try {
+        TypeText(text, delay, stop);
+    } catch (const OperationStopped &e) {
+        StoppedError(env, e).ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
     }
 
     return Napi::Boolean::New(env, true);
 }
 
+/**
+ * typeStringAsync(text, delay = 15, { signal, timeout }): typeString on a worker thread. Resolves with true, or
+ * rejects with an ERR_CANCELLED or ERR_DEADLINE_EXCEEDED error once the signal aborts or the timeout passes.
+ */
+Napi::Value TypeStringAsync(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+
+    std::u16string text;
+    int delay;
+    StopCondition stop;
+    if (!ParseTypeArgs(info, text, delay, stop)) {
+        return env.Null();
+    }
+
+    std::unique_ptr<AbortListener> listener = AbortListener::Attach(env, info.Length() > 2 ? info[2] : env.Undefined(), stop);
+    StoppableWorker *worker = new StoppableWorker(
+        env, "TypeString", stop, [text, delay](const StopCondition &stop) { TypeText(text, delay, stop); },
+        std::move(listener));
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
 // Function to simulate key press and release using provided key code
 Napi::Value PressKey(const Napi::CallbackInfo &info)
 {
@@ -1,29 +1,69 @@
 #include <napi.h>
 #include <helpers.cpp>
+#include <imageData.cpp>
+#include <captureOutput.cpp>
 #include <captureWindow.cpp>
+#include <captureAsync.cpp>
+#include <captureSession.cpp>
+#include <captureStream.cpp>
 #include <getWindowData.cpp>
+#include <cancellation.cpp>
 #include <keyboard.cpp>
 #include <mouse.cpp>
 #include <opencv.cpp>
+#include <image.cpp>
+#include <matching.cpp>
+#include <templateBank.cpp>
+#include <template.cpp>
+#include <pixelSignature.cpp>
+#include <incrementalMatcher.cpp>
+#include <pipeline.cpp>
+#include <opencvAsync.cpp>
 
 Napi::Object Init(Napi::Env env, Napi::Object exports)
 {
     exports.Set("getWindowData", Napi::Function::New(env, GetWindowData));
     exports.Set("captureWindowN", Napi::Function::New(env, CaptureWindow));
+    exports.Set("captureWindowAsync", Napi::Function::New(env, CaptureWindowAsync));
     exports.Set("keyDownHandler", Napi::Function::New(env, SetKeyDownCallback));
     exports.Set("keyUpHandler", Napi::Function::New(env, SetKeyUpCallback));
+    exports.Set("keyBatchHandler", Napi::Function::New(env, SetKeyBatchCallback));
+    exports.Set("getDroppedKeyEvents", Napi::Function::New(env, GetDroppedKeyEvents));
     exports.Set("mouseMove", Napi::Function::New(env, MoveMouse));
     exports.Set("mouseClick", Napi::Function::New(env, ClickMouse));
     exports.Set("mouseDrag", Napi::Function::New(env, DragMouse));
+    exports.Set("mouseDragAsync", Napi::Function::New(env, DragMouseAsync));
     exports.Set("typeString", Napi::Function::New(env, TypeString));
+    exports.Set("typeStringAsync", Napi::Function::New(env, TypeStringAsync));
     exports.Set("pressKey", Napi::Function::New(env, PressKey));
     exports.Set("imread", Napi::Function::New(env, Imread));
     exports.Set("imwrite", Napi::Function::New(env, Imwrite));
     exports.Set("matchTemplate", Napi::Function::New(env, MatchTemplate));
+    exports.Set("matchTemplateAll", Napi::Function::New(env, MatchTemplateAll));
+    exports.Set("matchTemplates", Napi::Function::New(env, MatchTemplates));
+    exports.Set("matchBinary", Napi::Function::New(env, MatchBinary));
+    exports.Set("matchSignatures", Napi::Function::New(env, MatchSignatures));
     exports.Set("blur", Napi::Function::New(env, Blur));
     exports.Set("bgrToGray", Napi::Function::New(env, BgrToGray));
     exports.Set("drawRectangle", Napi::Function::New(env, DrawRectangle));
     exports.Set("getRegion", Napi::Function::New(env, GetRegion));
+    exports.Set("imreadAsync", Napi::Function::New(env, ImreadAsync));
+    exports.Set("imwriteAsync", Napi::Function::New(env, ImwriteAsync));
+    exports.Set("matchTemplateAsync", Napi::Function::New(env, MatchTemplateAsync));
+    exports.Set("blurAsync", Napi::Function::New(env, BlurAsync));
+    exports.Set("bgrToGrayAsync", Napi::Function::New(env, BgrToGrayAsync));
+    exports.Set("drawRectangleAsync", Napi::Function::New(env, DrawRectangleAsync));
+    exports.Set("getRegionAsync", Napi::Function::New(env, GetRegionAsync));
+    exports.Set("setWorkerThreads", Napi::Function::New(env, SetWorkerThreads));
+    exports.Set("getWorkerThreads", Napi::Function::New(env, GetWorkerThreads));
+    CaptureSession::Init(env, exports);
+    CaptureStream::Init(env, exports);
+    Image::Init(env, exports);
+    TemplateBank::Init(env, exports);
+    Template::Init(env, exports);
+    PixelSignature::Init(env, exports);
+    IncrementalMatcher::Init(env, exports);
+    Pipeline::Init(env, exports);
     return exports;
 }
 
@@ -0,0 +1,373 @@
+#include <napi.h>
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <binaryMatch.h>
+#include <errors.h>
+#include <peaks.h>
+#include <pixelConvert.h>
+#include <searchRegions.h>
+#include <stopCondition.h>
+#include <tiledMatch.h>
+#include <templateSpectrum.h>
+#include <templateStats.h>
+
+/**
+ * Reads `{ method, threshold, maxResults, nmsOverlap }` from an options object.
+ * Throws a TypeError and returns false on bad input.
+ */
+bool ParsePeakOptions(Napi::Env env, const Napi::Object &optionsObj, int &method, PeakOptions &options)
+{
+    if (optionsObj.Has("method") && optionsObj.Get("method").IsNumber())
+        method = optionsObj.Get("method").ToNumber().Int32Value();
+    if (method < cv::TM_SQDIFF || method > cv::TM_CCOEFF_NORMED)
+    {
+        Napi::TypeError::New(env, "Invalid template matching method").ThrowAsJavaScriptException();
+        return false;
+    }
+    options.lowerIsBetter = method == cv::TM_SQDIFF || method == cv::TM_SQDIFF_NORMED;
+
+    if (optionsObj.Has("threshold") && optionsObj.Get("threshold").IsNumber())
+        options.threshold = optionsObj.Get("threshold").ToNumber().DoubleValue();
+
+    if (optionsObj.Has("maxResults") && !optionsObj.Get("maxResults").IsUndefined())
+    {
+        int maxResults = optionsObj.Get("maxResults").ToNumber().Int32Value();
+        if (maxResults < 1)
+        {
+            Napi::TypeError::New(env, "'maxResults' must be at least 1").ThrowAsJavaScriptException();
+            return false;
+        }
+        options.maxResults = static_cast<size_t>(maxResults);
+    }
+
+    if (optionsObj.Has("nmsOverlap") && optionsObj.Get("nmsOverlap").IsNumber())
+        options.nmsOverlap = optionsObj.Get("nmsOverlap").ToNumber().DoubleValue();
+
+    return true;
+}
+
+/**
+ * Reads `{ method, threshold, maxResults, nmsOverlap }` from info[index] if present.
+ * Throws a TypeError and returns false on bad input.
+ */
+bool ParsePeakOptions(const Napi::CallbackInfo &info, size_t index, int &method, PeakOptions &options)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() <= index || info[index].IsUndefined() || info[index].IsNull())
+        return true;
+
+    if (!info[index].IsObject())
+    {
+        Napi::TypeError::New(env, "Match options must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    return ParsePeakOptions(env, info[index].As<Napi::Object>(), method, options);
+}
+
+/**
+ * Packs matches into `{ count, x: Int32Array, y: Int32Array, score: Float32Array }`.
+ */
+Napi::Object PeaksToValue(Napi::Env env, const std::vector<Peak> &peaks)
+{
+    Napi::Int32Array xs = Napi::Int32Array::New(env, peaks.size());
+    Napi::Int32Array ys = Napi::Int32Array::New(env, peaks.size());
+    Napi::Float32Array scores = Napi::Float32Array::New(env, peaks.size());
+    for (size_t i = 0; i < peaks.size(); ++i)
+    {
+        xs[i] = peaks[i].x;
+        ys[i] = peaks[i].y;
+        scores[i] = peaks[i].score;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("count", Napi::Number::New(env, static_cast<double>(peaks.size())));
+    result.Set("x", xs);
+    result.Set("y", ys);
+    result.Set("score", scores);
+    return result;
+}
+
+/**
+ * matchTemplateAll(image, template, options): every match of the template passing the threshold, best first.
+ * `signal` and `timeout` are checked between search regions and tiles.
+ */
+Napi::Value MatchTemplateAll(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2)
+    {
+        Napi::TypeError::New(env, "Invalid arguments. Expected: (image, template[, options])").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    cv::Mat src, templ;
+    if (!Image::ImageArgument(env, info[0], src) || !Image::ImageArgument(env, info[1], templ))
+        return env.Null();
+
+    int method = cv::TM_CCOEFF_NORMED;
+    PeakOptions options;
+    if (!ParsePeakOptions(info, 2, method, options))
+        return env.Null();
+
+    std::vector<cv::Rect> regions;
+    TileOptions tileOptions;
+    if (info.Length() > 2 && info[2].IsObject() &&
+        (!ParseSearchRegions(env, info[2].As<Napi::Object>(), regions) || !ParseTileOptions(env, info[2].As<Napi::Object>(), tileOptions)))
+        return env.Null();
+    StopCondition stop;
+    if (!ParseStopOptions(info, 2, stop))
+        return env.Null();
+
+    const std::vector<cv::Rect> windows = SearchWindows(src.size(), templ.size(), regions);
+    if (windows.empty())
+    {
+        Napi::TypeError::New(env, "No search region is large enough for the template").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // Peaks are collected per region in full-image coordinates, so a hit inside two overlapping regions is merged
+    std::vector<Peak> candidates;
+    try
+    {
+        // Like matchTemplate: BGRA is matched without its alpha against a BGR template, and in gray against a gray one
+        const int channels = CommonChannels(src, templ);
+        src = ReduceChannels(src, channels);
+        templ = ReduceChannels(templ, channels);
+
+        cv::Mat response;
+        for (const cv::Rect &window : windows)
+        {
+            stop.ThrowIfStopped();
+            const size_t first = candidates.size();
+            if (tileOptions.tiles != 0)
+            {
+                const std::shared_ptr<WorkerPool> pool = SharedWorkerPool();
+                std::vector<Peak> peaks = TiledCollectPeaks(src(window), templ, method, options, tileOptions, *pool, &stop);
+                candidates.insert(candidates.end(), peaks.begin(), peaks.end());
+            }
+            else
+            {
+                cv::matchTemplate(src(window), templ, response, method);
+                CollectPeaks(response, templ.size(), options, candidates);
+            }
+            for (size_t i = first; i < candidates.size(); ++i)
+            {
+                candidates[i].x += window.x;
+                candidates[i].y += window.y;
+            }
+            if (tileOptions.anyMatch && !candidates.empty())
+                break;
+        }
+    }
+    catch (const cv::Exception &e)
+    {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    catch (const OperationStopped &e)
+    {
+        StoppedError(env, e).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return PeaksToValue(env, SuppressOverlaps(std::move(candidates), options));
+}
+
+/**
+ * matchBinary(image, template, { level = 127, threshold = 0.9, maxResults, nmsOverlap, signal, timeout }): every
+ * match of a thresholded template in a thresholded image, scored by the fraction of pixels that agree. Color images
+ * are turned gray first; pixels above `level` count as set.
+ */
+Napi::Value MatchBinary(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2)
+    {
+        Napi::TypeError::New(env, "Invalid arguments. Expected: (image, template[, options])").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    cv::Mat src, templ;
+    if (!Image::ImageArgument(env, info[0], src) || !Image::ImageArgument(env, info[1], templ))
+        return env.Null();
+
+    int method = cv::TM_CCOEFF_NORMED;
+    PeakOptions options;
+    options.threshold = 0.9;
+    if (!ParsePeakOptions(info, 2, method, options))
+        return env.Null();
+    // Scores are agreement fractions whatever the method option says
+    options.lowerIsBetter = false;
+
+    int level = 127;
+    if (info.Length() > 2 && info[2].IsObject() && info[2].As<Napi::Object>().Has("level"))
+    {
+        level = info[2].As<Napi::Object>().Get("level").ToNumber().Int32Value();
+        if (level < 0 || level > 255)
+        {
+            Napi::TypeError::New(env, "'level' must be between 0 and 255").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+    StopCondition stop;
+    if (!ParseStopOptions(info, 2, stop))
+        return env.Null();
+
+    try
+    {
+        return PeaksToValue(env, BinaryMatchTemplate(ReduceChannels(src, 1), ReduceChannels(templ, 1), level, options, &stop));
+    }
+    catch (const cv::Exception &e)
+    {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    catch (const OperationStopped &e)
+    {
+        StoppedError(env, e).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+/**
+ * Packs one row per template into `{ count, minValue, maxValue: Float64Array, minX, minY, maxX, maxY: Int32Array }`.
+ */
+Napi::Object MatchTableToValue(Napi::Env env, const std::vector<MatchExtremes> &rows)
+{
+    Napi::Float64Array minValues = Napi::Float64Array::New(env, rows.size());
+    Napi::Float64Array maxValues = Napi::Float64Array::New(env, rows.size());
+    Napi::Int32Array minXs = Napi::Int32Array::New(env, rows.size());
+    Napi::Int32Array minYs = Napi::Int32Array::New(env, rows.size());
+    Napi::Int32Array maxXs = Napi::Int32Array::New(env, rows.size());
+    Napi::Int32Array maxYs = Napi::Int32Array::New(env, rows.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        minValues[i] = rows[i].minValue;
+        maxValues[i] = rows[i].maxValue;
+        minXs[i] = rows[i].minLocation.x;
+        minYs[i] = rows[i].minLocation.y;
+        maxXs[i] = rows[i].maxLocation.x;
+        maxYs[i] = rows[i].maxLocation.y;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("count", Napi::Number::New(env, static_cast<double>(rows.size())));
+    result.Set("minValue", minValues);
+    result.Set("maxValue", maxValues);
+    result.Set("minX", minXs);
+    result.Set("minY", minYs);
+    result.Set("maxX", maxXs);
+    result.Set("maxY", maxYs);
+    return result;
+}
+
+/**
+ * Whether matchTemplates correlates `templ` against the image's shared DFT instead of calling cv::matchTemplate.
+ */
+inline bool UsesSharedSpectrum(const cv::Mat &templ)
+{
+    return templ.total() >= static_cast<size_t>(SHARED_DFT_MIN_TEMPLATE_AREA);
+}
+
+/**
+ * matchTemplates(image, templates[], { method, signal, timeout }): matches every template against the same image in
+ * one call. Templates may have other channel counts than the image; each is compared at the channels both share.
+ * The image's integral images, and its DFT for large templates, are computed once per channel count and shared, and
+ * templates are matched in parallel.
+ * `signal` and `timeout` are checked before each template.
+ */
+Napi::Value MatchTemplates(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[1].IsArray())
+    {
+        Napi::TypeError::New(env, "Invalid arguments. Expected: (image, templates[, options])").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    cv::Mat src;
+    if (!Image::ImageArgument(env, info[0], src))
+        return env.Null();
+
+    Napi::Array templArray = info[1].As<Napi::Array>();
+    std::vector<cv::Mat> templates(templArray.Length());
+    for (uint32_t i = 0; i < templArray.Length(); ++i)
+    {
+        if (!Image::ImageArgument(env, templArray.Get(i), templates[i]))
+            return env.Null();
+        if (templates[i].depth() != src.depth() || templates[i].cols > src.cols || templates[i].rows > src.rows)
+        {
+            Napi::TypeError::New(env, "Templates must have the image's depth and fit inside it").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    int method = cv::TM_CCOEFF_NORMED;
+    PeakOptions unused;
+    StopCondition stop;
+    if (!ParsePeakOptions(info, 2, method, unused) || !ParseStopOptions(info, 2, stop))
+        return env.Null();
+
+    std::vector<MatchExtremes> rows(templates.size());
+    try
+    {
+        // Each template is compared at the channels it shares with the image; the image is reduced, its statistics
+        // computed and, if a large template needs it, its DFT taken once per channel count rather than per template
+        std::vector<int> channels(templates.size());
+        cv::Mat sources[5];
+        SourceStats srcStats[5];
+        std::unique_ptr<SourceSpectrum> spectra[5];
+        for (size_t i = 0; i < templates.size(); ++i)
+        {
+            const int count = channels[i] = CommonChannels(src, templates[i]);
+            if (sources[count].empty())
+            {
+                sources[count] = ReduceChannels(src, count);
+                if (MethodNeedsSourceStats(method))
+                    srcStats[count] = ComputeSourceStats(sources[count]);
+            }
+            if (!spectra[count] && UsesSharedSpectrum(templates[i]))
+                spectra[count] = std::make_unique<SourceSpectrum>(sources[count]);
+            stop.ThrowIfStopped();
+        }
+
+        cv::parallel_for_(cv::Range(0, static_cast<int>(templates.size())), [&](const cv::Range &range)
+                          {
+            cv::Mat result;
+            for (int i = range.start; i < range.end && !stop.ShouldStop(); ++i)
+            {
+                const int count = channels[i];
+                const cv::Mat templ = ReduceChannels(templates[i], count);
+                if (UsesSharedSpectrum(templ))
+                {
+                    spectra[count]->Correlate(templ, result);
+                    NormalizeCorrelation(result, srcStats[count], ComputeTemplateStats(templ), method);
+                }
+                else
+                {
+                    MatchWithStats(sources[count], srcStats[count], templ, ComputeTemplateStats(templ), method, result);
+                }
+                rows[i] = FindExtremes(result);
+            } });
+        stop.ThrowIfStopped();
+    }
+    catch (const cv::Exception &e)
+    {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    catch (const OperationStopped &e)
+    {
+        StoppedError(env, e).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return MatchTableToValue(env, rows);
+}
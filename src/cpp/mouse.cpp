@@ -1,6 +1,10 @@
 // patrially used code from https://github.com/octalmage/robotjs witch is under MIT License Copyright (c) 2014 Jason Stallings
 #include <napi.h>
+#include <chrono>
+#include <memory>
 #include <windows.h>
+#include <errors.h>
+#include <stopCondition.h>
 /**
  * Move the mouse to a specific point.
  * @param point The coordinates to move the mouse to (x, y).
@@ -81,25 +85,13 @@ Napi::Value ClickMouse(const Napi::CallbackInfo &info)
     return Napi::Boolean::New(env, true);
 }
 
-Napi::Value DragMouse(const Napi::CallbackInfo &info)
+/**
+ * Presses the left button at the start, moves to the end in 100 steps and releases the button. Checks `stop`
+ * before every step; when it stops, the button is released where the cursor is and OperationStopped is rethrown.
+ */
+void DragPath(int startX, int startY, int endX, int endY, int speed, const StopCondition &stop)
 {
-    Napi::Env env = info.Env();
-
-    if (info.Length() < 4 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber())
-    {
-        Napi::TypeError::New(env, "You should provide startX, startY, endX, endY").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-
-    int startX = info[0].As<Napi::Number>();
-    int startY = info[1].As<Napi::Number>();
-    int endX = info[2].As<Napi::Number>();
-    int endY = info[3].As<Napi::Number>();
-    int speed = 100;
-    if (info.Length() > 4 && info[4].IsNumber())
-    {
-        speed = info[4].As<Napi::Number>();
-    }
+    stop.ThrowIfStopped();
 
     // Get the screen metrics
     int screenWidth = GetSystemMetrics(SM_CXSCREEN);
@@ -135,6 +127,11 @@ Napi::Value DragMouse(const Napi::CallbackInfo &info)
 
     SendInput(1, &mouseDownInput, sizeof(mouseDownInput));
 
+    INPUT mouseUpInput = {0};
+    mouseUpInput.type = INPUT_MOUSE;
+    mouseUpInput.mi.dwFlags = MOUSEEVENTF_LEFTUP;
+    mouseUpInput.mi.time = 0; // System will provide the timestamp
+
     // Calculate the number of steps based on the duration and desired speed
     const int steps = 100; // Adjust the number of steps for smoother movement
 
@@ -142,34 +139,114 @@ Napi::Value DragMouse(const Napi::CallbackInfo &info)
     double stepX = distanceX / steps;
     double stepY = distanceY / steps;
 
-    // Move the mouse in increments to simulate dragging with speed control
-    for (int i = 0; i < steps; ++i)
+    try
+    {
+        // Move the mouse in increments to simulate dragging with speed control
+        for (int i = 0; i < steps; ++i)
+        {
+            // Calculate the position for the current step
+            int currentX = static_cast<int>(absoluteStartX + (stepX * i));
+            int currentY = static_cast<int>(absoluteStartY + (stepY * i));
+
+            // Move the mouse to the current position
+            INPUT mouseMoveInput = {0};
+            mouseMoveInput.type = INPUT_MOUSE;
+            mouseMoveInput.mi.dx = currentX;
+            mouseMoveInput.mi.dy = currentY;
+            mouseMoveInput.mi.dwFlags = MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_MOVE | MOUSEEVENTF_VIRTUALDESK;
+            mouseMoveInput.mi.time = 0; // System will provide the timestamp
+
+            SendInput(1, &mouseMoveInput, sizeof(mouseMoveInput));
+
+            // Sleep for a short duration to control the speed
+            stop.SleepFor(std::chrono::milliseconds(static_cast<long long>(duration / steps)));
+        }
+    }
+    catch (const OperationStopped &)
     {
-        // Calculate the position for the current step
-        int currentX = static_cast<int>(absoluteStartX + (stepX * i));
-        int currentY = static_cast<int>(absoluteStartY + (stepY * i));
-
-        // Move the mouse to the current position
-        INPUT mouseMoveInput = {0};
-        mouseMoveInput.type = INPUT_MOUSE;
-        mouseMoveInput.mi.dx = currentX;
-        mouseMoveInput.mi.dy = currentY;
-        mouseMoveInput.mi.dwFlags = MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_MOVE | MOUSEEVENTF_VIRTUALDESK;
-        mouseMoveInput.mi.time = 0; // System will provide the timestamp
-
-        SendInput(1, &mouseMoveInput, sizeof(mouseMoveInput));
-
-        // Sleep for a short duration to control the speed
-        Sleep(static_cast<DWORD>(duration / steps));
+        // Never leave the button held down
+        SendInput(1, &mouseUpInput, sizeof(mouseUpInput));
+        throw;
     }
 
     // Perform mouse button up event
-    INPUT mouseUpInput = {0};
-    mouseUpInput.type = INPUT_MOUSE;
-    mouseUpInput.mi.dwFlags = MOUSEEVENTF_LEFTUP;
-    mouseUpInput.mi.time = 0; // System will provide the timestamp
-
     SendInput(1, &mouseUpInput, sizeof(mouseUpInput));
+}
+
+/**
+ * Reads (startX, startY, endX, endY, speed = 100, options) for mouseDrag and mouseDragAsync.
+ * Throws a TypeError and returns false on bad input.
+ */
+bool ParseDragArgs(const Napi::CallbackInfo &info, int coords[4], int &speed, StopCondition &stop)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 4 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber())
+    {
+        Napi::TypeError::New(env, "You should provide startX, startY, endX, endY").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    for (int i = 0; i < 4; ++i)
+        coords[i] = info[i].As<Napi::Number>();
+    speed = 100;
+    if (info.Length() > 4 && info[4].IsNumber())
+    {
+        speed = info[4].As<Napi::Number>();
+    }
+
+    return ParseStopOptions(info, 5, stop);
+}
+
+/**
+ * mouseDrag(startX, startY, endX, endY, speed = 100, { timeout }): drags with the left button held. Throws an
+ * ERR_DEADLINE_EXCEEDED error, after releasing the button, if the drag takes longer than `timeout` ms.
+ */
+Napi::Value DragMouse(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    int coords[4];
+    int speed;
+    StopCondition stop;
+    if (!ParseDragArgs(info, coords, speed, stop))
+        return env.Null();
+
+    try
+    {
+        DragPath(coords[0], coords[1], coords[2], coords[3], speed, stop);
+    }
+    catch (const OperationStopped &e)
+    {
+        StoppedError(env, e).ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
     return Napi::Boolean::New(env, true);
 }
+
+/**
+ * mouseDragAsync(startX, startY, endX, endY, speed = 100, { signal, timeout }): mouseDrag on a worker thread.
+ * Resolves with true, or rejects with an ERR_CANCELLED or ERR_DEADLINE_EXCEEDED error once the signal aborts or
+ * the timeout passes, with the button released.
+ */
+Napi::Value DragMouseAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    int coords[4];
+    int speed;
+    StopCondition stop;
+    if (!ParseDragArgs(info, coords, speed, stop))
+        return env.Null();
+
+    std::unique_ptr<AbortListener> listener = AbortListener::Attach(env, info.Length() > 5 ? info[5] : env.Undefined(), stop);
+    const int startX = coords[0], startY = coords[1], endX = coords[2], endY = coords[3];
+    StoppableWorker *worker = new StoppableWorker(
+        env, "MouseDrag", stop, [startX, startY, endX, endY, speed](const StopCondition &stop)
+        { DragPath(startX, startY, endX, endY, speed, stop); },
+        std::move(listener));
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
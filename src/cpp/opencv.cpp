@@ -1,8 +1,17 @@
-#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 #include <napi.h>
+#include <errors.h>
+#include <peaks.h>
+#include <pixelConvert.h>
+#include <pyramidMatch.h>
+#include <searchRegions.h>
+#include <stopCondition.h>
+#include <tiledMatch.h>
 
 Napi::Value Imread(const Napi::CallbackInfo &info)
 {
@@ -30,208 +39,309 @@ Napi::Value Imread(const Napi::CallbackInfo &info)
         return env.Null();
     }
 
-    // Create a new Uint8Array with the correct size
-
-    size_t totalBytes = image.total() * image.elemSize();
-    Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, totalBytes);
-    Napi::Uint8Array uint8Array = Napi::Uint8Array::New(env, totalBytes, arrayBuffer, 0);
+    // The decoded pixels are handed to JS as they are, without a copy
+    return MatToImageData(env, image);
+}
 
-    // Copy the image data to the Uint8Array
-    memcpy(uint8Array.Data(), image.data, totalBytes);
-    // std::cout << totalBytes << std::endl;
-    // std::cout << uint8Array.ByteLength() << std::endl;
-    // Create a JavaScript object with 'width', 'height', and 'data' properties
-    Napi::Object result = Napi::Object::New(env);
+/**
+ * Turns the extremes of a matchTemplate response into { minValue, maxValue, minLocation, maxLocation }.
+ */
+Napi::Object ExtremesToValue(Napi::Env env, const MatchExtremes &extremes)
+{
+    Napi::Object matchResult = Napi::Object::New(env);
+    matchResult.Set("minValue", extremes.minValue);
+    matchResult.Set("maxValue", extremes.maxValue);
+    Napi::Object minLocation = Napi::Object::New(env);
+    minLocation.Set("x", Napi::Number::New(env, extremes.minLocation.x));
+    minLocation.Set("y", Napi::Number::New(env, extremes.minLocation.y));
+    matchResult.Set("minLocation", minLocation);
 
-    result.Set("width", image.cols);
-    result.Set("height", image.rows);
-    result.Set("data", uint8Array);
+    Napi::Object maxLocation = Napi::Object::New(env);
+    maxLocation.Set("x", Napi::Number::New(env, extremes.maxLocation.x));
+    maxLocation.Set("y", Napi::Number::New(env, extremes.maxLocation.y));
+    matchResult.Set("maxLocation", maxLocation);
 
-    return result;
+    return matchResult;
 }
 
-Napi::Value Imwrite(const Napi::CallbackInfo &info)
+/**
+ * Search settings of a single matchTemplate call, on top of the method and mask.
+ */
+struct MatchOptions
 {
-    Napi::Env env = info.Env();
-
-    if (info.Length() < 1 || !info[0].IsObject())
+    PyramidOptions pyramid;
+    // Parts of the image to search, in image coordinates. Empty searches the whole image.
+    std::vector<cv::Rect> regions;
+    TileOptions tiles;
+    // Checked between search regions, tiles and pyramid candidates. Only read from the arguments of a call.
+    StopCondition stop;
+};
+
+/**
+ * Reads `tiles: true | count` and `anyMatch` from a match options object. Throws a TypeError and returns false on bad input.
+ */
+bool ParseTileOptions(Napi::Env env, const Napi::Object &optionsObj, TileOptions &options)
+{
+    if (optionsObj.Has("tiles") && !optionsObj.Get("tiles").IsUndefined())
     {
-        Napi::TypeError::New(env, "Invalid arguments. Expected: object").ThrowAsJavaScriptException();
-        return env.Null();
+        Napi::Value tiles = optionsObj.Get("tiles");
+        if (tiles.IsBoolean())
+            options.tiles = tiles.As<Napi::Boolean>().Value() ? -1 : 0;
+        else if (tiles.IsNumber() && tiles.ToNumber().Int32Value() >= 1)
+            options.tiles = tiles.ToNumber().Int32Value();
+        else
+        {
+            Napi::TypeError::New(env, "'tiles' must be a boolean or a tile count of at least 1").ThrowAsJavaScriptException();
+            return false;
+        }
     }
 
-    Napi::Object imageData = info[0].As<Napi::Object>();
+    if (optionsObj.Has("anyMatch"))
+        options.anyMatch = optionsObj.Get("anyMatch").ToBoolean().Value();
+    // Stopping early only works between tiles
+    if (options.anyMatch && options.tiles == 0)
+        options.tiles = -1;
+    return true;
+}
 
-    if (!imageData.Has("width") || !imageData.Has("height") || !imageData.Has("data"))
+/**
+ * Reads `region: [x, y, width, height]` or `regions: [[x, y, width, height], ...]` from a match options object.
+ * Throws a TypeError and returns false on bad input.
+ */
+bool ParseSearchRegions(Napi::Env env, const Napi::Object &optionsObj, std::vector<cv::Rect> &regions)
+{
+    std::vector<Napi::Value> values;
+    if (optionsObj.Has("region") && !optionsObj.Get("region").IsUndefined())
     {
-        Napi::TypeError::New(env, "Invalid image data object. Expected properties: 'width', 'height', 'data'").ThrowAsJavaScriptException();
-        return env.Null();
+        values.push_back(optionsObj.Get("region"));
     }
-
-    int width = imageData.Get("width").ToNumber().Int32Value();
-    int height = imageData.Get("height").ToNumber().Int32Value();
-
-    cv::Mat image;
-    if (imageData.Get("data").IsTypedArray())
+    else if (optionsObj.Has("regions") && !optionsObj.Get("regions").IsUndefined())
     {
-        Napi::TypedArray typedArray = imageData.Get("data").As<Napi::TypedArray>();
-        int elementSize = typedArray.ByteLength() / (width * height);
-        // std::cout << typedArray.ByteLength() << std::endl;
-        // std::cout << elementSize << std::endl;
-        int type = elementSize == 1 ? CV_8UC1 : CV_8UC3;
-
-        image = cv::Mat(height, width, type);
-        memcpy(image.data, typedArray.As<Napi::Uint8Array>().Data(), typedArray.ByteLength());
+        if (!optionsObj.Get("regions").IsArray() || optionsObj.Get("regions").As<Napi::Array>().Length() == 0)
+        {
+            Napi::TypeError::New(env, "Search regions must be a non-empty array of [x, y, width, height]").ThrowAsJavaScriptException();
+            return false;
+        }
+        Napi::Array array = optionsObj.Get("regions").As<Napi::Array>();
+        for (uint32_t i = 0; i < array.Length(); ++i)
+            values.push_back(array.Get(i));
     }
-    else
+
+    for (const Napi::Value &value : values)
     {
-        Napi::TypeError::New(env, "'data' property must be a TypedArray").ThrowAsJavaScriptException();
-        return env.Null();
+        FrameRect region;
+        if (!ParseFrameRect(value, region) || region.width <= 0 || region.height <= 0)
+        {
+            Napi::TypeError::New(env, "Invalid search region. Expected: [x, y, width, height]").ThrowAsJavaScriptException();
+            return false;
+        }
+        regions.emplace_back(region.x, region.y, region.width, region.height);
     }
-    std::vector<uchar> buffer;
-    cv::imencode(".png", image, buffer);
-
-    Napi::Buffer<uchar> resultBuffer = Napi::Buffer<uchar>::Copy(env, buffer.data(), buffer.size());
-    return resultBuffer;
+    return true;
 }
 
-Napi::Value MatchTemplate(const Napi::CallbackInfo &info)
+/**
+ * Reads `{ pyramid: { levels, candidates }, region, regions, tiles }` from an options object. Throws a TypeError and
+ * returns false on bad input.
+ */
+bool ParseMatchOptions(Napi::Env env, const Napi::Object &optionsObj, MatchOptions &options)
 {
-    Napi::Env env = info.Env();
-
-    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsObject())
+    if (optionsObj.Has("pyramid") && optionsObj.Get("pyramid").IsObject())
     {
-        Napi::TypeError::New(env, "Invalid arguments. Expected: (object, object[, object])").ThrowAsJavaScriptException();
-        return env.Null();
+        Napi::Object pyramidObj = optionsObj.Get("pyramid").As<Napi::Object>();
+        options.pyramid.levels = 1;
+        if (pyramidObj.Has("levels") && !pyramidObj.Get("levels").IsUndefined())
+            options.pyramid.levels = pyramidObj.Get("levels").ToNumber().Int32Value();
+        if (pyramidObj.Has("candidates") && !pyramidObj.Get("candidates").IsUndefined())
+            options.pyramid.candidates = pyramidObj.Get("candidates").ToNumber().Int32Value();
+
+        if (options.pyramid.levels < 0 || options.pyramid.candidates < 1)
+        {
+            Napi::TypeError::New(env, "Pyramid 'levels' must be non-negative and 'candidates' at least 1").ThrowAsJavaScriptException();
+            return false;
+        }
     }
 
-    Napi::Object srcObj = info[0].As<Napi::Object>();
-    Napi::Object templObj = info[1].As<Napi::Object>();
-    int method = cv::TM_CCOEFF_NORMED;
-    if (info.Length() > 2 && !info[2].IsNumber())
-    {
-        method = info[2].ToNumber().Int32Value();
-    }
+    return ParseSearchRegions(env, optionsObj, options.regions) && ParseTileOptions(env, optionsObj, options.tiles);
+}
 
-    if (!srcObj.Has("data") || !templObj.Has("data"))
-    {
-        Napi::TypeError::New(env, "Invalid image data objects. Expected properties: 'data'").ThrowAsJavaScriptException();
-        return env.Null();
-    }
+/**
+ * Reads match options, plus `{ signal, timeout }` for this call, from info[index] if present. Throws a TypeError
+ * and returns false on bad input.
+ */
+bool ParseMatchOptions(const Napi::CallbackInfo &info, size_t index, MatchOptions &options)
+{
+    Napi::Env env = info.Env();
 
-    if (!srcObj.Has("width") || !srcObj.Has("height") || !templObj.Has("width") || !templObj.Has("height"))
-    {
-        Napi::TypeError::New(env, "Invalid image data objects. Expected properties: 'width', 'height'").ThrowAsJavaScriptException();
-        return env.Null();
-    }
+    if (info.Length() <= index || info[index].IsUndefined() || info[index].IsNull())
+        return true;
 
-    if (!srcObj.Get("data").IsTypedArray() || !templObj.Get("data").IsTypedArray())
+    if (!info[index].IsObject())
     {
-        Napi::TypeError::New(env, "TypedArray expected for 'data' properties").ThrowAsJavaScriptException();
-        return env.Null();
+        Napi::TypeError::New(env, "Match options must be an object").ThrowAsJavaScriptException();
+        return false;
     }
 
-    int srcWidth = srcObj.Get("width").ToNumber().Int32Value();
-    int srcHeight = srcObj.Get("height").ToNumber().Int32Value();
-    int templWidth = templObj.Get("width").ToNumber().Int32Value();
-    int templHeight = templObj.Get("height").ToNumber().Int32Value();
+    return ParseMatchOptions(env, info[index].As<Napi::Object>(), options) &&
+           ParseStopOptions(env, info[index].As<Napi::Object>(), options.stop);
+}
 
-    Napi::ArrayBuffer srcBufferData = srcObj.Get("data").As<Napi::TypedArray>().ArrayBuffer();
-    Napi::ArrayBuffer templBufferData = templObj.Get("data").As<Napi::TypedArray>().ArrayBuffer();
+/**
+ * Runs one match as requested by `options` and returns its extremes.
+ * Source and template may differ in channel count: the one with more channels is reduced to the other's
+ * (BGRA to BGR, color to gray), so a BGRA capture can be searched for a BGR template read from disk.
+ * A color mask is reduced to gray unless it has the template's channel count.
+ * With search regions, each region is matched as a view into the source and the extremes are taken over all of
+ * them, in full-image coordinates. Throws std::runtime_error when no region can hold the template.
+ * With tiles, each region is split into overlapping tiles matched in parallel on the shared worker pool.
+ * Throws OperationStopped when `options.stop` fires; without tiles or a pyramid it is only checked between regions.
+ */
+MatchExtremes RunMatch(const cv::Mat &src, const cv::Mat &templ, int method, const cv::Mat &mask, const MatchOptions &options)
+{
+    const int channels = CommonChannels(src, templ);
+    const cv::Mat matchSrc = ReduceChannels(src, channels);
+    const cv::Mat matchTempl = ReduceChannels(templ, channels);
+    const cv::Mat matchMask = mask.empty() || mask.channels() == channels ? mask : ReduceChannels(mask, 1);
 
-    cv::Mat src(srcHeight, srcWidth, CV_8UC1, srcBufferData.Data());
-    cv::Mat templ(templHeight, templWidth, CV_8UC1, templBufferData.Data());
+    const std::vector<cv::Rect> windows = SearchWindows(matchSrc.size(), matchTempl.size(), options.regions);
+    if (windows.empty())
+        throw std::runtime_error("No search region is large enough for the template");
 
-    cv::Mat mask;
-    if (info.Length() >= 4 && info[2].IsObject())
+    MatchExtremes best;
+    cv::Mat result;
+    for (size_t i = 0; i < windows.size(); ++i)
     {
-        Napi::Object maskObj = info[2].As<Napi::Object>();
-        if (maskObj.Has("data") && maskObj.Get("data").IsTypedArray())
+        options.stop.ThrowIfStopped();
+        const cv::Mat view = matchSrc(windows[i]);
+        MatchExtremes extremes;
+        if (options.pyramid.levels > 0 && matchMask.empty())
+        {
+            extremes = PyramidMatchTemplate(view, matchTempl, method, options.pyramid, &options.stop);
+        }
+        else if (options.tiles.tiles != 0)
+        {
+            // The pointer is held until the tiles are done, so a resize cannot free the pool under them
+            const std::shared_ptr<WorkerPool> pool = SharedWorkerPool();
+            extremes = TiledMatchExtremes(view, matchTempl, method, matchMask, options.tiles, *pool, &options.stop);
+        }
+        else
         {
-            int maskWidth = maskObj.Get("width").ToNumber().Int32Value();
-            int maskHeight = maskObj.Get("height").ToNumber().Int32Value();
-            Napi::ArrayBuffer maskBufferData = maskObj.Get("data").As<Napi::TypedArray>().ArrayBuffer();
-            mask = cv::Mat(maskHeight, maskWidth, CV_8UC1, maskBufferData.Data());
+            if (matchMask.empty())
+                cv::matchTemplate(view, matchTempl, result, method);
+            else
+                cv::matchTemplate(view, matchTempl, result, method, matchMask);
+            extremes = FindExtremes(result);
         }
+        MergeExtremes(best, extremes, windows[i].tl(), i == 0);
     }
+    return best;
+}
 
-    cv::Mat result;
-    if (mask.empty())
-    {
-        cv::matchTemplate(src, templ, result, cv::TM_CCOEFF_NORMED);
-    }
-    else
+/**
+ * Arguments of one matchTemplate call.
+ */
+struct MatchTemplateArgs
+{
+    cv::Mat src;
+    cv::Mat templ;
+    cv::Mat mask;
+    int method = cv::TM_CCOEFF_NORMED;
+    MatchOptions options;
+};
+
+/**
+ * Reads (image, template, method, mask, options). Image, template and mask point at JS memory.
+ * Throws a TypeError and returns false on bad input.
+ */
+bool ParseMatchTemplateArgs(const Napi::CallbackInfo &info, MatchTemplateArgs &args)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsObject())
     {
-        cv::matchTemplate(src, templ, result, cv::TM_CCOEFF_NORMED, mask);
+        Napi::TypeError::New(env, "Invalid arguments. Expected: (object, object[, number[, object[, object]]])").ThrowAsJavaScriptException();
+        return false;
     }
 
-    double minVal, maxVal;
-    cv::Point minLoc, maxLoc;
-    cv::minMaxLoc(result, &minVal, &maxVal, &minLoc, &maxLoc);
+    if (!ImageDataToMat(env, info[0], args.src) || !ImageDataToMat(env, info[1], args.templ))
+        return false;
 
-    Napi::Object matchResult = Napi::Object::New(env);
-    matchResult.Set("minValue", minVal);
-    matchResult.Set("maxValue", maxVal);
-    Napi::Object minLocation = Napi::Object::New(env);
-    minLocation.Set("x", Napi::Number::New(env, minLoc.x));
-    minLocation.Set("y", Napi::Number::New(env, minLoc.y));
-    matchResult.Set("minLocation", minLocation);
+    if (info.Length() > 2 && !info[2].IsUndefined() && !info[2].IsNull())
+    {
+        if (!info[2].IsNumber())
+        {
+            Napi::TypeError::New(env, "Number expected for the matching method").ThrowAsJavaScriptException();
+            return false;
+        }
+        args.method = info[2].ToNumber().Int32Value();
+        if (args.method < cv::TM_SQDIFF || args.method > cv::TM_CCOEFF_NORMED)
+        {
+            Napi::TypeError::New(env, "Invalid template matching method").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
 
-    Napi::Object maxLocation = Napi::Object::New(env);
-    maxLocation.Set("x", Napi::Number::New(env, maxLoc.x));
-    maxLocation.Set("y", Napi::Number::New(env, maxLoc.y));
-    matchResult.Set("maxLocation", maxLocation);
+    if (info.Length() > 3 && !info[3].IsUndefined() && !info[3].IsNull() && !ImageDataToMat(env, info[3], args.mask))
+        return false;
 
-    return matchResult;
+    return ParseMatchOptions(info, 4, args.options);
 }
 
-Napi::Value BgrToGray(const Napi::CallbackInfo &info)
+/**
+ * matchTemplate(image, template, method = TM_CCOEFF_NORMED, mask, options): the best and worst match of the
+ * template over the image. Image, template and mask may each have 1, 3 or 4 channels, taken from their
+ * `channels` property; their data is read in place.
+ */
+Napi::Value MatchTemplate(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsObject())
+    MatchTemplateArgs args;
+    if (!ParseMatchTemplateArgs(info, args))
+        return env.Null();
+
+    try
     {
-        Napi::TypeError::New(env, "Invalid arguments. Expected: (object)").ThrowAsJavaScriptException();
+        return ExtremesToValue(env, RunMatch(args.src, args.templ, args.method, args.mask, args.options));
+    }
+    catch (const cv::Exception &e)
+    {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
-
-    Napi::Object srcObj = info[0].As<Napi::Object>();
-
-    if (!srcObj.Has("data") || !srcObj.Has("width") || !srcObj.Has("height"))
+    catch (const OperationStopped &e)
     {
-        Napi::TypeError::New(env, "Invalid image data object. Expected properties: 'data', 'width', 'height'").ThrowAsJavaScriptException();
+        StoppedError(env, e).ThrowAsJavaScriptException();
         return env.Null();
     }
-
-    if (!srcObj.Get("data").IsTypedArray())
+    catch (const std::runtime_error &e)
     {
-        Napi::TypeError::New(env, "TypedArray expected for 'data' property").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
+}
 
-    int width = srcObj.Get("width").ToNumber().Int32Value();
-    int height = srcObj.Get("height").ToNumber().Int32Value();
-
-    cv::Mat src(height, width, CV_8UC3, srcObj.Get("data").As<Napi::TypedArray>().ArrayBuffer().Data());
-    cv::Mat gray;
-
-    cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+Napi::Value BgrToGray(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
 
-    Napi::Object result = Napi::Object::New(env);
-    // Create a new Uint8Array with the correct size
-    // std::cout << gray.elemSize() << std::endl;
-    size_t totalBytes = width * height;
-    Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, totalBytes);
-    Napi::Uint8Array uint8Array = Napi::Uint8Array::New(env, totalBytes, arrayBuffer, 0);
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        Napi::TypeError::New(env, "Invalid arguments. Expected: (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-    // Copy the image data to the Uint8Array
-    memcpy(uint8Array.Data(), gray.data, totalBytes);
+    cv::Mat src;
+    if (!ImageDataToMat(env, info[0], src))
+        return env.Null();
 
-    result.Set("width", width);
-    result.Set("height", height);
-    result.Set("data", uint8Array);
+    // A gray input is copied out as it is
+    if (src.channels() == 1)
+        return MatToImageData(env, src);
 
-    return result;
+    cv::Mat gray;
+    cv::cvtColor(src, gray, src.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    return MatToImageData(env, gray);
 }
 
 Napi::Value Blur(const Napi::CallbackInfo &info)
@@ -244,41 +354,17 @@ Napi::Value Blur(const Napi::CallbackInfo &info)
         return env.Null();
     }
 
-    Napi::Object srcObj = info[0].As<Napi::Object>();
     int ksizeX = info[1].As<Napi::Number>().Int32Value();
     int ksizeY = info[2].As<Napi::Number>().Int32Value();
 
-    if (!srcObj.Has("data") || !srcObj.Has("width") || !srcObj.Has("height"))
-    {
-        Napi::TypeError::New(env, "Invalid image data object. Expected properties: 'data', 'width', 'height'").ThrowAsJavaScriptException();
+    cv::Mat src;
+    if (!ImageDataToMat(env, info[0], src))
         return env.Null();
-    }
 
-    if (!srcObj.Get("data").IsTypedArray())
-    {
-        Napi::TypeError::New(env, "TypedArray expected for 'data' property").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-
-    int width = srcObj.Get("width").ToNumber().Int32Value();
-    int height = srcObj.Get("height").ToNumber().Int32Value();
-
-    cv::Mat src(height, width, CV_8UC3, srcObj.Get("data").As<Napi::TypedArray>().ArrayBuffer().Data());
     cv::Mat blurred;
-
     cv::blur(src, blurred, cv::Size(ksizeX, ksizeY));
 
-    Napi::Object result = Napi::Object::New(env);
-    size_t totalBytes = blurred.total() * blurred.elemSize();
-    Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, totalBytes);
-    Napi::Uint8Array uint8Array = Napi::Uint8Array::New(env, totalBytes, arrayBuffer, 0);
-
-    // Copy the image data to the Uint8Array
-    memcpy(uint8Array.Data(), blurred.data, totalBytes);
-    result.Set("width", width);
-    result.Set("height", height);
-    result.Set("data", uint8Array);
-    return result;
+    return MatToImageData(env, blurred);
 }
 
 Napi::Value DrawRectangle(const Napi::CallbackInfo &info)
@@ -291,7 +377,6 @@ Napi::Value DrawRectangle(const Napi::CallbackInfo &info)
         return env.Null();
     }
 
-    Napi::Object imageObj = info[0].As<Napi::Object>();
     Napi::Array point1Array = info[1].As<Napi::Array>();
     Napi::Array point2Array = info[2].As<Napi::Array>();
     int thickness = info[4].As<Napi::Number>().Int32Value();
@@ -318,36 +403,14 @@ Napi::Value DrawRectangle(const Napi::CallbackInfo &info)
     int g = colorArray.Get((uint32_t)1).ToNumber().Int32Value();
     int b = colorArray.Get((uint32_t)2).ToNumber().Int32Value();
 
-    if (!imageObj.Has("data") || !imageObj.Has("width") || !imageObj.Has("height"))
-    {
-        Napi::TypeError::New(env, "Invalid image data object. Expected properties: 'data', 'width', 'height'").ThrowAsJavaScriptException();
+    cv::Mat src;
+    if (!ImageDataToMat(env, info[0], src))
         return env.Null();
-    }
-
-    if (!imageObj.Get("data").IsTypedArray())
-    {
-        Napi::TypeError::New(env, "TypedArray expected for 'data' property").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-
-    int width = imageObj.Get("width").ToNumber().Int32Value();
-    int height = imageObj.Get("height").ToNumber().Int32Value();
-
-    cv::Mat image(height, width, CV_8UC3, imageObj.Get("data").As<Napi::TypedArray>().ArrayBuffer().Data());
 
+    // Drawn on a copy, so the caller's image is left unchanged
+    cv::Mat image = src.clone();
     cv::rectangle(image, cv::Point(x1, y1), cv::Point(x2, y2), cv::Scalar(b, g, r), thickness);
-    Napi::Object result = Napi::Object::New(env);
-
-    size_t totalBytes = image.total() * image.elemSize();
-    Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, totalBytes);
-    Napi::Uint8Array uint8Array = Napi::Uint8Array::New(env, totalBytes, arrayBuffer, 0);
-
-    // Copy the image data to the Uint8Array
-    memcpy(uint8Array.Data(), image.data, totalBytes);
-    result.Set("width", width);
-    result.Set("height", height);
-    result.Set("data", uint8Array);
-    return result;
+    return MatToImageData(env, image);
 }
 
 Napi::Value GetRegion(const Napi::CallbackInfo &info)
@@ -359,7 +422,6 @@ Napi::Value GetRegion(const Napi::CallbackInfo &info)
         Napi::TypeError::New(env, "Invalid arguments. Expected: (object)").ThrowAsJavaScriptException();
         return env.Null();
     }
-    Napi::Object imageObj = info[0].As<Napi::Object>();
     Napi::Object options = info[1].As<Napi::Object>();
 
     int x = options.Get((uint32_t)0).ToNumber().Int32Value();
@@ -367,44 +429,20 @@ Napi::Value GetRegion(const Napi::CallbackInfo &info)
     int width = options.Get((uint32_t)2).ToNumber().Int32Value();
     int height = options.Get((uint32_t)3).ToNumber().Int32Value();
 
-    if (!imageObj.Has("data") || !imageObj.Has("width") || !imageObj.Has("height"))
-    {
-        Napi::TypeError::New(env, "Invalid image data object. Expected properties: 'data', 'width', 'height'").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-
-    if (!imageObj.Get("data").IsTypedArray())
-    {
-        Napi::TypeError::New(env, "TypedArray expected for 'data' property").ThrowAsJavaScriptException();
+    cv::Mat image;
+    if (!ImageDataToMat(env, info[0], image))
         return env.Null();
-    }
 
-    int imageWidth = imageObj.Get("width").ToNumber().Int32Value();
-    int imageHeight = imageObj.Get("height").ToNumber().Int32Value();
-
-    if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > imageWidth || y + height > imageHeight)
+    if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > image.cols || y + height > image.rows)
     {
         Napi::TypeError::New(env, "Invalid region coordinates or size").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    cv::Mat image(imageHeight, imageWidth, CV_8UC3, imageObj.Get("data").As<Napi::TypedArray>().ArrayBuffer().Data());
-
     cv::Rect region(x, y, width, height);
-    cv::Mat regionImage = image(region).clone();
-
-    size_t totalBytes = regionImage.total() * regionImage.elemSize();
-    Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, totalBytes);
-    Napi::Uint8Array uint8Array = Napi::Uint8Array::New(env, totalBytes, arrayBuffer, 0);
-
-    // Copy the image data to the Uint8Array
-    memcpy(uint8Array.Data(), regionImage.data, totalBytes);
-    Napi::Object result = Napi::Object::New(env);
-    result.Set("data", uint8Array);
-    result.Set("width", Napi::Number::New(env, regionImage.cols));
-    result.Set("height", Napi::Number::New(env, regionImage.rows));
 
-    return result;
+    // The ROI is cloned once into memory that JS then owns
+    return MatToImageData(env, image(region));
 }
 
 // Napi::Value ReadImage(const Napi::CallbackInfo &info)
@@ -0,0 +1,353 @@
+#include <napi.h>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <errors.h>
+#include <stopCondition.h>
+#include <workerPool.h>
+
+// Upper bound for setWorkerThreads, well above any core count the pool is useful for
+const int MAX_WORKER_THREADS = 256;
+
+/**
+ * One call of an async OpenCV binding: the work runs on the async worker pool and the Promise is settled on the
+ * JS thread. The JS values the work reads from are referenced until then, so a worker never reads memory the
+ * garbage collector has freed.
+ */
+template <typename Result>
+class PoolJob
+{
+public:
+    using Work = std::function<Result()>;
+    using Settle = std::function<Napi::Value(Napi::Env, Result &)>;
+
+    static Napi::Promise Start(Napi::Env env, const std::vector<Napi::Value> &keepAlive, Work work, Settle settle,
+                               std::unique_ptr<AbortListener> listener = nullptr)
+    {
+        PoolJob *job = new PoolJob(env, std::move(work), std::move(settle));
+        job->m_listener = std::move(listener);
+        for (const Napi::Value &value : keepAlive)
+            job->m_keepAlive.push_back(Napi::Persistent(value));
+
+        Napi::Promise promise = job->m_deferred.Promise();
+        AsyncWorkerPool()->Submit([job]
+                                 { job->Execute(); });
+        return promise;
+    }
+
+private:
+    PoolJob(Napi::Env env, Work work, Settle settle)
+        : m_deferred(Napi::Promise::Deferred::New(env)), m_work(std::move(work)), m_settle(std::move(settle)),
+          m_done(Napi::ThreadSafeFunction::New(env, Napi::Function(), "PoolJob", 0, 1))
+    {
+    }
+
+    void Execute()
+    {
+        try
+        {
+            m_result = m_work();
+        }
+        catch (const OperationStopped &e)
+        {
+            m_stopped.reset(new OperationStopped(e));
+        }
+        catch (const std::exception &e)
+        {
+            m_failed = true;
+            m_error = e.what();
+        }
+
+        // The job deletes itself on the JS thread, possibly before BlockingCall returns here
+        Napi::ThreadSafeFunction done = m_done;
+        done.BlockingCall([this](Napi::Env env, Napi::Function)
+                          { Finish(env); });
+        done.Release();
+    }
+
+    void Finish(Napi::Env env)
+    {
+        // No env while the environment is being torn down; nothing is left to settle then
+        if (static_cast<napi_env>(env) == nullptr)
+        {
+            delete this;
+            return;
+        }
+
+        Napi::HandleScope scope(env);
+        if (m_listener)
+            m_listener->Detach();
+        if (m_stopped)
+        {
+            m_deferred.Reject(StoppedError(env, *m_stopped).Value());
+        }
+        else if (m_failed)
+        {
+            m_deferred.Reject(Napi::Error::New(env, m_error).Value());
+        }
+        else
+        {
+            try
+            {
+                m_deferred.Resolve(m_settle(env, m_result));
+            }
+            catch (const Napi::Error &e)
+            {
+                m_deferred.Reject(e.Value());
+            }
+        }
+        delete this;
+    }
+
+    Napi::Promise::Deferred m_deferred;
+    Work m_work;
+    Settle m_settle;
+    Napi::ThreadSafeFunction m_done;
+    std::vector<Napi::Reference<Napi::Value>> m_keepAlive;
+    std::unique_ptr<AbortListener> m_listener;
+    Result m_result;
+    std::unique_ptr<OperationStopped> m_stopped;
+    bool m_failed = false;
+    std::string m_error;
+};
+
+/**
+ * Adds an Image or ImageData argument, and the typed array holding an ImageData's pixels, to `keepAlive`.
+ * Referencing the array itself keeps the pixels alive even if the object's `data` is reassigned.
+ */
+void KeepImageAlive(Napi::Value value, std::vector<Napi::Value> &keepAlive)
+{
+    keepAlive.push_back(value);
+    if (value.IsObject() && value.As<Napi::Object>().Get("data").IsTypedArray())
+        keepAlive.push_back(value.As<Napi::Object>().Get("data"));
+}
+
+Napi::Value MatToValue(Napi::Env env, cv::Mat &mat)
+{
+    return MatToImageData(env, mat);
+}
+
+Napi::Value ImreadAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "String expected for image file path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string filename = info[0].ToString().Utf8Value();
+    int flags = cv::IMREAD_COLOR;
+    if (info.Length() > 1 && info[1].IsNumber())
+        flags = info[1].ToNumber().Int32Value();
+
+    return PoolJob<cv::Mat>::Start(
+        env, {}, [filename, flags]
+        {
+            cv::Mat image = cv::imread(filename, flags);
+            if (image.empty())
+                throw std::runtime_error("Failed to load image");
+            return image; },
+        MatToValue);
+}
+
+Napi::Value ImwriteAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    cv::Mat image;
+    if (info.Length() < 1 || !Image::ImageArgument(env, info[0], image))
+    {
+        if (!env.IsExceptionPending())
+            Napi::TypeError::New(env, "Invalid arguments. Expected: object").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::vector<Napi::Value> keepAlive;
+    KeepImageAlive(info[0], keepAlive);
+    return PoolJob<std::vector<uchar>>::Start(
+        env, keepAlive, [image]
+        {
+            std::vector<uchar> buffer;
+            cv::imencode(".png", image, buffer);
+            return buffer; },
+        [](Napi::Env env, std::vector<uchar> &buffer) -> Napi::Value
+        { return Napi::Buffer<uchar>::Copy(env, buffer.data(), buffer.size()); });
+}
+
+Napi::Value MatchTemplateAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    MatchTemplateArgs args;
+    if (!ParseMatchTemplateArgs(info, args))
+        return env.Null();
+
+    std::vector<Napi::Value> keepAlive;
+    KeepImageAlive(info[0], keepAlive);
+    KeepImageAlive(info[1], keepAlive);
+    if (!args.mask.empty())
+        KeepImageAlive(info[3], keepAlive);
+
+    // Attached before `args` is copied into the job, so the copy shares the flag the listener sets
+    std::unique_ptr<AbortListener> listener = AbortListener::Attach(env, info.Length() > 4 ? info[4] : env.Undefined(), args.options.stop);
+    return PoolJob<MatchExtremes>::Start(
+        env, keepAlive, [args]
+        { return RunMatch(args.src, args.templ, args.method, args.mask, args.options); },
+        [](Napi::Env env, MatchExtremes &extremes) -> Napi::Value
+        { return ExtremesToValue(env, extremes); },
+        std::move(listener));
+}
+
+Napi::Value BlurAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[1].IsNumber() || !info[2].IsNumber())
+    {
+        Napi::TypeError::New(env, "Invalid arguments. Expected: (object, number, number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    cv::Mat src;
+    if (!Image::ImageArgument(env, info[0], src))
+        return env.Null();
+    cv::Size size(info[1].ToNumber().Int32Value(), info[2].ToNumber().Int32Value());
+
+    std::vector<Napi::Value> keepAlive;
+    KeepImageAlive(info[0], keepAlive);
+    return PoolJob<cv::Mat>::Start(
+        env, keepAlive, [src, size]
+        {
+            cv::Mat blurred;
+            cv::blur(src, blurred, size);
+            return blurred; },
+        MatToValue);
+}
+
+Napi::Value BgrToGrayAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    cv::Mat src;
+    if (info.Length() < 1 || !Image::ImageArgument(env, info[0], src))
+    {
+        if (!env.IsExceptionPending())
+            Napi::TypeError::New(env, "Invalid arguments. Expected: (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::vector<Napi::Value> keepAlive;
+    KeepImageAlive(info[0], keepAlive);
+    return PoolJob<cv::Mat>::Start(
+        env, keepAlive, [src]
+        {
+            if (src.channels() == 1)
+                return src.clone();
+            cv::Mat gray;
+            cv::cvtColor(src, gray, src.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+            return gray; },
+        MatToValue);
+}
+
+/**
+ * Draws into a copy like drawRectangle; the caller's pixels may also be read by JS while the worker draws.
+ */
+Napi::Value DrawRectangleAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 5 || !info[1].IsArray() || !info[2].IsArray() || !info[3].IsArray() || !info[4].IsNumber())
+    {
+        Napi::TypeError::New(env, "Invalid arguments. Expected: (object, array, array, array, number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array point1Array = info[1].As<Napi::Array>();
+    Napi::Array point2Array = info[2].As<Napi::Array>();
+    Napi::Array colorArray = info[3].As<Napi::Array>();
+    if (point1Array.Length() < 2 || point2Array.Length() < 2 || colorArray.Length() < 3)
+    {
+        Napi::TypeError::New(env, "Invalid point or color array length. Expected: [x, y] and [r, g, b]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    cv::Mat src;
+    if (!Image::ImageArgument(env, info[0], src))
+        return env.Null();
+
+    cv::Point point1(point1Array.Get((uint32_t)0).ToNumber().Int32Value(), point1Array.Get((uint32_t)1).ToNumber().Int32Value());
+    cv::Point point2(point2Array.Get((uint32_t)0).ToNumber().Int32Value(), point2Array.Get((uint32_t)1).ToNumber().Int32Value());
+    cv::Scalar color(colorArray.Get((uint32_t)2).ToNumber().Int32Value(), colorArray.Get((uint32_t)1).ToNumber().Int32Value(),
+                     colorArray.Get((uint32_t)0).ToNumber().Int32Value());
+    int thickness = info[4].ToNumber().Int32Value();
+
+    std::vector<Napi::Value> keepAlive;
+    KeepImageAlive(info[0], keepAlive);
+    return PoolJob<cv::Mat>::Start(
+        env, keepAlive, [src, point1, point2, color, thickness]
+        {
+            cv::Mat image = src.clone();
+            cv::rectangle(image, point1, point2, color, thickness);
+            return image; },
+        MatToValue);
+}
+
+Napi::Value GetRegionAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    FrameRect rect;
+    if (info.Length() < 2 || !ParseFrameRect(info[1], rect))
+    {
+        Napi::TypeError::New(env, "Invalid arguments. Expected: (object, [x, y, width, height])").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    cv::Mat src;
+    if (!Image::ImageArgument(env, info[0], src))
+        return env.Null();
+
+    cv::Rect region(rect.x, rect.y, rect.width, rect.height);
+    if (region.x < 0 || region.y < 0 || region.width <= 0 || region.height <= 0 || (region & cv::Rect(0, 0, src.cols, src.rows)) != region)
+    {
+        Napi::TypeError::New(env, "Invalid region coordinates or size").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::vector<Napi::Value> keepAlive;
+    KeepImageAlive(info[0], keepAlive);
+    return PoolJob<cv::Mat>::Start(
+        env, keepAlive, [src, region]
+        { return src(region).clone(); },
+        MatToValue);
+}
+
+/**
+ * setWorkerThreads(count): resizes the native pools the async bindings and parallel matching run on. Returns at
+ * once; work already queued finishes on the old pools.
+ */
+Napi::Value SetWorkerThreads(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber() || info[0].ToNumber().Int32Value() < 1 || info[0].ToNumber().Int32Value() > MAX_WORKER_THREADS)
+    {
+        Napi::TypeError::New(env, "Thread count must be a number from 1 to " + std::to_string(MAX_WORKER_THREADS)).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    ResizeSharedWorkerPools(static_cast<size_t>(info[0].ToNumber().Int32Value()));
+    return env.Undefined();
+}
+
+Napi::Value GetWorkerThreads(const Napi::CallbackInfo &info)
+{
+    return Napi::Number::New(info.Env(), static_cast<double>(SharedWorkerPool()->Size()));
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * One template match: the box the template covers in the source image and its score.
+ */
+struct Peak
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    float score = 0;
+    // Which of several templates (or template scales) matched, when results of more than one are merged
+    int index = 0;
+};
+
+/**
+ * Lowest and highest score of a response map and where they are, as found by cv::minMaxLoc.
+ */
+struct MatchExtremes
+{
+    double minValue = 0;
+    double maxValue = 0;
+    cv::Point minLocation;
+    cv::Point maxLocation;
+};
+
+inline MatchExtremes FindExtremes(const cv::Mat &response)
+{
+    MatchExtremes extremes;
+    cv::minMaxLoc(response, &extremes.minValue, &extremes.maxValue, &extremes.minLocation, &extremes.maxLocation);
+    return extremes;
+}
+
+/**
+ * Folds the extremes of a response computed over a window at `offset` into `best`, which holds the extremes of
+ * the windows seen so far. `first` starts a new fold.
+ */
+inline void MergeExtremes(MatchExtremes &best, const MatchExtremes &window, cv::Point offset, bool first)
+{
+    if (first || window.minValue < best.minValue)
+    {
+        best.minValue = window.minValue;
+        best.minLocation = window.minLocation + offset;
+    }
+    if (first || window.maxValue > best.maxValue)
+    {
+        best.maxValue = window.maxValue;
+        best.maxLocation = window.maxLocation + offset;
+    }
+}
+
+struct PeakOptions
+{
+    // Scores worse than this are ignored
+    double threshold = 0.8;
+    size_t maxResults = 100;
+    // Two matches overlapping by more than this (intersection over union) count as the same hit
+    double nmsOverlap = 0.3;
+    // For the TM_SQDIFF methods, where the best match has the lowest score
+    bool lowerIsBetter = false;
+};
+
+/**
+ * Intersection over union of the boxes of two matches.
+ */
+inline double BoxOverlap(const Peak &a, const Peak &b)
+{
+    const int overlapX = std::max(0, std::min(a.x + a.width, b.x + b.width) - std::max(a.x, b.x));
+    const int overlapY = std::max(0, std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y));
+    const double intersection = static_cast<double>(overlapX) * overlapY;
+    const double areas = static_cast<double>(a.width) * a.height + static_cast<double>(b.width) * b.height;
+    return intersection / (areas - intersection);
+}
+
+/**
+ * Appends every local extremum (within its 3x3 neighbourhood) of a CV_32F matchTemplate response map that lies in
+ * `area` and passes `options.threshold` to `peaks`, tagged with `index`. Neighbours outside `area` still count, so
+ * a response split into areas yields the same peaks as the whole.
+ */
+inline void CollectPeaksIn(const cv::Mat &response, cv::Rect area, cv::Size templSize, const PeakOptions &options, std::vector<Peak> &peaks, int index = 0)
+{
+    // Scores are flipped for the lower-is-better methods, so below everything is "higher is better"
+    const float sign = options.lowerIsBetter ? -1.0f : 1.0f;
+    const float threshold = sign * static_cast<float>(options.threshold);
+
+    area &= cv::Rect(0, 0, response.cols, response.rows);
+    for (int y = area.y; y < area.y + area.height; ++y)
+    {
+        const float *above = response.ptr<float>(std::max(y - 1, 0));
+        const float *row = response.ptr<float>(y);
+        const float *below = response.ptr<float>(std::min(y + 1, response.rows - 1));
+        for (int x = area.x; x < area.x + area.width; ++x)
+        {
+            const float score = sign * row[x];
+            if (score < threshold)
+                continue;
+
+            const int left = std::max(x - 1, 0);
+            const int right = std::min(x + 1, response.cols - 1);
+            bool isPeak = true;
+            for (int nx = left; nx <= right && isPeak; ++nx)
+                isPeak = sign * above[nx] <= score && sign * row[nx] <= score && sign * below[nx] <= score;
+            if (isPeak)
+                peaks.push_back({x, y, templSize.width, templSize.height, row[x], index});
+        }
+    }
+}
+
+/**
+ * Appends every local extremum (within its 3x3 neighbourhood) of a CV_32F matchTemplate response map that
+ * passes `options.threshold` to `peaks`, tagged with `index`.
+ */
+inline void CollectPeaks(const cv::Mat &response, cv::Size templSize, const PeakOptions &options, std::vector<Peak> &peaks, int index = 0)
+{
+    CollectPeaksIn(response, cv::Rect(0, 0, response.cols, response.rows), templSize, options, peaks, index);
+}
+
+/**
+ * Greedy non-maximum suppression: sorts `candidates` best first and drops every one whose box overlaps an
+ * already accepted one by more than `options.nmsOverlap`. Stops at `options.maxResults`.
+ */
+inline std::vector<Peak> SuppressOverlaps(std::vector<Peak> candidates, const PeakOptions &options)
+{
+    const bool lowerIsBetter = options.lowerIsBetter;
+    std::sort(candidates.begin(), candidates.end(), [lowerIsBetter](const Peak &a, const Peak &b)
+              { return lowerIsBetter ? a.score < b.score : a.score > b.score; });
+
+    std::vector<Peak> peaks;
+    for (const Peak &candidate : candidates)
+    {
+        if (peaks.size() >= options.maxResults)
+            break;
+
+        bool suppressed = false;
+        for (const Peak &peak : peaks)
+        {
+            if (BoxOverlap(candidate, peak) > options.nmsOverlap)
+            {
+                suppressed = true;
+                break;
+            }
+        }
+        if (!suppressed)
+            peaks.push_back(candidate);
+    }
+    return peaks;
+}
+
+/**
+ * Finds every match in a CV_32F matchTemplate response map that passes `options.threshold`, best first,
+ * with overlapping matches suppressed.
+ */
+inline std::vector<Peak> FindPeaks(const cv::Mat &response, cv::Size templSize, const PeakOptions &options)
+{
+    std::vector<Peak> candidates;
+    CollectPeaks(response, templSize, options, candidates);
+    return SuppressOverlaps(std::move(candidates), options);
+}
@@ -0,0 +1,331 @@
+#include <napi.h>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <errors.h>
+#include <peaks.h>
+#include <pixelConvert.h>
+#include <stopCondition.h>
+#include <tiledMatch.h>
+#include <workerPool.h>
+
+enum class PipelineOp
+{
+    Crop,
+    Gray,
+    Blur,
+    Threshold,
+    Match,
+    MatchAll
+};
+
+/**
+ * One compiled step: its parameters, its slot in the scratch arena and how long it took on the last run.
+ */
+struct PipelineStep
+{
+    PipelineOp op = PipelineOp::Gray;
+    std::string name;
+    cv::Rect region;
+    cv::Size blurSize;
+    double level = 127;
+    double maxValue = 255;
+    bool inverse = false;
+    cv::Mat templ;
+    cv::Mat mask;
+    int method = cv::TM_CCOEFF_NORMED;
+    MatchOptions matchOptions;
+    PeakOptions peakOptions;
+    TileOptions tileOptions;
+    // Output buffer of the step, reallocated only when the frame size or type changes
+    cv::Mat scratch;
+    double milliseconds = 0;
+};
+
+/**
+ * A chain of image operations compiled once from a JS description and run natively on each frame, e.g.
+ * crop -> gray -> blur -> match. Intermediate images live in per-step buffers that are reused between runs,
+ * and only the result of the last step crosses into JS.
+ */
+class Pipeline : public Napi::ObjectWrap<Pipeline>
+{
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports)
+    {
+        Napi::Function func = DefineClass(env, "Pipeline",
+                                          {InstanceMethod("run", &Pipeline::Run),
+                                           InstanceAccessor("timings", &Pipeline::GetTimings, nullptr)});
+        exports.Set("Pipeline", func);
+        return exports;
+    }
+
+    /**
+     * new Pipeline([{ op: "crop", region }, { op: "gray" }, { op: "blur", size: [x, y] },
+     *               { op: "threshold", level, maxValue, inverse }, { op: "match", template, ... } | { op: "matchAll", template, ... }])
+     */
+    Pipeline(const Napi::CallbackInfo &info) : Napi::ObjectWrap<Pipeline>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsArray() || info[0].As<Napi::Array>().Length() == 0)
+        {
+            Napi::TypeError::New(env, "Pipeline steps must be a non-empty array").ThrowAsJavaScriptException();
+            return;
+        }
+
+        Napi::Array stepArray = info[0].As<Napi::Array>();
+        m_steps.resize(stepArray.Length());
+        for (uint32_t i = 0; i < stepArray.Length(); ++i)
+        {
+            if (!ParseStep(env, stepArray.Get(i), m_steps[i]))
+                return;
+            const bool matches = m_steps[i].op == PipelineOp::Match || m_steps[i].op == PipelineOp::MatchAll;
+            if (matches && i + 1 != stepArray.Length())
+            {
+                Napi::TypeError::New(env, "'match' and 'matchAll' must be the last step of a pipeline").ThrowAsJavaScriptException();
+                return;
+            }
+        }
+    }
+
+private:
+    static bool ParseStep(Napi::Env env, Napi::Value value, PipelineStep &step)
+    {
+        if (!value.IsObject() || !value.As<Napi::Object>().Get("op").IsString())
+        {
+            Napi::TypeError::New(env, "Each pipeline step must be an object with an 'op'").ThrowAsJavaScriptException();
+            return false;
+        }
+
+        Napi::Object stepObj = value.As<Napi::Object>();
+        step.name = stepObj.Get("op").ToString().Utf8Value();
+        if (step.name == "crop")
+        {
+            FrameRect region;
+            if (!ParseFrameRect(stepObj.Get("region"), region) || region.x < 0 || region.y < 0 || region.width <= 0 || region.height <= 0)
+            {
+                Napi::TypeError::New(env, "Invalid crop region. Expected: [x, y, width, height]").ThrowAsJavaScriptException();
+                return false;
+            }
+            step.op = PipelineOp::Crop;
+            step.region = cv::Rect(region.x, region.y, region.width, region.height);
+        }
+        else if (step.name == "gray")
+        {
+            step.op = PipelineOp::Gray;
+        }
+        else if (step.name == "blur")
+        {
+            Napi::Value size = stepObj.Get("size");
+            if (!size.IsArray() || size.As<Napi::Array>().Length() < 2)
+            {
+                Napi::TypeError::New(env, "Invalid blur size. Expected: [x, y]").ThrowAsJavaScriptException();
+                return false;
+            }
+            step.op = PipelineOp::Blur;
+            step.blurSize = cv::Size(size.As<Napi::Array>().Get((uint32_t)0).ToNumber().Int32Value(),
+                                     size.As<Napi::Array>().Get((uint32_t)1).ToNumber().Int32Value());
+        }
+        else if (step.name == "threshold")
+        {
+            step.op = PipelineOp::Threshold;
+            if (stepObj.Get("level").IsNumber())
+                step.level = stepObj.Get("level").ToNumber().DoubleValue();
+            if (stepObj.Get("maxValue").IsNumber())
+                step.maxValue = stepObj.Get("maxValue").ToNumber().DoubleValue();
+            step.inverse = stepObj.Get("inverse").ToBoolean().Value();
+        }
+        else if (step.name == "match" || step.name == "matchAll")
+        {
+            cv::Mat templ;
+            if (!stepObj.Has("template") || !Image::ImageArgument(env, stepObj.Get("template"), templ))
+            {
+                if (!env.IsExceptionPending())
+                    Napi::TypeError::New(env, "Match steps need a 'template'").ThrowAsJavaScriptException();
+                return false;
+            }
+            // The pipeline outlives the call, so JS-owned pixels are copied
+            step.templ = templ.clone();
+
+            if (step.name == "match")
+            {
+                step.op = PipelineOp::Match;
+                if (stepObj.Get("method").IsNumber())
+                    step.method = stepObj.Get("method").ToNumber().Int32Value();
+                if (step.method < cv::TM_SQDIFF || step.method > cv::TM_CCOEFF_NORMED)
+                {
+                    Napi::TypeError::New(env, "Invalid template matching method").ThrowAsJavaScriptException();
+                    return false;
+                }
+                cv::Mat mask;
+                if (stepObj.Has("mask") && !stepObj.Get("mask").IsUndefined() && !stepObj.Get("mask").IsNull())
+                {
+                    if (!Image::ImageArgument(env, stepObj.Get("mask"), mask))
+                        return false;
+                    step.mask = mask.clone();
+                }
+                return ParseMatchOptions(env, stepObj, step.matchOptions);
+            }
+
+            step.op = PipelineOp::MatchAll;
+            return ParsePeakOptions(env, stepObj, step.method, step.peakOptions) && ParseTileOptions(env, stepObj, step.tileOptions);
+        }
+        else
+        {
+            Napi::TypeError::New(env, "Unknown pipeline op '" + step.name + "'").ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * run(frame, { signal, timeout }): runs every step on the frame. Returns the result of the final match step, with
+     * locations in frame coordinates, or the final image as an Image. The stop options are checked before each step
+     * and passed on to a final `match` step.
+     */
+    Napi::Value Run(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Frame must be provided").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        cv::Mat frame;
+        if (!Image::ImageArgument(env, info[0], frame))
+            return env.Null();
+        StopCondition stop;
+        if (!ParseStopOptions(info, 1, stop))
+            return env.Null();
+
+        try
+        {
+            return RunSteps(env, frame, stop);
+        }
+        catch (const cv::Exception &e)
+        {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        catch (const OperationStopped &e)
+        {
+            StoppedError(env, e).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        catch (const std::runtime_error &e)
+        {
+            Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    Napi::Value RunSteps(Napi::Env env, const cv::Mat &frame, const StopCondition &stop)
+    {
+        for (PipelineStep &step : m_steps)
+            step.milliseconds = 0;
+
+        cv::Mat current = frame;
+        // Where `current` starts in the frame, so match locations can be reported in frame coordinates
+        cv::Point offset(0, 0);
+        for (PipelineStep &step : m_steps)
+        {
+            stop.ThrowIfStopped();
+            const auto start = std::chrono::steady_clock::now();
+            Napi::Value result;
+            switch (step.op)
+            {
+            case PipelineOp::Crop:
+                if ((step.region & cv::Rect(0, 0, current.cols, current.rows)) != step.region)
+                    throw std::runtime_error("Crop region is outside the image");
+                current = current(step.region);
+                offset += step.region.tl();
+                break;
+            case PipelineOp::Gray:
+                if (current.channels() > 1)
+                {
+                    step.scratch.create(current.rows, current.cols, CV_8UC1);
+                    if (current.channels() >= 3)
+                        ConvertColorToGray(current.data, current.step, current.channels(), step.scratch.data, current.cols, current.rows);
+                    else
+                        cv::extractChannel(current, step.scratch, 0);
+                    current = step.scratch;
+                }
+                break;
+            case PipelineOp::Blur:
+                cv::blur(current, step.scratch, step.blurSize);
+                current = step.scratch;
+                break;
+            case PipelineOp::Threshold:
+                cv::threshold(current, step.scratch, step.level, step.maxValue, step.inverse ? cv::THRESH_BINARY_INV : cv::THRESH_BINARY);
+                current = step.scratch;
+                break;
+            case PipelineOp::Match:
+            {
+                // The step's options are parsed without stop options, which only come with each run
+                step.matchOptions.stop = stop;
+                MatchExtremes extremes = RunMatch(current, step.templ, step.method, step.mask, step.matchOptions);
+                extremes.minLocation += offset;
+                extremes.maxLocation += offset;
+                result = ExtremesToValue(env, extremes);
+                break;
+            }
+            case PipelineOp::MatchAll:
+            {
+                // Like matchTemplateAll: the frame and template are compared at the channels they share
+                const int channels = CommonChannels(current, step.templ);
+                const cv::Mat src = ReduceChannels(current, channels);
+                const cv::Mat templ = ReduceChannels(step.templ, channels);
+                std::vector<Peak> peaks;
+                if (step.tileOptions.tiles != 0)
+                {
+                    const std::shared_ptr<WorkerPool> pool = SharedWorkerPool();
+                    peaks = SuppressOverlaps(TiledCollectPeaks(src, templ, step.method, step.peakOptions, step.tileOptions, *pool, &stop), step.peakOptions);
+                }
+                else
+                {
+                    cv::matchTemplate(src, templ, step.scratch, step.method);
+                    peaks = FindPeaks(step.scratch, templ.size(), step.peakOptions);
+                }
+                for (Peak &peak : peaks)
+                {
+                    peak.x += offset.x;
+                    peak.y += offset.y;
+                }
+                result = PeaksToValue(env, peaks);
+                break;
+            }
+            }
+            step.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (!result.IsEmpty())
+                return result;
+        }
+
+        // The last buffer is reused by the next run and a crop may still point at JS memory, so the result is a copy
+        return Image::NewInstance(env, current.clone());
+    }
+
+    /**
+     * [{ op, ms }] for each step of the last run. Steps not reached because of an error report 0.
+     */
+    Napi::Value GetTimings(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        Napi::Array timings = Napi::Array::New(env, m_steps.size());
+        for (size_t i = 0; i < m_steps.size(); ++i)
+        {
+            Napi::Object timing = Napi::Object::New(env);
+            timing.Set("op", m_steps[i].name);
+            timing.Set("ms", m_steps[i].milliseconds);
+            timings.Set(static_cast<uint32_t>(i), timing);
+        }
+        return timings;
+    }
+
+    std::vector<PipelineStep> m_steps;
+};
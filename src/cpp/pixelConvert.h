@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+/**
+ * Row kernels that turn mapped BGRA capture memory into the layouts the OpenCV helpers expect, in one pass.
+ * Each kernel has a universal-intrinsics body for whole vectors and a scalar loop for the tail, so the same
+ * code runs with SSE, AVX, NEON or no SIMD at all.
+ *
+ * Gray uses 8-bit fixed point weights (R 77, G 150, B 29 of 256), which stays within 1 of cv::cvtColor.
+ */
+
+const int GRAY_WEIGHT_B = 29;
+const int GRAY_WEIGHT_G = 150;
+const int GRAY_WEIGHT_R = 77;
+
+inline uint8_t GrayPixel(int b, int g, int r)
+{
+    return static_cast<uint8_t>((b * GRAY_WEIGHT_B + g * GRAY_WEIGHT_G + r * GRAY_WEIGHT_R + 128) >> 8);
+}
+
+inline void BgraRowToBgr(const uint8_t *src, uint8_t *dst, int width)
+{
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+    for (; x <= width - lanes; x += lanes)
+    {
+        cv::v_uint8 b, g, r, a;
+        cv::v_load_deinterleave(src + x * 4, b, g, r, a);
+        cv::v_store_interleave(dst + x * 3, b, g, r);
+    }
+#endif
+    for (; x < width; ++x)
+    {
+        dst[x * 3] = src[x * 4];
+        dst[x * 3 + 1] = src[x * 4 + 1];
+        dst[x * 3 + 2] = src[x * 4 + 2];
+    }
+}
+
+#if CV_SIMD
+// Weighted sum of one half of the lanes, still scaled by 256
+inline cv::v_uint16 GrayWeighted(const cv::v_uint16 &b, const cv::v_uint16 &g, const cv::v_uint16 &r)
+{
+    const cv::v_uint16 wb = cv::vx_setall_u16(GRAY_WEIGHT_B);
+    const cv::v_uint16 wg = cv::vx_setall_u16(GRAY_WEIGHT_G);
+    const cv::v_uint16 wr = cv::vx_setall_u16(GRAY_WEIGHT_R);
+    // 255 * 256 fits in 16 bits, so the wrapping multiply is exact
+    return cv::v_add(cv::v_add(cv::v_mul_wrap(b, wb), cv::v_mul_wrap(g, wg)),
+                     cv::v_add(cv::v_mul_wrap(r, wr), cv::vx_setall_u16(128)));
+}
+
+inline cv::v_uint8 GrayVector(const cv::v_uint8 &b, const cv::v_uint8 &g, const cv::v_uint8 &r)
+{
+    cv::v_uint16 b0, b1, g0, g1, r0, r1;
+    cv::v_expand(b, b0, b1);
+    cv::v_expand(g, g0, g1);
+    cv::v_expand(r, r0, r1);
+    return cv::v_pack(cv::v_shr<8>(GrayWeighted(b0, g0, r0)), cv::v_shr<8>(GrayWeighted(b1, g1, r1)));
+}
+#endif
+
+/**
+ * `channels` is 4 for BGRA or 3 for BGR input.
+ */
+inline void ColorRowToGray(const uint8_t *src, uint8_t *dst, int width, int channels)
+{
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+    if (channels == 4)
+    {
+        for (; x <= width - lanes; x += lanes)
+        {
+            cv::v_uint8 b, g, r, a;
+            cv::v_load_deinterleave(src + x * 4, b, g, r, a);
+            cv::v_store(dst + x, GrayVector(b, g, r));
+        }
+    }
+    else
+    {
+        for (; x <= width - lanes; x += lanes)
+        {
+            cv::v_uint8 b, g, r;
+            cv::v_load_deinterleave(src + x * 3, b, g, r);
+            cv::v_store(dst + x, GrayVector(b, g, r));
+        }
+    }
+#endif
+    for (; x < width; ++x)
+    {
+        const uint8_t *pixel = src + static_cast<size_t>(x) * channels;
+        dst[x] = GrayPixel(pixel[0], pixel[1], pixel[2]);
+    }
+}
+
+/**
+ * Averages 2x2 blocks of two gray rows into one row of `width / 2` pixels.
+ */
+inline void GrayRowsToHalf(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, int halfWidth)
+{
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+    const cv::v_uint16 two = cv::vx_setall_u16(2);
+    for (; x <= halfWidth - lanes; x += lanes)
+    {
+        // Even and odd pixels of each row land in separate vectors, so a 2x2 block is four lane-wise adds
+        cv::v_uint8 even0, odd0, even1, odd1;
+        cv::v_load_deinterleave(row0 + x * 2, even0, odd0);
+        cv::v_load_deinterleave(row1 + x * 2, even1, odd1);
+
+        cv::v_uint16 e0lo, e0hi, o0lo, o0hi, e1lo, e1hi, o1lo, o1hi;
+        cv::v_expand(even0, e0lo, e0hi);
+        cv::v_expand(odd0, o0lo, o0hi);
+        cv::v_expand(even1, e1lo, e1hi);
+        cv::v_expand(odd1, o1lo, o1hi);
+
+        cv::v_uint16 lo = cv::v_add(cv::v_add(e0lo, o0lo), cv::v_add(cv::v_add(e1lo, o1lo), two));
+        cv::v_uint16 hi = cv::v_add(cv::v_add(e0hi, o0hi), cv::v_add(cv::v_add(e1hi, o1hi), two));
+        cv::v_store(dst + x, cv::v_pack(cv::v_shr<2>(lo), cv::v_shr<2>(hi)));
+    }
+#endif
+    for (; x < halfWidth; ++x)
+        dst[x] = static_cast<uint8_t>((row0[x * 2] + row0[x * 2 + 1] + row1[x * 2] + row1[x * 2 + 1] + 2) >> 2);
+}
+
+/**
+ * Converts a whole image row by row. `srcStride` is the distance between source rows in bytes (RowPitch for
+ * mapped textures); the output is tightly packed.
+ */
+inline void ConvertBgraToBgr(const uint8_t *src, size_t srcStride, uint8_t *dst, int width, int height)
+{
+    for (int y = 0; y < height; ++y)
+        BgraRowToBgr(src + y * srcStride, dst + static_cast<size_t>(y) * width * 3, width);
+}
+
+inline void ConvertColorToGray(const uint8_t *src, size_t srcStride, int channels, uint8_t *dst, int width, int height)
+{
+    for (int y = 0; y < height; ++y)
+        ColorRowToGray(src + y * srcStride, dst + static_cast<size_t>(y) * width, width, channels);
+}
+
+/**
+ * An 8-bit image with at most `channels` channels: BGRA loses its alpha and color turns gray; 2-channel
+ * images keep their first channel. Returns `image` itself when it already has few enough channels.
+ */
+inline cv::Mat ReduceChannels(const cv::Mat &image, int channels)
+{
+    if (image.channels() <= channels)
+        return image;
+
+    if (channels >= 3)
+    {
+        cv::Mat bgr(image.rows, image.cols, CV_8UC3);
+        ConvertBgraToBgr(image.data, image.step, bgr.data, image.cols, image.rows);
+        return bgr;
+    }
+
+    cv::Mat gray(image.rows, image.cols, CV_8UC1);
+    if (image.channels() >= 3)
+        ConvertColorToGray(image.data, image.step, image.channels(), gray.data, image.cols, image.rows);
+    else
+        cv::extractChannel(image, gray, 0);
+    return gray;
+}
+
+/**
+ * Channel count two 8-bit images are compared at: the smaller of the two, except that a 2-channel image only pairs
+ * with another 2-channel one and is otherwise compared in gray. Reduce both with ReduceChannels() to this count.
+ */
+inline int CommonChannels(const cv::Mat &a, const cv::Mat &b)
+{
+    int channels = std::min(a.channels(), b.channels());
+    if (channels == 2 && a.channels() != b.channels())
+        channels = 1;
+    return channels;
+}
+
+/**
+ * Gray at half resolution: output is (width / 2) x (height / 2), each pixel the mean of a 2x2 block.
+ * The two full resolution gray rows live in a small scratch buffer, so the source is still read only once.
+ * `channels` may be 1, 3 or 4.
+ */
+inline void ConvertColorToHalfGray(const uint8_t *src, size_t srcStride, int channels, uint8_t *dst, int width, int height)
+{
+    const int halfWidth = width / 2;
+    const int halfHeight = height / 2;
+    std::vector<uint8_t> rows(static_cast<size_t>(width) * 2);
+    uint8_t *row0 = rows.data();
+    uint8_t *row1 = rows.data() + width;
+
+    if (channels == 1)
+    {
+        for (int y = 0; y < halfHeight; ++y)
+            GrayRowsToHalf(src + (2 * y) * srcStride, src + (2 * y + 1) * srcStride, dst + static_cast<size_t>(y) * halfWidth, halfWidth);
+        return;
+    }
+
+    for (int y = 0; y < halfHeight; ++y)
+    {
+        ColorRowToGray(src + (2 * y) * srcStride, row0, width, channels);
+        ColorRowToGray(src + (2 * y + 1) * srcStride, row1, width, channels);
+        GrayRowsToHalf(row0, row1, dst + static_cast<size_t>(y) * halfWidth, halfWidth);
+    }
+}
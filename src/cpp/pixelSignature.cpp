@@ -0,0 +1,151 @@
+#include <napi.h>
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <pixelSignature.h>
+
+/**
+ * JS handle to a SignatureChecker: a list of points with expected colors, checked against frames to tell which
+ * screen is showing without running a template match.
+ */
+class PixelSignature : public Napi::ObjectWrap<PixelSignature>
+{
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports)
+    {
+        Napi::Function func = DefineClass(env, "PixelSignature",
+                                          {InstanceMethod("test", &PixelSignature::Test),
+                                           InstanceAccessor("size", &PixelSignature::GetSize, nullptr)});
+        constructor = Napi::Persistent(func);
+        constructor.SuppressDestruct();
+        exports.Set("PixelSignature", func);
+        return exports;
+    }
+
+    /**
+     * Returns the checker behind `value` if it is a PixelSignature, or nullptr.
+     */
+    static const SignatureChecker *CheckerOf(Napi::Value value)
+    {
+        if (!value.IsObject() || !value.As<Napi::Object>().InstanceOf(constructor.Value()))
+            return nullptr;
+        return Unwrap(value.As<Napi::Object>())->m_checker.get();
+    }
+
+    /**
+     * new PixelSignature([{ x, y, color: [r, g, b], tolerance }], { tolerance = 10 })
+     */
+    PixelSignature(const Napi::CallbackInfo &info) : Napi::ObjectWrap<PixelSignature>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1 || !info[0].IsArray() || info[0].As<Napi::Array>().Length() == 0)
+        {
+            Napi::TypeError::New(env, "Signature points must be a non-empty array").ThrowAsJavaScriptException();
+            return;
+        }
+
+        int tolerance = 10;
+        if (info.Length() > 1 && info[1].IsObject() && info[1].As<Napi::Object>().Has("tolerance"))
+            tolerance = info[1].As<Napi::Object>().Get("tolerance").ToNumber().Int32Value();
+
+        Napi::Array pointArray = info[0].As<Napi::Array>();
+        std::vector<SignaturePoint> points(pointArray.Length());
+        for (uint32_t i = 0; i < pointArray.Length(); ++i)
+        {
+            if (!ParsePoint(pointArray.Get(i), tolerance, points[i]))
+            {
+                Napi::TypeError::New(env, "Invalid signature point. Expected: { x, y, color: [r, g, b], tolerance? } with x, y >= 0").ThrowAsJavaScriptException();
+                return;
+            }
+        }
+        m_checker = std::make_unique<SignatureChecker>(std::move(points));
+    }
+
+private:
+    static Napi::FunctionReference constructor;
+
+    static bool ParsePoint(Napi::Value value, int defaultTolerance, SignaturePoint &point)
+    {
+        if (!value.IsObject())
+            return false;
+        Napi::Object pointObj = value.As<Napi::Object>();
+        if (!pointObj.Get("x").IsNumber() || !pointObj.Get("y").IsNumber() || !pointObj.Get("color").IsArray())
+            return false;
+
+        point.x = pointObj.Get("x").ToNumber().Int32Value();
+        point.y = pointObj.Get("y").ToNumber().Int32Value();
+        Napi::Array color = pointObj.Get("color").As<Napi::Array>();
+        if (point.x < 0 || point.y < 0 || color.Length() < 3)
+            return false;
+        point.r = cv::saturate_cast<uint8_t>(color.Get((uint32_t)0).ToNumber().Int32Value());
+        point.g = cv::saturate_cast<uint8_t>(color.Get((uint32_t)1).ToNumber().Int32Value());
+        point.b = cv::saturate_cast<uint8_t>(color.Get((uint32_t)2).ToNumber().Int32Value());
+        point.tolerance = pointObj.Get("tolerance").IsNumber() ? pointObj.Get("tolerance").ToNumber().Int32Value() : defaultTolerance;
+        return true;
+    }
+
+    /**
+     * test(frame): whether every point of the signature matches the frame.
+     */
+    Napi::Value Test(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Frame must be provided").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        cv::Mat frame;
+        if (!Image::ImageArgument(env, info[0], frame))
+            return env.Null();
+        return Napi::Boolean::New(env, m_checker->Matches(frame.data, frame.step, frame.cols, frame.rows, frame.channels()));
+    }
+
+    Napi::Value GetSize(const Napi::CallbackInfo &info)
+    {
+        return Napi::Number::New(info.Env(), static_cast<double>(m_checker->Size()));
+    }
+
+    std::unique_ptr<SignatureChecker> m_checker;
+};
+
+Napi::FunctionReference PixelSignature::constructor;
+
+/**
+ * matchSignatures(frame, signatures[]): a Uint8Array with 1 for each signature that matches the frame, 0 otherwise.
+ * The frame is read in place, in its captured layout.
+ */
+Napi::Value MatchSignatures(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[1].IsArray())
+    {
+        Napi::TypeError::New(env, "Invalid arguments. Expected: (frame, signatures[])").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    cv::Mat frame;
+    if (!Image::ImageArgument(env, info[0], frame))
+        return env.Null();
+
+    Napi::Array signatures = info[1].As<Napi::Array>();
+    std::vector<const SignatureChecker *> checkers(signatures.Length());
+    for (uint32_t i = 0; i < signatures.Length(); ++i)
+    {
+        checkers[i] = PixelSignature::CheckerOf(signatures.Get(i));
+        if (!checkers[i])
+        {
+            Napi::TypeError::New(env, "Signatures must be PixelSignature objects").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    Napi::Uint8Array passed = Napi::Uint8Array::New(env, checkers.size());
+    for (size_t i = 0; i < checkers.size(); ++i)
+        passed[i] = checkers[i]->Matches(frame.data, frame.step, frame.cols, frame.rows, frame.channels()) ? 1 : 0;
+    return passed;
+}
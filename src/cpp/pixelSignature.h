@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include <pixelConvert.h>
+
+/**
+ * One pixel of a signature: where it is and the color expected there, within a tolerance per channel.
+ */
+struct SignaturePoint
+{
+    int x = 0;
+    int y = 0;
+    uint8_t b = 0;
+    uint8_t g = 0;
+    uint8_t r = 0;
+    // Expected value in gray frames, with the same weights the gray capture formats use
+    uint8_t gray = 0;
+    int tolerance = 0;
+};
+
+/**
+ * A handful of pixels that together identify a screen state. Checking one reads only those pixels straight out of
+ * the frame, in whatever layout it was captured (gray, BGR or BGRA, any row stride), and stops at the first pixel
+ * that is off.
+ */
+class SignatureChecker
+{
+public:
+    explicit SignatureChecker(std::vector<SignaturePoint> points) : m_points(std::move(points))
+    {
+        for (SignaturePoint &point : m_points)
+        {
+            point.gray = GrayPixel(point.b, point.g, point.r);
+            m_right = std::max(m_right, point.x + 1);
+            m_bottom = std::max(m_bottom, point.y + 1);
+        }
+    }
+
+    /**
+     * True if every point is inside the frame and within its tolerance.
+     */
+    bool Matches(const uint8_t *data, size_t stride, int width, int height, int channels) const
+    {
+        // Points are never negative, so one check on the bounding box covers them all
+        if (m_right > width || m_bottom > height)
+            return false;
+
+        for (const SignaturePoint &point : m_points)
+        {
+            const uint8_t *pixel = data + point.y * stride + static_cast<size_t>(point.x) * channels;
+            if (channels < 3)
+            {
+                if (std::abs(pixel[0] - point.gray) > point.tolerance)
+                    return false;
+            }
+            else if (std::abs(pixel[0] - point.b) > point.tolerance || std::abs(pixel[1] - point.g) > point.tolerance ||
+                     std::abs(pixel[2] - point.r) > point.tolerance)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t Size() const
+    {
+        return m_points.size();
+    }
+
+private:
+    std::vector<SignaturePoint> m_points;
+    int m_right = 0;
+    int m_bottom = 0;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <peaks.h>
+#include <stopCondition.h>
+
+// Templates are not shrunk below this many pixels on a side, since they stop carrying enough detail to match
+const int PYRAMID_MIN_TEMPLATE_SIZE = 8;
+
+struct PyramidOptions
+{
+    // How many times the image and template are halved for the coarse search. 0 disables the pyramid.
+    int levels = 0;
+    // How many of the best coarse matches are refined at full resolution
+    int candidates = 5;
+};
+
+/**
+ * The number of levels actually usable for a template: the requested count, reduced until the shrunk template
+ * keeps PYRAMID_MIN_TEMPLATE_SIZE pixels on each side.
+ */
+inline int UsablePyramidLevels(cv::Size templSize, int levels)
+{
+    while (levels > 0 && std::min(templSize.width, templSize.height) >> levels < PYRAMID_MIN_TEMPLATE_SIZE)
+        --levels;
+    return levels;
+}
+
+/**
+ * Coarse-to-fine template matching. Matches at 1 / 2^levels scale, keeps the best `candidates` coarse matches
+ * (overlapping ones suppressed), then re-runs the match at full resolution only in a small window around each.
+ * Returns the extremes over the refined windows, so the best match is exact wherever the coarse search found
+ * the right neighbourhood; the opposite extreme only covers those windows.
+ * Falls back to an exhaustive search when the template is too small for even one level.
+ */
+inline MatchExtremes PyramidMatchTemplate(const cv::Mat &src, const cv::Mat &templ, int method, const PyramidOptions &options,
+                                          const StopCondition *stop = nullptr)
+{
+    const int levels = UsablePyramidLevels(templ.size(), options.levels);
+    cv::Mat response;
+    if (levels == 0)
+    {
+        cv::matchTemplate(src, templ, response, method);
+        return FindExtremes(response);
+    }
+
+    cv::Mat smallSrc = src, smallTempl = templ;
+    for (int level = 0; level < levels; ++level)
+    {
+        cv::pyrDown(smallSrc, smallSrc);
+        cv::pyrDown(smallTempl, smallTempl);
+    }
+    cv::matchTemplate(smallSrc, smallTempl, response, method);
+
+    PeakOptions peakOptions;
+    peakOptions.lowerIsBetter = method == cv::TM_SQDIFF || method == cv::TM_SQDIFF_NORMED;
+    peakOptions.threshold = peakOptions.lowerIsBetter ? std::numeric_limits<double>::max() : std::numeric_limits<double>::lowest();
+    peakOptions.maxResults = static_cast<size_t>(std::max(options.candidates, 1));
+    peakOptions.nmsOverlap = 0.5;
+    std::vector<Peak> candidates = FindPeaks(response, smallTempl.size(), peakOptions);
+
+    // pyrDown rounds sizes up, so one coarse pixel can be off by a little more than the scale
+    const int scale = 1 << levels;
+    const int margin = scale * 2;
+    MatchExtremes best;
+    bool first = true;
+    for (const Peak &candidate : candidates)
+    {
+        if (stop)
+            stop->ThrowIfStopped();
+        const int left = std::max(candidate.x * scale - margin, 0);
+        const int top = std::max(candidate.y * scale - margin, 0);
+        const int right = std::min(candidate.x * scale + margin + templ.cols, src.cols);
+        const int bottom = std::min(candidate.y * scale + margin + templ.rows, src.rows);
+        if (right - left < templ.cols || bottom - top < templ.rows)
+            continue;
+
+        cv::matchTemplate(src(cv::Rect(left, top, right - left, bottom - top)), templ, response, method);
+        MergeExtremes(best, FindExtremes(response), cv::Point(left, top), first);
+        first = false;
+    }
+    return best;
+}
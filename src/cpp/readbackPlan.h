@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * A rectangle in frame pixels.
+ */
+struct FrameRect
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+/**
+ * Copies `source` from the captured frame to (dstX, dstY) of the readback area.
+ */
+struct RegionCopy
+{
+    FrameRect source;
+    int dstX = 0;
+    int dstY = 0;
+};
+
+/**
+ * How to read a set of regions back from a frame: the size of the readback area, the copies that fill it,
+ * and where each requested region ends up inside it (in request order).
+ */
+struct ReadbackPlan
+{
+    int width = 0;
+    int height = 0;
+    std::vector<RegionCopy> copies;
+    std::vector<FrameRect> regions;
+};
+
+// A shared bounding box is used as long as it is at most this many times larger than the regions themselves
+const int64_t READBACK_BOUNDING_BOX_SLACK = 2;
+
+inline bool RegionInsideFrame(const FrameRect &region, int frameWidth, int frameHeight)
+{
+    return region.x >= 0 && region.y >= 0 && region.width > 0 && region.height > 0 &&
+           region.x + region.width <= frameWidth && region.y + region.height <= frameHeight;
+}
+
+/**
+ * Plans the readback of `regions` from a frame of the given size. Throws std::runtime_error if a region is empty
+ * or not fully inside the frame.
+ * Regions close together are read with a single copy of their bounding box; scattered regions are copied one by one
+ * and stacked vertically, so pixels between them are never read back.
+ */
+inline ReadbackPlan PlanReadback(int frameWidth, int frameHeight, const std::vector<FrameRect> &regions)
+{
+    ReadbackPlan plan;
+    if (regions.empty())
+    {
+        plan.width = frameWidth;
+        plan.height = frameHeight;
+        plan.copies.push_back({{0, 0, frameWidth, frameHeight}, 0, 0});
+        plan.regions.push_back({0, 0, frameWidth, frameHeight});
+        return plan;
+    }
+
+    int left = frameWidth, top = frameHeight, right = 0, bottom = 0;
+    int64_t regionsArea = 0;
+    for (const FrameRect &region : regions)
+    {
+        if (!RegionInsideFrame(region, frameWidth, frameHeight))
+            throw std::runtime_error("Capture region is empty or outside the window");
+        left = std::min(left, region.x);
+        top = std::min(top, region.y);
+        right = std::max(right, region.x + region.width);
+        bottom = std::max(bottom, region.y + region.height);
+        regionsArea += static_cast<int64_t>(region.width) * region.height;
+    }
+
+    const int64_t boundsArea = static_cast<int64_t>(right - left) * (bottom - top);
+    if (boundsArea <= regionsArea * READBACK_BOUNDING_BOX_SLACK)
+    {
+        plan.width = right - left;
+        plan.height = bottom - top;
+        plan.copies.push_back({{left, top, plan.width, plan.height}, 0, 0});
+        for (const FrameRect &region : regions)
+            plan.regions.push_back({region.x - left, region.y - top, region.width, region.height});
+        return plan;
+    }
+
+    for (const FrameRect &region : regions)
+    {
+        plan.copies.push_back({region, 0, plan.height});
+        plan.regions.push_back({0, plan.height, region.width, region.height});
+        plan.width = std::max(plan.width, region.width);
+        plan.height += region.height;
+    }
+    return plan;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * The parts of an image a template is searched in: each requested region clipped to the image, skipping those
+ * too small to hold the template. No regions means the whole image.
+ * Matching inside `image(window)` only views the source, and a location found there is moved back to full-image
+ * coordinates by adding `window.tl()`.
+ */
+inline std::vector<cv::Rect> SearchWindows(cv::Size imageSize, cv::Size templSize, const std::vector<cv::Rect> &regions)
+{
+    const cv::Rect bounds(cv::Point(0, 0), imageSize);
+    if (regions.empty())
+        return {bounds};
+
+    std::vector<cv::Rect> windows;
+    for (const cv::Rect &region : regions)
+    {
+        const cv::Rect window = region & bounds;
+        if (window.width >= templSize.width && window.height >= templSize.height)
+            windows.push_back(window);
+    }
+    return windows;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fixed-capacity ring for handing records from exactly one producer thread to exactly one consumer thread
+ * without locks or allocation. A full ring drops the new record and counts it instead of waiting, so the
+ * producer never blocks.
+ *
+ * Wakeups are coalesced: the producer calls RequestWakeup() after pushing and only signals the consumer when it
+ * returns true; the consumer calls BeginDrain() before draining, which re-arms the wakeup. A record pushed at any
+ * point is then either drained by the running drain or triggers a new wakeup.
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    /**
+     * Producer: appends `item`. Returns false and counts an overflow if the ring is full.
+     */
+    bool TryPush(const T &item)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+        {
+            m_overflow.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_items[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Producer: returns true if the consumer has to be woken, i.e. no wakeup is pending since its last drain.
+     */
+    bool RequestWakeup()
+    {
+        return !m_wakePending.exchange(true, std::memory_order_acq_rel);
+    }
+
+    /**
+     * Consumer: re-arms the wakeup. Call before Drain, so a record pushed during the drain wakes the consumer again.
+     */
+    void BeginDrain()
+    {
+        m_wakePending.exchange(false, std::memory_order_acq_rel);
+    }
+
+    /**
+     * Consumer: removes the oldest record into `item`. Returns false if the ring is empty.
+     */
+    bool TryPop(T &item)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        item = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer: calls `handle(item)` for every record queued when the drain started, oldest first, and frees their
+     * slots at the end. Returns how many were handled.
+     */
+    template <typename Handler>
+    size_t Drain(Handler &&handle)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        for (size_t i = head; i != tail; ++i)
+            handle(m_items[i & (Capacity - 1)]);
+        m_head.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+    /**
+     * Records dropped because the ring was full, since it was created.
+     */
+    uint64_t Overflow() const
+    {
+        return m_overflow.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Producer and consumer indexes on separate cache lines, so each side writes only its own line
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<bool> m_wakePending{false};
+    std::atomic<uint64_t> m_overflow{0};
+    std::array<T, Capacity> m_items;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+enum class StopReason
+{
+    Cancelled,
+    DeadlineExceeded
+};
+
+/**
+ * Thrown out of a long-running operation that gave up because it was cancelled or ran past its deadline.
+ */
+class OperationStopped : public std::runtime_error
+{
+public:
+    explicit OperationStopped(StopReason reason)
+        : std::runtime_error(reason == StopReason::Cancelled ? "The operation was cancelled" : "The operation ran past its deadline"),
+          m_reason(reason)
+    {
+    }
+
+    StopReason Reason() const
+    {
+        return m_reason;
+    }
+
+private:
+    StopReason m_reason;
+};
+
+/**
+ * When a long-running operation should give up: once its cancel flag is set or its deadline passes. Operations
+ * check it between units of work (tiles, drag steps, typed characters), so a unit already started still finishes.
+ * Copies share the cancel flag.
+ */
+class StopCondition
+{
+public:
+    /**
+     * Gives up `milliseconds` from now.
+     */
+    void SetTimeout(int milliseconds)
+    {
+        m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+        m_hasDeadline = true;
+    }
+
+    /**
+     * Returns the cancel flag, creating it on first use. Setting it to true stops the operation.
+     */
+    const std::shared_ptr<std::atomic<bool>> &CancelFlag()
+    {
+        if (!m_cancel)
+            m_cancel = std::make_shared<std::atomic<bool>>(false);
+        return m_cancel;
+    }
+
+    /**
+     * Whether the operation should give up, for checks inside cv::parallel_for_ bodies, which should not throw.
+     * The caller calls ThrowIfStopped once the loop returns.
+     */
+    bool ShouldStop() const
+    {
+        return (m_cancel && m_cancel->load()) || (m_hasDeadline && std::chrono::steady_clock::now() >= m_deadline);
+    }
+
+    /**
+     * Throws OperationStopped if the operation should give up.
+     */
+    void ThrowIfStopped() const
+    {
+        if (m_cancel && m_cancel->load())
+            throw OperationStopped(StopReason::Cancelled);
+        if (m_hasDeadline && std::chrono::steady_clock::now() >= m_deadline)
+            throw OperationStopped(StopReason::DeadlineExceeded);
+    }
+
+    /**
+     * Sleeps for `duration`, in short slices so cancelling takes effect within a few milliseconds, and throws
+     * OperationStopped as soon as the operation should give up.
+     */
+    void SleepFor(std::chrono::milliseconds duration) const
+    {
+        const std::chrono::milliseconds slice(10);
+        const auto end = std::chrono::steady_clock::now() + duration;
+        while (true)
+        {
+            ThrowIfStopped();
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= end)
+                return;
+            auto wake = std::min(end, now + slice);
+            if (m_hasDeadline)
+                wake = std::min(wake, m_deadline);
+            std::this_thread::sleep_until(wake);
+        }
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancel;
+    std::chrono::steady_clock::time_point m_deadline;
+    bool m_hasDeadline = false;
+};
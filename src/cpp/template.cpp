@@ -0,0 +1,236 @@
+#include <napi.h>
+#include <memory>
+#include <stdexcept>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <errors.h>
+#include <peaks.h>
+#include <pixelConvert.h>
+#include <stopCondition.h>
+#include <templateSpectrum.h>
+#include <templateStats.h>
+
+/**
+ * A template compiled once for repeated matching: converted to gray if requested, with its mean and norms,
+ * its mask and (on request, for large single-channel templates) its DFT spectrum precomputed. Matching a new frame
+ * only does the work that depends on the frame.
+ */
+class Template : public Napi::ObjectWrap<Template>
+{
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports)
+    {
+        Napi::Function func = DefineClass(env, "Template",
+                                          {InstanceMethod("match", &Template::Match),
+                                           InstanceMethod("matchAll", &Template::MatchAll),
+                                           InstanceAccessor("width", &Template::GetWidth, nullptr),
+                                           InstanceAccessor("height", &Template::GetHeight, nullptr),
+                                           InstanceAccessor("channels", &Template::GetChannels, nullptr)});
+        exports.Set("Template", func);
+        return exports;
+    }
+
+    /**
+     * new Template(image, { method = TM_CCOEFF_NORMED, gray = false, mask, dft = false })
+     * `dft` is opt-in: OpenCV's own matchTemplate already switches to a DFT for large templates, and whether the
+     * cached spectrum wins depends on the template and frame sizes (bench/templateCompile.js measures it).
+     */
+    Template(const Napi::CallbackInfo &info) : Napi::ObjectWrap<Template>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Template image must be provided").ThrowAsJavaScriptException();
+            return;
+        }
+
+        cv::Mat templ;
+        if (!Image::ImageArgument(env, info[0], templ))
+            return;
+
+        PeakOptions unused;
+        if (!ParsePeakOptions(info, 1, m_method, unused))
+            return;
+
+        cv::Mat mask;
+        bool useDft = false;
+        if (info.Length() > 1 && info[1].IsObject())
+        {
+            Napi::Object optionsObj = info[1].As<Napi::Object>();
+            if (optionsObj.Has("gray"))
+                m_gray = optionsObj.Get("gray").ToBoolean().Value();
+            if (optionsObj.Has("dft"))
+                useDft = optionsObj.Get("dft").ToBoolean().Value();
+            if (optionsObj.Has("mask") && !optionsObj.Get("mask").IsUndefined() && !Image::ImageArgument(env, optionsObj.Get("mask"), mask))
+                return;
+        }
+
+        m_templ = PrepareImage(templ, true);
+        m_stats = ComputeTemplateStats(m_templ);
+
+        if (!mask.empty())
+        {
+            if (mask.size() != m_templ.size())
+            {
+                Napi::TypeError::New(env, "Mask must have the size of the template").ThrowAsJavaScriptException();
+                return;
+            }
+            // OpenCV wants a single-channel mask or one with the template's channel count
+            if (mask.channels() != 1 && mask.channels() != m_templ.channels())
+                cv::cvtColor(mask, m_mask, mask.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+            else
+                m_mask = mask.clone();
+        }
+
+        if (useDft && m_mask.empty() && m_templ.channels() == 1 && m_templ.total() >= static_cast<size_t>(DFT_MIN_TEMPLATE_AREA))
+            m_spectrum = std::make_unique<TemplateSpectrum>(m_templ);
+    }
+
+private:
+    /**
+     * Converts an image to what the template is matched in: gray if the template was compiled with `gray`.
+     * Templates are always copied, sources only when they need converting.
+     */
+    cv::Mat PrepareImage(const cv::Mat &image, bool copy) const
+    {
+        if (!m_gray || image.channels() == 1)
+            return copy ? image.clone() : image;
+
+        cv::Mat gray(image.rows, image.cols, CV_8UC1);
+        if (image.channels() >= 3)
+            ConvertColorToGray(image.data, image.step, image.channels(), gray.data, image.cols, image.rows);
+        else
+            cv::extractChannel(image, gray, 0);
+        return gray;
+    }
+
+    /**
+     * The response map of this template over `image`. `stop` is checked before the conversion, the statistics and
+     * the correlation.
+     */
+    void Respond(const cv::Mat &image, cv::Mat &response, const StopCondition &stop) const
+    {
+        stop.ThrowIfStopped();
+        // A BGRA capture is matched against a BGR template without its alpha
+        cv::Mat src = ReduceChannels(PrepareImage(image, false), m_templ.channels());
+        if (src.type() != m_templ.type() || src.cols < m_templ.cols || src.rows < m_templ.rows)
+            throw std::runtime_error("Image must have at least the template's channels and be at least as large");
+
+        stop.ThrowIfStopped();
+        if (!m_mask.empty())
+        {
+            cv::matchTemplate(src, m_templ, response, m_method, m_mask);
+            return;
+        }
+
+        SourceStats srcStats;
+        if (MethodNeedsSourceStats(m_method))
+        {
+            srcStats = ComputeSourceStats(src);
+            stop.ThrowIfStopped();
+        }
+
+        if (m_spectrum)
+            m_spectrum->Correlate(src, response);
+        else
+            cv::matchTemplate(src, m_templ, response, cv::TM_CCORR);
+        NormalizeCorrelation(response, srcStats, m_stats, m_method);
+    }
+
+    /**
+     * Reads the image argument and `{ signal, timeout }` from info[1], and computes the response. Throws a JS error
+     * and returns false on failure.
+     */
+    bool RespondTo(const Napi::CallbackInfo &info, cv::Mat &response) const
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Image to search must be provided").ThrowAsJavaScriptException();
+            return false;
+        }
+
+        cv::Mat src;
+        if (!Image::ImageArgument(env, info[0], src))
+            return false;
+        StopCondition stop;
+        if (!ParseStopOptions(info, 1, stop))
+            return false;
+
+        try
+        {
+            Respond(src, response, stop);
+        }
+        catch (const cv::Exception &e)
+        {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return false;
+        }
+        catch (const OperationStopped &e)
+        {
+            StoppedError(env, e).ThrowAsJavaScriptException();
+            return false;
+        }
+        catch (const std::runtime_error &e)
+        {
+            Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * match(image, { signal, timeout }): same result as matchTemplate(image, template, method, mask).
+     */
+    Napi::Value Match(const Napi::CallbackInfo &info)
+    {
+        cv::Mat response;
+        if (!RespondTo(info, response))
+            return info.Env().Null();
+        return ExtremesToValue(info.Env(), FindExtremes(response));
+    }
+
+    /**
+     * matchAll(image, { threshold, maxResults, nmsOverlap, signal, timeout }): same result as matchTemplateAll.
+     */
+    Napi::Value MatchAll(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        int method = m_method;
+        PeakOptions options;
+        if (!ParsePeakOptions(info, 1, method, options))
+            return env.Null();
+        // The method is fixed when the template is compiled
+        options.lowerIsBetter = m_method == cv::TM_SQDIFF || m_method == cv::TM_SQDIFF_NORMED;
+
+        cv::Mat response;
+        if (!RespondTo(info, response))
+            return env.Null();
+        return PeaksToValue(env, FindPeaks(response, m_templ.size(), options));
+    }
+
+    Napi::Value GetWidth(const Napi::CallbackInfo &info)
+    {
+        return Napi::Number::New(info.Env(), m_templ.cols);
+    }
+
+    Napi::Value GetHeight(const Napi::CallbackInfo &info)
+    {
+        return Napi::Number::New(info.Env(), m_templ.rows);
+    }
+
+    Napi::Value GetChannels(const Napi::CallbackInfo &info)
+    {
+        return Napi::Number::New(info.Env(), m_templ.channels());
+    }
+
+    cv::Mat m_templ;
+    cv::Mat m_mask;
+    TemplateStats m_stats;
+    std::unique_ptr<TemplateSpectrum> m_spectrum;
+    int m_method = cv::TM_CCOEFF_NORMED;
+    bool m_gray = false;
+};
@@ -0,0 +1,281 @@
+#include <napi.h>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <errors.h>
+#include <peaks.h>
+#include <stopCondition.h>
+#include <templateStats.h>
+
+/**
+ * A template prepared at several scales, e.g. for the 100%, 125% and 150% DPI renderings of one UI element.
+ * The scaled copies and their statistics are computed once at construction. A search matches every scale
+ * against the same image, sharing the image's integral images between scales and running scales in parallel.
+ * Images and templates with different channel counts are compared at the smaller one, like matchTemplate.
+ */
+class TemplateBank : public Napi::ObjectWrap<TemplateBank>
+{
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports)
+    {
+        Napi::Function func = DefineClass(env, "TemplateBank",
+                                          {InstanceMethod("match", &TemplateBank::Match),
+                                           InstanceMethod("matchAll", &TemplateBank::MatchAll),
+                                           InstanceAccessor("scales", &TemplateBank::GetScales, nullptr)});
+        exports.Set("TemplateBank", func);
+        return exports;
+    }
+
+    /**
+     * new TemplateBank(template, { scales = [1], method = TM_CCOEFF_NORMED })
+     */
+    TemplateBank(const Napi::CallbackInfo &info) : Napi::ObjectWrap<TemplateBank>(info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Template image must be provided").ThrowAsJavaScriptException();
+            return;
+        }
+
+        cv::Mat templ;
+        if (!Image::ImageArgument(env, info[0], templ))
+            return;
+
+        std::vector<double> scales{1.0};
+        PeakOptions unused;
+        if (!ParsePeakOptions(info, 1, m_method, unused))
+            return;
+        if (info.Length() > 1 && info[1].IsObject() && info[1].As<Napi::Object>().Has("scales"))
+        {
+            Napi::Value scalesValue = info[1].As<Napi::Object>().Get("scales");
+            if (!scalesValue.IsArray() || scalesValue.As<Napi::Array>().Length() == 0)
+            {
+                Napi::TypeError::New(env, "'scales' must be a non-empty array of numbers").ThrowAsJavaScriptException();
+                return;
+            }
+            Napi::Array scalesArray = scalesValue.As<Napi::Array>();
+            scales.clear();
+            for (uint32_t i = 0; i < scalesArray.Length(); ++i)
+            {
+                double scale = scalesArray.Get(i).ToNumber().DoubleValue();
+                if (!(scale > 0))
+                {
+                    Napi::TypeError::New(env, "Template scales must be positive numbers").ThrowAsJavaScriptException();
+                    return;
+                }
+                scales.push_back(scale);
+            }
+        }
+
+        for (double scale : scales)
+        {
+            ScaledTemplate scaled;
+            scaled.scale = scale;
+            if (scale == 1.0)
+                scaled.templ = templ.clone();
+            else
+                cv::resize(templ, scaled.templ, cv::Size(), scale, scale, scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+
+            if (scaled.templ.empty())
+            {
+                Napi::TypeError::New(env, "Template scale is too small").ThrowAsJavaScriptException();
+                return;
+            }
+            scaled.stats = ComputeTemplateStats(scaled.templ);
+            m_templates.push_back(std::move(scaled));
+        }
+    }
+
+private:
+    struct ScaledTemplate
+    {
+        double scale = 1.0;
+        cv::Mat templ;
+        TemplateStats stats;
+    };
+
+    /**
+     * Matches every scale that fits inside `src` and collects the local extrema passing `options`,
+     * or only the best match of each scale when `bestOnly` is set. `stop` is checked before each scale.
+     */
+    std::vector<Peak> Search(const cv::Mat &image, const PeakOptions &options, const StopCondition &stop, bool bestOnly = false)
+    {
+        // Every scale has the channels of the original template, so the image is reduced once for all of them
+        const int channels = CommonChannels(image, m_templates[0].templ);
+        const cv::Mat src = ReduceChannels(image, channels);
+
+        SourceStats srcStats;
+        if (MethodNeedsSourceStats(m_method))
+            srcStats = ComputeSourceStats(src);
+
+        std::vector<std::vector<Peak>> perScale(m_templates.size());
+        cv::parallel_for_(cv::Range(0, static_cast<int>(m_templates.size())), [&](const cv::Range &range)
+                          {
+            cv::Mat response;
+            for (int i = range.start; i < range.end && !stop.ShouldStop(); ++i)
+            {
+                const ScaledTemplate &scaled = m_templates[i];
+                if (scaled.templ.cols > src.cols || scaled.templ.rows > src.rows)
+                    continue;
+                if (scaled.templ.channels() == channels)
+                {
+                    MatchWithStats(src, srcStats, scaled.templ, scaled.stats, m_method, response);
+                }
+                else
+                {
+                    // A color bank searched in a gray image: the reduced template needs its own statistics
+                    const cv::Mat templ = ReduceChannels(scaled.templ, channels);
+                    MatchWithStats(src, srcStats, templ, ComputeTemplateStats(templ), m_method, response);
+                }
+                if (bestOnly)
+                {
+                    MatchExtremes extremes = FindExtremes(response);
+                    cv::Point location = options.lowerIsBetter ? extremes.minLocation : extremes.maxLocation;
+                    double score = options.lowerIsBetter ? extremes.minValue : extremes.maxValue;
+                    perScale[i].push_back({location.x, location.y, scaled.templ.cols, scaled.templ.rows, static_cast<float>(score), i});
+                }
+                else
+                {
+                    CollectPeaks(response, scaled.templ.size(), options, perScale[i], i);
+                }
+            } });
+        stop.ThrowIfStopped();
+
+        std::vector<Peak> candidates;
+        for (const std::vector<Peak> &peaks : perScale)
+            candidates.insert(candidates.end(), peaks.begin(), peaks.end());
+        return SuppressOverlaps(std::move(candidates), options);
+    }
+
+    /**
+     * Packs matches into `{ count, x, y, width, height: Int32Array, score, scale: Float32Array }`.
+     */
+    Napi::Object HitsToValue(Napi::Env env, const std::vector<Peak> &peaks)
+    {
+        Napi::Object result = PeaksToValue(env, peaks);
+        Napi::Int32Array widths = Napi::Int32Array::New(env, peaks.size());
+        Napi::Int32Array heights = Napi::Int32Array::New(env, peaks.size());
+        Napi::Float32Array scales = Napi::Float32Array::New(env, peaks.size());
+        for (size_t i = 0; i < peaks.size(); ++i)
+        {
+            widths[i] = peaks[i].width;
+            heights[i] = peaks[i].height;
+            scales[i] = static_cast<float>(m_templates[peaks[i].index].scale);
+        }
+        result.Set("width", widths);
+        result.Set("height", heights);
+        result.Set("scale", scales);
+        return result;
+    }
+
+    /**
+     * match(image, { signal, timeout }): the single best hit over all scales, as `{ x, y, width, height, score, scale }`,
+     * or null when no scale fits inside the image.
+     */
+    Napi::Value Match(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Image to search must be provided").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        cv::Mat src;
+        if (!Image::ImageArgument(env, info[0], src))
+            return env.Null();
+
+        StopCondition stop;
+        if (!ParseStopOptions(info, 1, stop))
+            return env.Null();
+
+        PeakOptions options;
+        options.lowerIsBetter = m_method == cv::TM_SQDIFF || m_method == cv::TM_SQDIFF_NORMED;
+        options.maxResults = 1;
+
+        std::vector<Peak> peaks;
+        try
+        {
+            peaks = Search(src, options, stop, true);
+        }
+        catch (const cv::Exception &e)
+        {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        catch (const OperationStopped &e)
+        {
+            StoppedError(env, e).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        if (peaks.empty())
+            return env.Null();
+
+        const Peak &best = peaks[0];
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("x", best.x);
+        result.Set("y", best.y);
+        result.Set("width", best.width);
+        result.Set("height", best.height);
+        result.Set("score", best.score);
+        result.Set("scale", m_templates[best.index].scale);
+        return result;
+    }
+
+    /**
+     * matchAll(image, { threshold, maxResults, nmsOverlap, signal, timeout }): every hit over all scales, best first.
+     * Hits at different scales covering the same spot are merged, keeping the best scoring scale.
+     */
+    Napi::Value MatchAll(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+
+        if (info.Length() < 1)
+        {
+            Napi::TypeError::New(env, "Image to search must be provided").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        cv::Mat src;
+        if (!Image::ImageArgument(env, info[0], src))
+            return env.Null();
+
+        int method = m_method;
+        PeakOptions options;
+        StopCondition stop;
+        if (!ParsePeakOptions(info, 1, method, options) || !ParseStopOptions(info, 1, stop))
+            return env.Null();
+        // The method is fixed when the bank is built
+        options.lowerIsBetter = m_method == cv::TM_SQDIFF || m_method == cv::TM_SQDIFF_NORMED;
+
+        try
+        {
+            return HitsToValue(env, Search(src, options, stop));
+        }
+        catch (const cv::Exception &e)
+        {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        catch (const OperationStopped &e)
+        {
+            StoppedError(env, e).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    Napi::Value GetScales(const Napi::CallbackInfo &info)
+    {
+        Napi::Env env = info.Env();
+        Napi::Array scales = Napi::Array::New(env, m_templates.size());
+        for (size_t i = 0; i < m_templates.size(); ++i)
+            scales.Set(static_cast<uint32_t>(i), m_templates[i].scale);
+        return scales;
+    }
+
+    std::vector<ScaledTemplate> m_templates;
+    int m_method = cv::TM_CCOEFF_NORMED;
+};
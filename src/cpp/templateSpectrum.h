@@ -0,0 +1,128 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Below this many template pixels a direct correlation beats the three DFTs
+const int DFT_MIN_TEMPLATE_AREA = 18 * 18;
+
+// From this many template pixels, matchTemplates correlates against a source DFT shared by all templates. Set above
+// DFT_MIN_TEMPLATE_AREA since the shared transform covers the whole source rather than OpenCV's smaller blocks.
+const int SHARED_DFT_MIN_TEMPLATE_AREA = 64 * 64;
+
+/**
+ * The DFT of a single-channel image zero-padded to `dftSize`, in the packed format cv::dft produces.
+ */
+inline cv::Mat PaddedSpectrum(const cv::Mat &image, cv::Size dftSize)
+{
+    cv::Mat padded(dftSize, CV_32F, cv::Scalar::all(0));
+    image.convertTo(padded(cv::Rect(0, 0, image.cols, image.rows)), CV_32F);
+    cv::Mat spectrum;
+    cv::dft(padded, spectrum, 0, image.rows);
+    return spectrum;
+}
+
+/**
+ * Turns the product of a source and a conjugated template spectrum into the TM_CCORR response (CV_32F) of the
+ * template over the source.
+ */
+inline void CorrelationFromProduct(const cv::Mat &product, cv::Size srcSize, cv::Size templSize, cv::Mat &result)
+{
+    cv::Mat correlation;
+    cv::idft(product, correlation, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+    // Positions where the template lies fully inside the source never wrap around the padded image
+    correlation(cv::Rect(0, 0, srcSize.width - templSize.width + 1, srcSize.height - templSize.height + 1)).copyTo(result);
+}
+
+/**
+ * Cross-correlation of single-channel images through a DFT, keeping the template's spectrum between calls.
+ * The spectrum depends on the DFT size, so it is recomputed only when the source size changes; a stream of
+ * same-sized frames pays for two DFTs per match instead of three.
+ */
+class TemplateSpectrum
+{
+public:
+    explicit TemplateSpectrum(const cv::Mat &templ)
+    {
+        templ.convertTo(m_templ, CV_32F);
+    }
+
+    /**
+     * Writes the TM_CCORR response of the template over `src` (CV_8UC1 or CV_32FC1) into `result` (CV_32F).
+     * Safe to call from several threads at once.
+     */
+    void Correlate(const cv::Mat &src, cv::Mat &result)
+    {
+        const cv::Size dftSize(cv::getOptimalDFTSize(src.cols), cv::getOptimalDFTSize(src.rows));
+        cv::Mat spectrum = SpectrumFor(dftSize);
+
+        cv::Mat product;
+        cv::mulSpectrums(PaddedSpectrum(src, dftSize), spectrum, product, 0, true);
+        CorrelationFromProduct(product, src.size(), m_templ.size(), result);
+    }
+
+private:
+    cv::Mat SpectrumFor(cv::Size dftSize)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_dftSize != dftSize)
+        {
+            // A new Mat, so spectra handed out earlier are left untouched
+            m_spectrum = PaddedSpectrum(m_templ, dftSize);
+            m_dftSize = dftSize;
+        }
+        return m_spectrum;
+    }
+
+    cv::Mat m_templ;
+    cv::Mat m_spectrum;
+    cv::Size m_dftSize;
+    std::mutex m_mutex;
+};
+
+/**
+ * The DFT of a source image, computed once and correlated with any number of templates of its channel count.
+ * Each channel is transformed on its own; a template's per-channel products are summed before one inverse DFT,
+ * which gives the multi-channel TM_CCORR response cv::matchTemplate computes. Per template that costs one DFT per
+ * channel and one inverse DFT, where a TemplateSpectrum also pays for the source's transforms.
+ */
+class SourceSpectrum
+{
+public:
+    explicit SourceSpectrum(const cv::Mat &src)
+        : m_size(src.size()), m_dftSize(cv::getOptimalDFTSize(src.cols), cv::getOptimalDFTSize(src.rows))
+    {
+        std::vector<cv::Mat> planes;
+        cv::split(src, planes);
+        for (const cv::Mat &plane : planes)
+            m_spectra.push_back(PaddedSpectrum(plane, m_dftSize));
+    }
+
+    /**
+     * Writes the TM_CCORR response of `templ`, which has the source's channel count and fits inside it, into
+     * `result` (CV_32F). Safe to call from several threads at once.
+     */
+    void Correlate(const cv::Mat &templ, cv::Mat &result) const
+    {
+        std::vector<cv::Mat> planes;
+        cv::split(templ, planes);
+
+        cv::Mat sum;
+        for (size_t c = 0; c < planes.size(); ++c)
+        {
+            cv::Mat product;
+            cv::mulSpectrums(m_spectra[c], PaddedSpectrum(planes[c], m_dftSize), product, 0, true);
+            if (sum.empty())
+                sum = product;
+            else
+                sum += product;
+        }
+        CorrelationFromProduct(sum, m_size, templ.size(), result);
+    }
+
+private:
+    cv::Size m_size;
+    cv::Size m_dftSize;
+    std::vector<cv::Mat> m_spectra;
+};
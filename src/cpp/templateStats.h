@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+/**
+ * Template matching split into the parts that depend only on the source, only on the template, or on both,
+ * so that work shared by several matches is done once. Produces the same scores as cv::matchTemplate:
+ * the cross-correlation still comes from OpenCV (which switches to a DFT for large templates), and the
+ * normalization below is the one OpenCV applies on top of it.
+ */
+
+/**
+ * Per-channel sums of a template, for normalizing its cross-correlation.
+ */
+struct TemplateStats
+{
+    cv::Size size;
+    int channels = 0;
+    cv::Scalar mean;
+    // Sum of squared pixel values over all channels
+    double sumSq = 0;
+    // sqrt of the sum of squared differences from the mean, over all channels
+    double deviation = 0;
+};
+
+inline TemplateStats ComputeTemplateStats(const cv::Mat &templ)
+{
+    TemplateStats stats;
+    stats.size = templ.size();
+    stats.channels = templ.channels();
+
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(templ, mean, stddev);
+    stats.mean = mean;
+
+    const double area = static_cast<double>(templ.total());
+    double variance = 0;
+    for (int c = 0; c < stats.channels; ++c)
+    {
+        variance += stddev[c] * stddev[c] * area;
+        stats.sumSq += (stddev[c] * stddev[c] + mean[c] * mean[c]) * area;
+    }
+    stats.deviation = std::sqrt(variance);
+    return stats;
+}
+
+/**
+ * Integral images of a source image, shared by every template matched against it.
+ */
+struct SourceStats
+{
+    cv::Mat sum;
+    cv::Mat sqsum;
+};
+
+inline SourceStats ComputeSourceStats(const cv::Mat &src)
+{
+    SourceStats stats;
+    cv::integral(src, stats.sum, stats.sqsum, CV_64F, CV_64F);
+    return stats;
+}
+
+inline bool MethodNeedsSourceStats(int method)
+{
+    return method != cv::TM_CCORR;
+}
+
+/**
+ * Turns a TM_CCORR response (`result`, CV_32F) into the response of `method`, in place.
+ * `srcStats` is only read for methods where MethodNeedsSourceStats() is true.
+ */
+inline void NormalizeCorrelation(cv::Mat &result, const SourceStats &srcStats, const TemplateStats &templStats, int method)
+{
+    if (!MethodNeedsSourceStats(method))
+        return;
+
+    const int cn = templStats.channels;
+    const int tw = templStats.size.width;
+    const int th = templStats.size.height;
+    const double area = static_cast<double>(tw) * th;
+    const bool isNormed = method == cv::TM_CCORR_NORMED || method == cv::TM_SQDIFF_NORMED || method == cv::TM_CCOEFF_NORMED;
+    const bool isCoeff = method == cv::TM_CCOEFF || method == cv::TM_CCOEFF_NORMED;
+    const bool isSqdiff = method == cv::TM_SQDIFF || method == cv::TM_SQDIFF_NORMED;
+    const double templNorm = isCoeff ? templStats.deviation : std::sqrt(templStats.sumSq);
+    if (method == cv::TM_CCOEFF_NORMED && templNorm < DBL_EPSILON)
+    {
+        // A flat template correlates equally well everywhere
+        result = cv::Scalar::all(1);
+        return;
+    }
+
+    for (int y = 0; y < result.rows; ++y)
+    {
+        const double *sumTop = srcStats.sum.ptr<double>(y);
+        const double *sumBottom = srcStats.sum.ptr<double>(y + th);
+        const double *sqTop = srcStats.sqsum.ptr<double>(y);
+        const double *sqBottom = srcStats.sqsum.ptr<double>(y + th);
+        float *row = result.ptr<float>(y);
+
+        for (int x = 0; x < result.cols; ++x)
+        {
+            double num = row[x];
+            double wndSum2 = 0;
+            double wndMean2 = 0;
+            for (int c = 0; c < cn; ++c)
+            {
+                const int left = x * cn + c;
+                const int right = (x + tw) * cn + c;
+                const double wndSum = sumBottom[right] - sumBottom[left] - sumTop[right] + sumTop[left];
+                wndSum2 += sqBottom[right] - sqBottom[left] - sqTop[right] + sqTop[left];
+                if (isCoeff)
+                {
+                    num -= wndSum * templStats.mean[c];
+                    wndMean2 += wndSum * wndSum / area;
+                }
+            }
+
+            if (isSqdiff)
+                num = std::max(wndSum2 - 2 * num + templStats.sumSq, 0.0);
+
+            if (isNormed)
+            {
+                const double diff2 = std::max(wndSum2 - wndMean2, 0.0);
+                // Flat windows would only divide rounding errors
+                const double t = diff2 <= std::min(0.5, 10 * FLT_EPSILON * wndSum2) ? 0 : std::sqrt(diff2) * templNorm;
+                if (std::fabs(num) < t)
+                    num /= t;
+                else if (std::fabs(num) < t * 1.125)
+                    num = num > 0 ? 1 : -1;
+                else
+                    num = isSqdiff ? 1 : 0;
+            }
+            row[x] = static_cast<float>(num);
+        }
+    }
+}
+
+/**
+ * Matches `templ` against `src` like cv::matchTemplate(src, templ, result, method), reusing statistics
+ * computed beforehand.
+ */
+inline void MatchWithStats(const cv::Mat &src, const SourceStats &srcStats, const cv::Mat &templ,
+                           const TemplateStats &templStats, int method, cv::Mat &result)
+{
+    cv::matchTemplate(src, templ, result, cv::TM_CCORR);
+    NormalizeCorrelation(result, srcStats, templStats, method);
+}
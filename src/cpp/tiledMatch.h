@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <peaks.h>
+#include <stopCondition.h>
+#include <workerPool.h>
+
+// Tiles are not made smaller than this many response pixels on a side, or the overlap they read twice dominates
+const int TILE_MIN_RESPONSE_SIZE = 64;
+// Tiles per pool thread when no count is asked for, so stealing can even out tiles that take longer
+const int TILES_PER_THREAD = 4;
+
+struct TileOptions
+{
+    // How many tiles to split the image into. 0 disables tiling, -1 picks a count from the pool size.
+    int tiles = 0;
+    // Stop starting new tiles once one tile found a match passing the threshold
+    bool anyMatch = false;
+};
+
+/**
+ * Splits the matchTemplate response of an image into a grid of about `count` tiles and returns the source rectangles
+ * they read. Neighbouring rectangles overlap by the template size minus one, so every template position is matched
+ * in exactly one tile and the tiles' responses together equal the full response.
+ */
+inline std::vector<cv::Rect> PlanTiles(cv::Size imageSize, cv::Size templSize, int count)
+{
+    const cv::Size response(imageSize.width - templSize.width + 1, imageSize.height - templSize.height + 1);
+    if (response.width <= 0 || response.height <= 0)
+        return {};
+
+    // Aim for square tiles: cols / rows follows the response's aspect ratio
+    count = std::max(count, 1);
+    int cols = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count) * response.width / response.height)));
+    cols = std::max(1, std::min(cols, response.width / TILE_MIN_RESPONSE_SIZE));
+    int rows = (count + cols - 1) / cols;
+    rows = std::max(1, std::min(rows, response.height / TILE_MIN_RESPONSE_SIZE));
+
+    std::vector<cv::Rect> tiles;
+    tiles.reserve(static_cast<size_t>(cols) * rows);
+    for (int row = 0; row < rows; ++row)
+    {
+        const int top = response.height * row / rows;
+        const int bottom = response.height * (row + 1) / rows;
+        for (int col = 0; col < cols; ++col)
+        {
+            const int left = response.width * col / cols;
+            const int right = response.width * (col + 1) / cols;
+            tiles.emplace_back(left, top, right - left + templSize.width - 1, bottom - top + templSize.height - 1);
+        }
+    }
+    return tiles;
+}
+
+inline int TileCount(const TileOptions &options, const WorkerPool &pool)
+{
+    return options.tiles > 0 ? options.tiles : static_cast<int>(pool.Size()) * TILES_PER_THREAD;
+}
+
+/**
+ * matchTemplate extremes computed tile by tile on `pool`. Same result as one cv::matchTemplate over `src`.
+ * `stop` is checked before each tile; once it fires, tiles not started are skipped and OperationStopped is rethrown.
+ */
+inline MatchExtremes TiledMatchExtremes(const cv::Mat &src, const cv::Mat &templ, int method, const cv::Mat &mask, const TileOptions &options, WorkerPool &pool,
+                                        const StopCondition *stop = nullptr)
+{
+    const std::vector<cv::Rect> tiles = PlanTiles(src.size(), templ.size(), TileCount(options, pool));
+    if (tiles.empty())
+        CV_Error(cv::Error::StsBadSize, "The template is larger than the image");
+
+    std::vector<MatchExtremes> results(tiles.size());
+    pool.ParallelFor(tiles.size(), [&](size_t i)
+                     {
+        if (stop)
+            stop->ThrowIfStopped();
+        cv::Mat response;
+        if (mask.empty())
+            cv::matchTemplate(src(tiles[i]), templ, response, method);
+        else
+            cv::matchTemplate(src(tiles[i]), templ, response, method, mask);
+        results[i] = FindExtremes(response); });
+
+    MatchExtremes best;
+    for (size_t i = 0; i < tiles.size(); ++i)
+        MergeExtremes(best, results[i], tiles[i].tl(), i == 0);
+    return best;
+}
+
+/**
+ * The local extrema passing `peakOptions` of the matchTemplate response of `src`, computed tile by tile on `pool`,
+ * in `src` coordinates and not yet suppressed. Each tile matches one extra response pixel around its part, so
+ * peaks on tile borders are compared against the same neighbours as in the full response. With `anyMatch`, tiles
+ * not started when a tile finds a match are skipped, so the result holds at least one match if there is any but
+ * not necessarily all of them. `stop` is checked before each tile, as in TiledMatchExtremes.
+ */
+inline std::vector<Peak> TiledCollectPeaks(const cv::Mat &src, const cv::Mat &templ, int method, const PeakOptions &peakOptions, const TileOptions &options, WorkerPool &pool,
+                                           const StopCondition *stop = nullptr)
+{
+    const std::vector<cv::Rect> tiles = PlanTiles(src.size(), templ.size(), TileCount(options, pool));
+    if (tiles.empty())
+        CV_Error(cv::Error::StsBadSize, "The template is larger than the image");
+
+    const cv::Rect responseArea(0, 0, src.cols - templ.cols + 1, src.rows - templ.rows + 1);
+    std::vector<std::vector<Peak>> perTile(tiles.size());
+    std::atomic<bool> found{false};
+    pool.ParallelFor(
+        tiles.size(), [&](size_t i)
+        {
+            if (stop)
+                stop->ThrowIfStopped();
+            // The tile's part of the response, grown by the neighbours its border pixels are compared with
+            const cv::Rect part(tiles[i].x, tiles[i].y, tiles[i].width - templ.cols + 1, tiles[i].height - templ.rows + 1);
+            const cv::Rect halo = cv::Rect(part.x - 1, part.y - 1, part.width + 2, part.height + 2) & responseArea;
+            cv::Mat response;
+            cv::matchTemplate(src(cv::Rect(halo.x, halo.y, halo.width + templ.cols - 1, halo.height + templ.rows - 1)), templ, response, method);
+            CollectPeaksIn(response, part - halo.tl(), templ.size(), peakOptions, perTile[i]);
+            for (Peak &peak : perTile[i])
+            {
+                peak.x += halo.x;
+                peak.y += halo.y;
+            }
+            if (options.anyMatch && !perTile[i].empty())
+                found = true; },
+        options.anyMatch ? &found : nullptr);
+
+    std::vector<Peak> candidates;
+    for (const std::vector<Peak> &peaks : perTile)
+        candidates.insert(candidates.end(), peaks.begin(), peaks.end());
+    return candidates;
+}
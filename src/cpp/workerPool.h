@@ -0,0 +1,342 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of threads with one task queue each. A worker runs its own queue newest first and, once it runs dry,
+ * steals the oldest task of another worker, so uneven tasks even out without one central queue that every thread
+ * contends on. Tasks submitted from outside the pool are dealt to the queues round-robin.
+ */
+class WorkerPool
+{
+public:
+    explicit WorkerPool(size_t threads) : m_queues(std::max<size_t>(threads, 1))
+    {
+        for (size_t i = 0; i < m_queues.size(); ++i)
+            m_queues[i] = std::make_unique<TaskQueue>();
+        for (size_t i = 0; i < m_queues.size(); ++i)
+            m_threads.emplace_back([this, i]
+                                   { WorkerLoop(i); });
+    }
+
+    ~WorkerPool()
+    {
+        Shutdown();
+    }
+
+    /**
+     * Lets the workers finish every queued task, then stops them. Tasks submitted afterwards run on the
+     * submitting thread.
+     */
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (std::thread &thread : m_threads)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    size_t Size() const
+    {
+        return m_queues.size();
+    }
+
+    void Submit(std::function<void()> task)
+    {
+        if (!TrySubmit(task))
+            task();
+    }
+
+    /**
+     * Runs body(0) .. body(count - 1) on the pool and returns when all have finished. Indexes not yet started
+     * are skipped once `*cancel` becomes true. A pool worker calling this runs queued tasks while it waits, so
+     * nesting cannot starve the pool; any other thread sleeps until the batch is done. The first exception thrown
+     * by `body` is rethrown here.
+     */
+    void ParallelFor(size_t count, const std::function<void(size_t)> &body, const std::atomic<bool> *cancel = nullptr)
+    {
+        if (count == 0)
+            return;
+
+        std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+        batch->remaining = count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::function<void()> task = [this, batch, &body, cancel, i]
+            {
+                if (!batch->failed && !(cancel && cancel->load()))
+                {
+                    try
+                    {
+                        body(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(batch->mutex);
+                        if (!batch->error)
+                            batch->error = std::current_exception();
+                        batch->failed = true;
+                    }
+                }
+                if (--batch->remaining == 0)
+                    FinishBatch(*batch);
+            };
+            if (!TrySubmit(task))
+                task();
+        }
+
+        const WorkerSlot &slot = CurrentSlot();
+        if (slot.pool == this)
+        {
+            // A worker helps with whatever is queued, and otherwise sleeps with the idle workers until a task is
+            // submitted or the batch is done
+            ++m_helpers;
+            while (batch->remaining.load() > 0)
+            {
+                if (TryRunOne(slot.index))
+                    continue;
+                std::unique_lock<std::mutex> lock(m_sleepMutex);
+                m_wake.wait(lock, [this, &batch]
+                            { return batch->remaining.load() == 0 || m_queued.load() > 0; });
+            }
+            --m_helpers;
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(batch->mutex);
+            batch->done.wait(lock, [&batch]
+                             { return batch->remaining.load() == 0; });
+        }
+
+        if (batch->error)
+            std::rethrow_exception(batch->error);
+    }
+
+private:
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    struct Batch
+    {
+        std::atomic<size_t> remaining{0};
+        std::atomic<bool> failed{false};
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+
+    struct WorkerSlot
+    {
+        const WorkerPool *pool = nullptr;
+        size_t index = 0;
+    };
+
+    static WorkerSlot &CurrentSlot()
+    {
+        thread_local WorkerSlot slot;
+        return slot;
+    }
+
+    /**
+     * Queues `task`, on the caller's own queue when it is a worker of this pool. Returns false, leaving `task`
+     * untouched, once the pool is shutting down.
+     */
+    bool TrySubmit(std::function<void()> &task)
+    {
+        const WorkerSlot &slot = CurrentSlot();
+        const size_t index = slot.pool == this ? slot.index : m_next++ % m_queues.size();
+        {
+            // Counted before it is queued, so the count never drops below zero, and under the sleep mutex, so a
+            // worker about to sleep cannot miss the task and no worker exits while it is queued
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            if (m_stopping)
+                return false;
+            ++m_queued;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+            m_queues[index]->tasks.push_back(std::move(task));
+        }
+        m_wake.notify_one();
+        return true;
+    }
+
+    /**
+     * Wakes whoever waits for `batch`: a non-worker on the batch's condition variable, a worker among the idle ones.
+     */
+    void FinishBatch(Batch &batch)
+    {
+        {
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            batch.done.notify_all();
+        }
+        // Pairs with the increment in ParallelFor: either the helper sees the batch done or this sees the helper
+        if (m_helpers.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_wake.notify_all();
+        }
+    }
+
+    /**
+     * Runs one queued task, taking the newest of queue `home` or else the oldest of the next non-empty queue.
+     * Returns false when every queue is empty.
+     */
+    bool TryRunOne(size_t home)
+    {
+        for (size_t k = 0; k < m_queues.size(); ++k)
+        {
+            const size_t index = (home + k) % m_queues.size();
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+                std::deque<std::function<void()>> &tasks = m_queues[index]->tasks;
+                if (tasks.empty())
+                    continue;
+                if (k == 0)
+                {
+                    task = std::move(tasks.back());
+                    tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+            }
+            --m_queued;
+            task();
+            return true;
+        }
+        return false;
+    }
+
+    void WorkerLoop(size_t index)
+    {
+        WorkerSlot &slot = CurrentSlot();
+        slot.pool = this;
+        slot.index = index;
+
+        while (true)
+        {
+            if (TryRunOne(index))
+                continue;
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [this]
+                        { return m_stopping || m_queued.load() > 0; });
+            if (m_stopping && m_queued.load() == 0)
+                return;
+        }
+    }
+
+    std::vector<std::unique_ptr<TaskQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_next{0};
+    std::atomic<size_t> m_queued{0};
+    // Workers waiting inside ParallelFor
+    std::atomic<size_t> m_helpers{0};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+};
+
+/**
+ * A process-wide pool that can be replaced while in use. Users keep the pointer Get() returns for as long as they
+ * use the pool. A replaced pool finishes its queued tasks and stops its threads on a thread of its own, so resizing
+ * never blocks the caller, and it is freed when its last user lets go.
+ */
+class SharedPoolSlot
+{
+public:
+    std::shared_ptr<WorkerPool> Get()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_pool)
+            m_pool = std::make_shared<WorkerPool>(std::max(1u, std::thread::hardware_concurrency()));
+        return m_pool;
+    }
+
+    void Replace(size_t threads)
+    {
+        std::shared_ptr<WorkerPool> old;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            old = std::move(m_pool);
+            m_pool = std::make_shared<WorkerPool>(threads);
+        }
+        if (old)
+            std::thread([old]
+                        { old->Shutdown(); })
+                .detach();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::shared_ptr<WorkerPool> m_pool;
+};
+
+/**
+ * The slots are never destroyed, and neither is the pool in use at exit: joining threads while the module is
+ * unloaded at process exit can deadlock on Windows.
+ */
+inline SharedPoolSlot &MatchingPoolSlot()
+{
+    static SharedPoolSlot *slot = new SharedPoolSlot();
+    return *slot;
+}
+
+inline SharedPoolSlot &AsyncPoolSlot()
+{
+    static SharedPoolSlot *slot = new SharedPoolSlot();
+    return *slot;
+}
+
+/**
+ * The pool parallel matching splits its tiles over, one thread per hardware thread unless resized.
+ */
+inline std::shared_ptr<WorkerPool> SharedWorkerPool()
+{
+    return MatchingPoolSlot().Get();
+}
+
+/**
+ * The pool the async bindings run their calls on. It is separate from the matching pool, so a call waiting for its
+ * tiles holds none of the threads that run them; only matching pool workers run tiles.
+ */
+inline std::shared_ptr<WorkerPool> AsyncWorkerPool()
+{
+    return AsyncPoolSlot().Get();
+}
+
+/**
+ * Replaces the matching and async pools with pools of `threads` threads each. Returns at once; the old pools finish
+ * their queued tasks in the background.
+ */
+inline void ResizeSharedWorkerPools(size_t threads)
+{
+    MatchingPoolSlot().Replace(threads);
+    AsyncPoolSlot().Replace(threads);
+}
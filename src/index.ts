@@ -23,6 +23,14 @@ export type ImageData = {
   width: number;
   height: number;
   data: Uint8Array;
+  /**
+   * Number of bytes per pixel (1 for gray, 3 for BGR, 4 for BGRA). Set on captured frames.
+   */
+  channels?: number;
+  /**
+   * Number of bytes between the starts of two rows. Set on captured frames.
+   */
+  stride?: number;
 };
 
 /**
@@ -37,7 +45,236 @@ export type MatchData = {
 
 export type GetWindowData = (windowName: string) => WindowData;
 
-export type CaptureWindow = (windowName: string) => Buffer;
+/**
+ * Raw pixel layouts a frame can be returned in. "gray_half" is gray at half the width and height.
+ */
+export type RawCaptureFormat = "bgra" | "bgr" | "gray" | "gray_half";
+
+/**
+ * Pixel layout of a captured frame. Raw formats return pixels, "png" returns an encoded buffer.
+ */
+export type CaptureFormat = RawCaptureFormat | "png";
+
+/**
+ * Options for capturing a frame.
+ */
+export type CaptureOptions<F extends CaptureFormat = CaptureFormat> = {
+  format?: F;
+  /**
+   * How long to wait for a frame, in milliseconds. Defaults to 20000.
+   * When it runs out, the call throws (or rejects with) an error whose `code` is `ErrorCodes.CaptureTimeout`.
+   */
+  timeout?: number;
+  /**
+   * Only capture this part of the window, as [x, y, width, height] in window pixels.
+   * Only these pixels are copied out of the GPU.
+   */
+  region?: ROI;
+};
+
+/**
+ * Options for capturing several parts of one frame. Each region comes back as its own image, in the same order.
+ */
+export type CaptureRegionsOptions<F extends CaptureFormat = CaptureFormat> = Omit<
+  CaptureOptions<F>,
+  "region"
+> & {
+  regions: ROI[];
+};
+
+/**
+ * Values of the `code` property on errors thrown by the native addon.
+ */
+export const ErrorCodes = {
+  CaptureTimeout: "ERR_CAPTURE_TIMEOUT",
+  Cancelled: "ERR_CANCELLED",
+  DeadlineExceeded: "ERR_DEADLINE_EXCEEDED",
+} as const;
+
+/**
+ * Checks whether an error was thrown because no frame arrived before the capture timeout.
+ */
+export function isCaptureTimeoutError(error: unknown): error is Error & { code: typeof ErrorCodes.CaptureTimeout } {
+  return error instanceof Error && (error as Error & { code?: string }).code === ErrorCodes.CaptureTimeout;
+}
+
+/**
+ * Checks whether an operation gave up because its signal aborted or its timeout passed.
+ */
+export function isStoppedError(
+  error: unknown
+): error is Error & { code: typeof ErrorCodes.Cancelled | typeof ErrorCodes.DeadlineExceeded } {
+  const code = error instanceof Error ? (error as Error & { code?: string }).code : undefined;
+  return code === ErrorCodes.Cancelled || code === ErrorCodes.DeadlineExceeded;
+}
+
+/**
+ * Lets a long-running operation give up early. It is checked between units of work (tiles, drag steps, typed
+ * characters), and the call throws or rejects with an error whose `code` is `ErrorCodes.Cancelled` or
+ * `ErrorCodes.DeadlineExceeded`. A synchronous call blocks the event loop, so its signal can only stop it
+ * if already aborted; use the async variants to abort while running.
+ */
+export type StopOptions = {
+  signal?: AbortSignal;
+  /**
+   * Milliseconds from the call after which the operation gives up.
+   */
+  timeout?: number;
+};
+
+/**
+ * Captures a window once. Returns a PNG buffer unless a raw format is requested.
+ */
+export type CaptureWindow = {
+  (
+    windowName: string,
+    options: CaptureRegionsOptions<RawCaptureFormat> & { format: RawCaptureFormat }
+  ): ImageData[];
+  (windowName: string, options: CaptureRegionsOptions<"png">): Buffer[];
+  (windowName: string, options?: CaptureOptions<"png">): Buffer;
+  (windowName: string, options: CaptureOptions<RawCaptureFormat>): ImageData;
+};
+
+/**
+ * Captures a window once on a worker thread. Resolves with a PNG buffer unless a raw format is requested.
+ */
+export type CaptureWindowAsync = {
+  (
+    windowName: string,
+    options: CaptureRegionsOptions<RawCaptureFormat> & { format: RawCaptureFormat }
+  ): Promise<ImageData[]>;
+  (
+    windowName: string,
+    options: CaptureRegionsOptions<"png">
+  ): Promise<Buffer[]>;
+  (windowName: string, options?: CaptureOptions<"png">): Promise<Buffer>;
+  (
+    windowName: string,
+    options: CaptureOptions<RawCaptureFormat>
+  ): Promise<ImageData>;
+};
+
+/**
+ * A capture that stays open between frames, so the capture device and frame pool are set up only once.
+ */
+export interface CaptureSession {
+  /**
+   * Grabs the most recent frame of the window. Frames are returned as raw BGRA pixels unless another format is requested.
+   * @param options - The output format and timeout (optional).
+   * @returns The frame (one image per region when `regions` is given). Throws if PNG encoding fails, or if a
+   * `grabAsync` on the same session is still waiting for its frame.
+   */
+  grab(
+    options: CaptureRegionsOptions<"png"> & { format: "png" }
+  ): Buffer[];
+  grab(options: CaptureRegionsOptions<RawCaptureFormat>): ImageData[];
+  grab(options?: CaptureOptions<RawCaptureFormat>): ImageData;
+  grab(options: CaptureOptions<"png">): Buffer;
+
+  /**
+   * Like `grab`, but waits for and converts the frame on a worker thread instead of blocking the event loop.
+   * @param options - The output format and timeout (optional).
+   * @returns A promise for the frame (one image per region when `regions` is given). Rejects if PNG encoding fails.
+   */
+  grabAsync(
+    options: CaptureRegionsOptions<"png"> & { format: "png" }
+  ): Promise<Buffer[]>;
+  grabAsync(options: CaptureRegionsOptions<RawCaptureFormat>): Promise<ImageData[]>;
+  grabAsync(options?: CaptureOptions<RawCaptureFormat>): Promise<ImageData>;
+  grabAsync(options: CaptureOptions<"png">): Promise<Buffer>;
+
+  /**
+   * Queues the next frame of a session created from image data. It must have the session's size and channels.
+   * A grab that is waiting for a frame resolves with it.
+   */
+  push(image: ImageData): void;
+
+  /**
+   * Stops the capture and releases the native resources. The session cannot be used afterwards.
+   */
+  close(): void;
+
+  /**
+   * Whether the session has been closed.
+   */
+  readonly closed: boolean;
+}
+
+/**
+ * Opens a capture session for a window name, or for an image that is replayed as the captured frame.
+ * Without `data`, an in-memory session starts with no frame and grabs wait for `push()`.
+ */
+export type CaptureSessionConstructor = new (
+  source: string | ImageData | { width: number; height: number; channels?: number }
+) => CaptureSession;
+
+/**
+ * Options for a continuous capture stream.
+ */
+export type CaptureStreamOptions = {
+  /**
+   * Raw pixel layout of the frames. Defaults to "bgra".
+   */
+  format?: RawCaptureFormat;
+  /**
+   * Upper limit on stored frames per second. Frames arriving faster are skipped. 0 (the default) means no limit.
+   */
+  fps?: number;
+  /**
+   * How many unread frames are kept. When the reader falls behind, the oldest unread frame is dropped. Defaults to 2.
+   */
+  maxQueued?: number;
+  /**
+   * Only capture this part of the window, as [x, y, width, height].
+   */
+  region?: ROI;
+};
+
+/**
+ * Frame counters of a capture stream.
+ */
+export type CaptureStreamStats = {
+  /** Frames handed to JS. */
+  delivered: number;
+  /** Frames dropped because they were not read before newer ones replaced them. */
+  dropped: number;
+  /** Frames not stored because of the fps limit. */
+  skipped: number;
+  /** Frames currently waiting to be read. */
+  queued: number;
+};
+
+/**
+ * A capture that keeps copying frames into a fixed ring of preallocated buffers on a native thread.
+ */
+export interface CaptureStream {
+  /**
+   * Takes the newest unread frame. Older unread frames are dropped.
+   * @returns The frame, or null if no new frame arrived since the last read.
+   */
+  read(): ImageData | null;
+
+  /**
+   * Returns the frame counters of the stream.
+   */
+  stats(): CaptureStreamStats;
+
+  /**
+   * Stops capturing and releases the native resources. Must be called when a frame callback was given.
+   */
+  stop(): void;
+
+  /**
+   * Whether the stream is still capturing.
+   */
+  readonly running: boolean;
+}
+
+export type CaptureStreamConstructor = new (
+  source: string | ImageData,
+  options?: CaptureStreamOptions,
+  onFrame?: (frame: ImageData) => void
+) => CaptureStream;
 
 /**
  * The handler to listen to key-down events.
@@ -51,6 +288,26 @@ export type KeyDownHandler = (callback: (keyCode: number) => void) => void;
  */
 export type KeyUpHandler = (callback: (keyCode: number) => void) => void;
 
+/**
+ * When keyBatchHandler delivers a batch: `interval` ms after its first event (default 0, i.e. as soon as the
+ * JS thread gets to it) or once it holds `maxEvents` events (default 256, at most 1024).
+ */
+export type KeyBatchOptions = {
+  interval?: number;
+  maxEvents?: number;
+};
+
+/**
+ * Key events packed 4 values per event: keyCode, scanCode, flags and time (ms, from the system), oldest first.
+ * `flags & 0x80` (LLKHF_UP) is set for a release.
+ */
+export type KeyBatchHandler = (callback: (events: Uint32Array) => void, options?: KeyBatchOptions) => void;
+
+/**
+ * Key events dropped so far because the JS thread fell too far behind the keyboard hook.
+ */
+export type GetDroppedKeyEvents = () => number;
+
 /**
  * Function type for moving the mouse.
  */
@@ -64,7 +321,9 @@ export type MouseClick = (button?: "left" | "middle" | "right") => boolean;
 /**
  * Function type for simulating typing.
  */
-export type TypeString = (stringToType: string, delay?: number) => boolean;
+export type TypeString = (stringToType: string, delay?: number, options?: StopOptions) => boolean;
+
+export type TypeStringAsync = (stringToType: string, delay?: number, options?: StopOptions) => Promise<boolean>;
 
 /**
  * Function type for simulating key press and release.
@@ -79,9 +338,22 @@ export type MouseDrag = (
   startY: number,
   endX: Number,
   endY: number,
-  speed?: number
+  speed?: number,
+  options?: StopOptions
 ) => boolean;
 
+/**
+ * mouseDrag on a worker thread. A stopped drag releases the button where the cursor is.
+ */
+export type MouseDragAsync = (
+  starX: number,
+  startY: number,
+  endX: number,
+  endY: number,
+  speed?: number,
+  options?: StopOptions
+) => Promise<boolean>;
+
 /**
  * Represents a point in a two-dimensional space.
  */
@@ -94,17 +366,418 @@ export type Color = [r: number, g: number, b: number];
  */
 export type ROI = [x: number, y: number, width: number, height: number];
 
+/**
+ * Native image handle. Operations run on pixels kept in native memory and return new handles,
+ * so a chain of them never copies pixels into JS. Images are never modified in place.
+ */
+export interface Image {
+  readonly width: number;
+  readonly height: number;
+  readonly channels: number;
+  /**
+   * Matches a template image within this image. The template and mask can be Images or ImageData.
+   */
+  matchTemplate(
+    template: Image | ImageData,
+    method?: number | null,
+    mask?: Image | ImageData | null,
+    options?: MatchOptions & StopOptions
+  ): MatchData;
+  blur(sizeX: number, sizeY: number): Image;
+  /**
+   * Converts BGR or BGRA to grayscale. A grayscale image returns itself.
+   */
+  bgrToGray(): Image;
+  drawRectangle(start: Point, end: Point, rgb: Color, thickness: number): Image;
+  /**
+   * Returns a handle to a part of this image. It shares the pixels of this image instead of copying them.
+   */
+  getRegion(region: ROI): Image;
+  /**
+   * Encodes the image as PNG.
+   */
+  toPng(): Buffer;
+  /**
+   * Returns a copy of the pixels as ImageData. Writing to it does not change this image.
+   */
+  toImageData(): ImageData;
+}
+
+export interface ImageConstructor {
+  /**
+   * Loads an image file, or copies an ImageData into native memory.
+   */
+  new (image: string | ImageData, flags?: number): Image;
+}
+
+/**
+ * One hit of a TemplateBank search: where the template matched, at which scale and with what score.
+ */
+export type BankMatch = {
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+  score: number;
+  scale: number;
+};
+
+/**
+ * Every hit of a TemplateBank search, best first. Hit `i` covers (x[i], y[i], width[i], height[i]).
+ */
+export type BankMatchAllData = MatchAllData & {
+  width: Int32Array;
+  height: Int32Array;
+  scale: Float32Array;
+};
+
+/**
+ * A template prepared once at several scales (e.g. for 100%, 125% and 150% DPI) and searched at all of them
+ * in one call. Scores are only comparable across scales with the normalized methods.
+ */
+export interface TemplateBank {
+  readonly scales: number[];
+  /**
+   * Returns the best hit over all scales, or null when no scale fits inside the image.
+   */
+  match(image: ImageData | Image, options?: StopOptions): BankMatch | null;
+  /**
+   * Returns every hit over all scales. Hits of different scales on the same spot are merged.
+   */
+  matchAll(
+    image: ImageData | Image,
+    options?: Omit<MatchAllOptions, "method"> & StopOptions
+  ): BankMatchAllData;
+}
+
+export interface TemplateBankConstructor {
+  new (
+    template: ImageData | Image,
+    options?: { scales?: number[]; method?: number }
+  ): TemplateBank;
+}
+
+/**
+ * Options for compiling a Template.
+ */
+export type TemplateOptions = {
+  /**
+   * Template matching method used by every match. Defaults to TM_CCOEFF_NORMED (5).
+   */
+  method?: number;
+  /**
+   * Convert the template, and every image it is matched against, to grayscale. Defaults to false.
+   */
+  gray?: boolean;
+  mask?: ImageData | Image;
+  /**
+   * Keep the template's DFT between matches, for large single-channel templates. Can be faster on streams of
+   * same-sized frames; measure with bench/templateCompile.js. Defaults to false.
+   */
+  dft?: boolean;
+};
+
+/**
+ * A template compiled once for repeated matching. Its statistics, mask and DFT are precomputed,
+ * so matching a new frame skips all template-side work.
+ */
+export interface Template {
+  readonly width: number;
+  readonly height: number;
+  readonly channels: number;
+  /**
+   * Same result as matchTemplate with the compiled method and mask.
+   */
+  match(image: ImageData | Image, options?: StopOptions): MatchData;
+  /**
+   * Same result as matchTemplateAll with the compiled method.
+   */
+  matchAll(
+    image: ImageData | Image,
+    options?: Omit<MatchAllOptions, "method"> & StopOptions
+  ): MatchAllData;
+}
+
+export interface TemplateConstructor {
+  new (template: ImageData | Image, options?: TemplateOptions): Template;
+}
+
+export type IncrementalMatcherOptions = {
+  /**
+   * Template matching method (cv::TemplateMatchModes). Defaults to TM_CCOEFF_NORMED (5).
+   */
+  method?: number;
+  /**
+   * Side of the square tiles consecutive frames are compared in. Defaults to 64.
+   */
+  tileSize?: number;
+};
+
+/**
+ * How much work an IncrementalMatcher has been saving.
+ */
+export type IncrementalMatcherStats = {
+  /** Frames matched so far. */
+  frames: number;
+  /** Frames matched from scratch: the first one and any after a change of size or channel count. */
+  fullFrames: number;
+  /** Tiles in the last frame. */
+  tiles: number;
+  /** Tiles of the last frame that differed from the frame before. */
+  changedTiles: number;
+  /** Share of the response recomputed for the last frame, 0 to 1. */
+  recomputed: number;
+  /** Average share of the response recomputed per frame, 0 to 1. */
+  averageRecomputed: number;
+};
+
+/**
+ * A template matched against consecutive frames of one window. Each frame is compared with the previous one
+ * in tiles, and only the template positions overlapping a changed tile are matched again. Results are the same
+ * as matching every frame in full.
+ */
+export interface IncrementalMatcher {
+  /**
+   * Same result as matchTemplate(frame, template, method).
+   */
+  match(frame: ImageData | Image, options?: StopOptions): MatchData;
+  /**
+   * Same result as matchTemplateAll(frame, template, options).
+   */
+  matchAll(
+    frame: ImageData | Image,
+    options?: Omit<MatchAllOptions, "method"> & StopOptions
+  ): MatchAllData;
+  stats(): IncrementalMatcherStats;
+  /**
+   * Forgets the previous frame, so the next one is matched in full.
+   */
+  reset(): void;
+}
+
+export interface IncrementalMatcherConstructor {
+  new (
+    template: ImageData | Image,
+    options?: IncrementalMatcherOptions
+  ): IncrementalMatcher;
+}
+
+/**
+ * One step of a Pipeline. `match` and `matchAll` can only be the last step.
+ */
+export type PipelineStep =
+  | { op: "crop"; region: ROI }
+  | { op: "gray" }
+  | { op: "blur"; size: [x: number, y: number] }
+  | { op: "threshold"; level?: number; maxValue?: number; inverse?: boolean }
+  | ({
+      op: "match";
+      template: ImageData | Image;
+      method?: number;
+      mask?: ImageData | Image;
+    } & MatchOptions)
+  | ({ op: "matchAll"; template: ImageData | Image } & MatchAllOptions &
+      Pick<MatchTemplateAllOptions, "tiles" | "anyMatch">);
+
+/**
+ * Time a step took on the last run, in milliseconds.
+ */
+export type PipelineTiming = {
+  op: PipelineStep["op"];
+  ms: number;
+};
+
+/**
+ * A chain of image operations compiled once and run natively on each frame. Intermediate images stay in
+ * native buffers reused between runs; only the final result is returned.
+ */
+export interface Pipeline {
+  /**
+   * Runs every step on the frame. Returns the match result of a final `match` or `matchAll` step, with
+   * locations in frame coordinates, or the final image. Stop options are checked before each step.
+   */
+  run(frame: ImageData | Image, options?: StopOptions): MatchData | MatchAllData | Image;
+  /**
+   * Per-step timings of the last run.
+   */
+  readonly timings: PipelineTiming[];
+}
+
+export interface PipelineConstructor {
+  new (steps: PipelineStep[]): Pipeline;
+}
+
 export type Imread = (path: string) => ImageData;
 
-export type Imwrite = (image: ImageData) => Buffer;
+export type Imwrite = (image: ImageData | Image) => Buffer;
+
+/**
+ * Parts of the image a match is restricted to. Each region is searched as a view into the image, without
+ * copying it, and locations are reported in full-image coordinates. Regions are clipped to the image;
+ * at least one must be large enough to hold the template.
+ */
+export type SearchRegionOptions = {
+  region?: ROI;
+  regions?: ROI[];
+};
+
+/**
+ * Splits the image into overlapping tiles matched in parallel on a native pool with one thread per core.
+ * `true` picks the tile count from the number of cores; a number asks for about that many tiles.
+ * The result is the same as without tiles.
+ */
+export type TiledMatchOptions = {
+  tiles?: boolean | number;
+};
+
+/**
+ * How a single template match searches the image.
+ */
+export type MatchOptions = SearchRegionOptions & TiledMatchOptions & {
+  /**
+   * Coarse-to-fine search: match on an image shrunk by 2^levels first, then only refine the best
+   * `candidates` spots at full resolution. Much faster on large images, but can miss a match the coarse
+   * search does not rank among the candidates. Ignored when a mask is given.
+   */
+  pyramid?: { levels?: number; candidates?: number };
+};
 
 export type MatchTemplate = (
   image: ImageData,
   template: ImageData,
   method?: number | null,
-  mask?: ImageData
+  mask?: ImageData | null,
+  options?: MatchOptions & StopOptions
 ) => MatchData;
 
+/**
+ * Options for finding every match of a template.
+ */
+export type MatchAllOptions = {
+  /**
+   * Template matching method (cv::TemplateMatchModes). Defaults to TM_CCOEFF_NORMED (5).
+   */
+  method?: number;
+  /**
+   * Minimum score of a match, or the maximum score for the TM_SQDIFF methods. Defaults to 0.8.
+   */
+  threshold?: number;
+  /**
+   * Defaults to 100.
+   */
+  maxResults?: number;
+  /**
+   * Matches overlapping an already found match by more than this (intersection over union) are dropped. Defaults to 0.3.
+   */
+  nmsOverlap?: number;
+};
+
+/**
+ * Every match found by matchTemplateAll, best first. Match `i` is at (x[i], y[i]) with score score[i].
+ */
+export type MatchAllData = {
+  count: number;
+  x: Int32Array;
+  y: Int32Array;
+  score: Float32Array;
+};
+
+/**
+ * Options of matchTemplateAll: those of every-match search plus search regions and tiling.
+ */
+export type MatchTemplateAllOptions = MatchAllOptions &
+  SearchRegionOptions &
+  TiledMatchOptions & {
+    /**
+     * Stop as soon as any tile finds a match passing the threshold, skipping the tiles not started yet.
+     * The result then holds at least one match if there is any, but not necessarily all of them. Implies `tiles`.
+     */
+    anyMatch?: boolean;
+  };
+
+export type MatchTemplateAll = (
+  image: ImageData | Image,
+  template: ImageData | Image,
+  options?: MatchTemplateAllOptions & StopOptions
+) => MatchAllData;
+
+/**
+ * Best and worst match of every template passed to matchTemplates, one row per template in the same order.
+ * Template `i` matched best at (maxX[i], maxY[i]) with maxValue[i] (minX/minY/minValue for the TM_SQDIFF methods).
+ */
+export type MatchTableData = {
+  count: number;
+  minValue: Float64Array;
+  maxValue: Float64Array;
+  minX: Int32Array;
+  minY: Int32Array;
+  maxX: Int32Array;
+  maxY: Int32Array;
+};
+
+export type MatchTemplates = (
+  image: ImageData | Image,
+  templates: (ImageData | Image)[],
+  options?: { method?: number } & StopOptions
+) => MatchTableData;
+
+/**
+ * Options of matchBinary. Scores are the fraction of template pixels that agree with the image, 0 to 1.
+ */
+export type MatchBinaryOptions = Omit<MatchAllOptions, "method"> & {
+  /**
+   * Pixels above this gray level count as set, the others as clear. Defaults to 127.
+   */
+  level?: number;
+};
+
+/**
+ * One pixel of a PixelSignature: its position and expected color, within `tolerance` on each channel.
+ */
+export type SignaturePoint = {
+  x: number;
+  y: number;
+  color: Color;
+  tolerance?: number;
+};
+
+/**
+ * A few pixels with expected colors that identify a screen state. Checking one reads only those pixels,
+ * straight from a gray, BGR or BGRA frame.
+ */
+export interface PixelSignature {
+  /**
+   * Number of points.
+   */
+  readonly size: number;
+  /**
+   * Whether every point matches the frame. Points outside the frame never match.
+   */
+  test(frame: ImageData | Image): boolean;
+}
+
+export interface PixelSignatureConstructor {
+  /**
+   * @param points - The pixels to check.
+   * @param options - `tolerance`: default per-channel tolerance of the points (10).
+   */
+  new (points: SignaturePoint[], options?: { tolerance?: number }): PixelSignature;
+}
+
+/**
+ * Checks many signatures against one frame. Element `i` of the result is 1 if signatures[i] matches, 0 otherwise.
+ */
+export type MatchSignatures = (
+  frame: ImageData | Image,
+  signatures: PixelSignature[]
+) => Uint8Array;
+
+export type MatchBinary = (
+  image: ImageData | Image,
+  template: ImageData | Image,
+  options?: MatchBinaryOptions & StopOptions
+) => MatchAllData;
+
 export type Blur = (
   image: ImageData,
   sizeX: number,
@@ -121,40 +794,127 @@ export type DrawRectangle = (
 ) => ImageData;
 export type GetRegion = (image: ImageData, region: ROI) => ImageData;
 
+/**
+ * Promise-based versions of the OpenCV bindings. The work runs on the native worker pool instead of the
+ * JS thread; the images passed in are kept alive until the Promise settles and must not be modified before then.
+ */
+export type ImreadAsync = (path: string) => Promise<ImageData>;
+export type ImwriteAsync = (image: ImageData | Image) => Promise<Buffer>;
+export type MatchTemplateAsync = (
+  image: ImageData | Image,
+  template: ImageData | Image,
+  method?: number | null,
+  mask?: ImageData | Image | null,
+  options?: MatchOptions & StopOptions
+) => Promise<MatchData>;
+export type BlurAsync = (
+  image: ImageData | Image,
+  sizeX: number,
+  sizeY: number
+) => Promise<ImageData>;
+export type BgrToGrayAsync = (image: ImageData | Image) => Promise<ImageData>;
+export type DrawRectangleAsync = (
+  image: ImageData | Image,
+  start: Point,
+  end: Point,
+  rgb: Color,
+  thickness: number
+) => Promise<ImageData>;
+export type GetRegionAsync = (image: ImageData | Image, region: ROI) => Promise<ImageData>;
+
+/**
+ * Resizes the native worker pools the async bindings and tiled matching run on, one each. Defaults to one thread
+ * per core. Returns at once; work already started finishes on the old threads.
+ */
+export type SetWorkerThreads = (count: number) => void;
+export type GetWorkerThreads = () => number;
+
 const {
   keyDownHandler,
   keyUpHandler,
+  keyBatchHandler,
+  getDroppedKeyEvents,
   getWindowData,
   captureWindowN,
+  captureWindowAsync,
   mouseMove,
   mouseClick,
   mouseDrag,
+  mouseDragAsync,
   typeString,
+  typeStringAsync,
   pressKey,
   imread,
   imwrite,
   matchTemplate,
+  matchTemplateAll,
+  matchTemplates,
+  matchBinary,
+  matchSignatures,
   blur,
   bgrToGray,
   drawRectangle,
   getRegion,
+  imreadAsync,
+  imwriteAsync,
+  matchTemplateAsync,
+  blurAsync,
+  bgrToGrayAsync,
+  drawRectangleAsync,
+  getRegionAsync,
+  setWorkerThreads,
+  getWorkerThreads,
+  CaptureSession,
+  CaptureStream,
+  Image,
+  TemplateBank,
+  Template,
+  PixelSignature,
+  IncrementalMatcher,
+  Pipeline,
 }: {
   keyDownHandler: KeyDownHandler;
   keyUpHandler: KeyUpHandler;
+  keyBatchHandler: KeyBatchHandler;
+  getDroppedKeyEvents: GetDroppedKeyEvents;
   getWindowData: GetWindowData;
   captureWindowN: CaptureWindow;
+  captureWindowAsync: CaptureWindowAsync;
   mouseMove: MouseMove;
   mouseClick: MouseClick;
   mouseDrag: MouseDrag;
+  mouseDragAsync: MouseDragAsync;
   typeString: TypeString;
+  typeStringAsync: TypeStringAsync;
   pressKey: PressKey;
   imread: Imread;
   imwrite: Imwrite;
   matchTemplate: MatchTemplate;
+  matchTemplateAll: MatchTemplateAll;
+  matchTemplates: MatchTemplates;
+  matchBinary: MatchBinary;
+  matchSignatures: MatchSignatures;
   blur: Blur;
   bgrToGray: BgrToGray;
   drawRectangle: DrawRectangle;
   getRegion: GetRegion;
+  imreadAsync: ImreadAsync;
+  imwriteAsync: ImwriteAsync;
+  matchTemplateAsync: MatchTemplateAsync;
+  blurAsync: BlurAsync;
+  bgrToGrayAsync: BgrToGrayAsync;
+  drawRectangleAsync: DrawRectangleAsync;
+  getRegionAsync: GetRegionAsync;
+  setWorkerThreads: SetWorkerThreads;
+  getWorkerThreads: GetWorkerThreads;
+  CaptureSession: CaptureSessionConstructor;
+  CaptureStream: CaptureStreamConstructor;
+  Image: ImageConstructor;
+  TemplateBank: TemplateBankConstructor;
+  Template: TemplateConstructor;
+  PixelSignature: PixelSignatureConstructor;
+  IncrementalMatcher: IncrementalMatcherConstructor;
+  Pipeline: PipelineConstructor;
 } = bindings;
 
 const rawPressKey = pressKey;
@@ -166,55 +926,88 @@ const rawPressKey = pressKey;
  * @returns True if the capture and save operation is successful, otherwise false.
  */
 function captureWindow(windowName: string, path: string): boolean {
-  const buffer = captureWindowN(windowName);
+  let buffer: Buffer;
+  try {
+    buffer = captureWindowN(windowName);
+  } catch (error) {
+    if (isCaptureTimeoutError(error)) return false;
+    throw error;
+  }
   if (!buffer) return false;
   fs.writeFileSync(path, buffer);
   return true;
 }
+/**
+ * Starts capturing a window continuously.
+ * @param windowName - The name of the window to capture.
+ * @param options - Frame format, fps limit and queue length (optional).
+ * @param onFrame - Called with every queued frame, in order (optional). Without it, pull frames with `read()`.
+ * @returns The running stream.
+ */
+function startCaptureStream(
+  windowName: string,
+  options?: CaptureStreamOptions,
+  onFrame?: (frame: ImageData) => void
+): CaptureStream {
+  return new CaptureStream(windowName, options, onFrame);
+}
+
+/**
+ * A key event emitted by KeyListener.
+ */
+export type KeyEventData = {
+  keyCode: number;
+  keyName: string;
+  scanCode: number;
+  /**
+   * Milliseconds, from the system clock used by the keyboard hook.
+   */
+  time: number;
+};
+
 export interface KeyListener extends EventEmitter {
   /**
    * Event: Fires when a key is pressed down.
    * @param event - The event name ('keyDown').
    * @param callback - The callback function to handle the event.
    */
-  on(
-    event: "keyDown",
-    callback: (data: { keyCode: number; keyName: string }) => void
-  ): this;
+  on(event: "keyDown", callback: (data: KeyEventData) => void): this;
 
   /**
    * Event: Fires when a key is released.
    * @param event - The event name ('keyUp').
    * @param callback - The callback function to handle the event.
    */
-  on(
-    event: "keyUp",
-    callback: (data: { keyCode: number; keyName: string }) => void
-  ): this;
+  on(event: "keyUp", callback: (data: KeyEventData) => void): this;
 }
 
+const KEY_EVENT_FIELDS = 4;
+const LLKHF_UP = 0x80;
+
 /**
  * Represents a class to listen to keyboard events.
+ * Events reach JS in batches, one native call per batch, and are emitted one by one in order.
  * @extends EventEmitter
  */
 export class KeyListener extends EventEmitter {
-  constructor() {
+  /**
+   * @param options - How long to coalesce events before delivering them (optional). Defaults to no delay.
+   */
+  constructor(options?: KeyBatchOptions) {
     super();
 
-    keyDownHandler((keyCode: number) => {
-      const keyName: string | undefined = keyCodes.get(keyCode.toString());
-      this.emit("keyDown", {
-        keyCode,
-        keyName,
-      });
-    });
-    keyUpHandler((keyCode: number) => {
-      const keyName: string | undefined = keyCodes.get(keyCode.toString());
-      this.emit("keyUp", {
-        keyCode,
-        keyName,
-      });
-    });
+    keyBatchHandler((events: Uint32Array) => {
+      for (let i = 0; i < events.length; i += KEY_EVENT_FIELDS) {
+        const keyCode = events[i];
+        const keyName: string | undefined = keyCodes.get(keyCode.toString());
+        this.emit(events[i + 2] & LLKHF_UP ? "keyUp" : "keyDown", {
+          keyCode,
+          keyName,
+          scanCode: events[i + 1],
+          time: events[i + 3],
+        });
+      }
+    }, options);
   }
 }
 
@@ -235,6 +1028,15 @@ export class OpenCV {
     }
   }
 
+  /**
+   * Loads an image file without blocking the JS thread.
+   * @param path - The file path of the image.
+   * @returns A Promise for an OpenCV instance with the loaded image.
+   */
+  static async readAsync(path: string) {
+    return new OpenCV(await imreadAsync(path));
+  }
+
   /**
    * The width of the image.
    */
@@ -252,12 +1054,49 @@ export class OpenCV {
   /**
    * Matches a template image within the current image.
    * @param template - The template image data to search for.
-   * @param method - The template matching method (optional).
+   * @param method - The template matching method, TM_SQDIFF (0) to TM_CCOEFF_NORMED (5, the default) (optional).
    * @param mask - The optional mask image data to apply the operation (optional).
+   * @param options - Search settings such as search regions or a coarse-to-fine pyramid, and a timeout (optional).
    * @returns The result of the template matching operation.
    */
-  matchTemplate(template: ImageData, method?: number | null, mask?: ImageData) {
-    return matchTemplate(this.imageData, template, method, mask);
+  matchTemplate(
+    template: ImageData,
+    method?: number | null,
+    mask?: ImageData | null,
+    options?: MatchOptions & StopOptions
+  ) {
+    return matchTemplate(this.imageData, template, method, mask, options);
+  }
+
+  /**
+   * Finds every match of a template within the current image.
+   * @param template - The template image data to search for.
+   * @param options - Method, score threshold, result limit, overlap allowed between matches, search regions, tiling and a timeout (optional).
+   * @returns The matches, best first, as packed arrays.
+   */
+  matchTemplateAll(template: ImageData | Image, options?: MatchTemplateAllOptions & StopOptions) {
+    return matchTemplateAll(this.imageData, template, options);
+  }
+
+  /**
+   * Matches several templates within the current image in one call.
+   * @param templates - The template images to search for.
+   * @param method - The template matching method (optional).
+   * @param options - A timeout or abort signal (optional).
+   * @returns One row per template with its best and worst match, as packed arrays.
+   */
+  matchTemplates(templates: (ImageData | Image)[], method?: number, options?: StopOptions) {
+    return matchTemplates(this.imageData, templates, { ...options, method });
+  }
+
+  /**
+   * Finds every match of a template within the current image after thresholding both to black and white.
+   * @param template - The template image data to search for.
+   * @param options - Gray level to threshold at, minimum agreement, result limit, overlap allowed between matches and a timeout (optional).
+   * @returns The matches, best first, as packed arrays.
+   */
+  matchBinary(template: ImageData | Image, options?: MatchBinaryOptions & StopOptions) {
+    return matchBinary(this.imageData, template, options);
   }
 
   /**
@@ -279,7 +1118,7 @@ export class OpenCV {
   }
 
   /**
-   * Draws a rectangle on the image.
+   * Draws a rectangle on a copy of the image. This image is left unchanged.
    * @param start - The starting point of the rectangle.
    * @param end - The ending point of the rectangle.
    * @param rgb - The color (RGB) of the rectangle.
@@ -310,6 +1149,62 @@ export class OpenCV {
     if (!buffer) return;
     fs.writeFileSync(path, buffer);
   }
+
+  /**
+   * Same as matchTemplate, run on the native worker pool.
+   * @returns A Promise for the result of the template matching operation.
+   */
+  matchTemplateAsync(
+    template: ImageData | Image,
+    method?: number | null,
+    mask?: ImageData | Image | null,
+    options?: MatchOptions & StopOptions
+  ) {
+    return matchTemplateAsync(this.imageData, template, method, mask, options);
+  }
+
+  /**
+   * Same as blur, run on the native worker pool.
+   * @returns A Promise for a new OpenCV instance with the blurred image data.
+   */
+  async blurAsync(sizeX: number, sizeY: number) {
+    return new OpenCV(await blurAsync(this.imageData, sizeX, sizeY));
+  }
+
+  /**
+   * Same as bgrToGray, run on the native worker pool.
+   * @returns A Promise for a new OpenCV instance with the grayscale image data.
+   */
+  async bgrToGrayAsync() {
+    return new OpenCV(await bgrToGrayAsync(this.imageData));
+  }
+
+  /**
+   * Same as drawRectangle, run on the native worker pool. Draws on a copy; this image is left unchanged.
+   * @returns A Promise for a new OpenCV instance with the image containing the drawn rectangle.
+   */
+  async drawRectangleAsync(start: Point, end: Point, rgb: Color, thickness: number) {
+    return new OpenCV(
+      await drawRectangleAsync(this.imageData, start, end, rgb, thickness)
+    );
+  }
+
+  /**
+   * Same as getRegion, run on the native worker pool. The region is copied.
+   * @returns A Promise for a new OpenCV instance with the extracted region of interest.
+   */
+  async getRegionAsync(region: ROI) {
+    return new OpenCV(await getRegionAsync(this.imageData, region));
+  }
+
+  /**
+   * Encodes the image on the native worker pool and writes it to a file.
+   * @param path - The file path to save the image.
+   */
+  async imwriteAsync(path: string) {
+    const buffer = await imwriteAsync(this.imageData);
+    await fs.promises.writeFile(path, buffer);
+  }
 }
 function keyPress(keyCode: number, repeat?: number): Promise<boolean> {
   return new Promise((resolve, reject) => {
@@ -328,13 +1223,35 @@ function keyPress(keyCode: number, repeat?: number): Promise<boolean> {
 export {
   keyDownHandler,
   keyUpHandler,
+  keyBatchHandler,
+  getDroppedKeyEvents,
   getWindowData,
   captureWindow,
   captureWindowN,
+  captureWindowAsync,
+  CaptureSession,
+  CaptureStream,
+  startCaptureStream,
+  Image,
+  matchTemplateAll,
+  matchTemplates,
+  matchBinary,
+  imreadAsync,
+  matchTemplateAsync,
+  setWorkerThreads,
+  getWorkerThreads,
+  TemplateBank,
+  Template,
+  PixelSignature,
+  matchSignatures,
+  IncrementalMatcher,
+  Pipeline,
   mouseMove,
   mouseClick,
   mouseDrag,
+  mouseDragAsync,
   typeString,
+  typeStringAsync,
   keyPress,
   rawPressKey,
   KeyCodeHelper
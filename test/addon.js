@@ -0,0 +1,30 @@
+const path = require("path");
+
+/**
+ * Loads the native addon for the tests. The addon only builds on Windows, so suites that need it are skipped
+ * when it cannot be loaded.
+ */
+let addon = null;
+try {
+  addon = require("node-gyp-build")(path.resolve(__dirname, ".."));
+} catch (error) {
+  addon = null;
+}
+
+/**
+ * A gray/BGR/BGRA image of `width` x `height` whose pixel bytes are `fill(x, y, channel)`.
+ */
+function makeImage(width, height, channels, fill) {
+  const data = new Uint8Array(width * height * channels);
+  for (let y = 0; y < height; y++)
+    for (let x = 0; x < width; x++)
+      for (let c = 0; c < channels; c++)
+        data[(y * width + x) * channels + c] = fill(x, y, c);
+  return { width, height, data };
+}
+
+module.exports = {
+  addon,
+  describeAddon: addon ? describe : describe.skip,
+  makeImage,
+};
@@ -0,0 +1,65 @@
+const { addon, describeAddon, makeImage } = require("./addon");
+
+describeAddon("async capture", () => {
+  const image = makeImage(8, 6, 4, (x, y, c) => (x * 13 + y * 7 + c) & 0xff);
+
+  test("grabAsync resolves with the frame", async () => {
+    const session = new addon.CaptureSession(image);
+    const frame = await session.grabAsync({ format: "bgra" });
+    expect(frame.width).toBe(8);
+    expect(frame.height).toBe(6);
+    expect(Buffer.from(frame.data)).toEqual(Buffer.from(image.data));
+
+    const regions = await session.grabAsync({ format: "gray", regions: [[0, 0, 4, 3], [4, 3, 4, 3]] });
+    expect(regions).toHaveLength(2);
+    expect(regions[1].width).toBe(4);
+
+    const png = await session.grabAsync({ format: "png" });
+    expect(Buffer.isBuffer(png)).toBe(true);
+    session.close();
+  });
+
+  test("grabAsync on an empty session rejects with ERR_CAPTURE_TIMEOUT", async () => {
+    const session = new addon.CaptureSession({ width: 8, height: 6, channels: 4 });
+    await expect(session.grabAsync({ timeout: 50 })).rejects.toMatchObject({ code: "ERR_CAPTURE_TIMEOUT" });
+    expect(() => session.grab({ timeout: 10 })).toThrow(expect.objectContaining({ code: "ERR_CAPTURE_TIMEOUT" }));
+    session.close();
+  });
+
+  test("a pending grabAsync resolves with a pushed frame", async () => {
+    const session = new addon.CaptureSession({ width: 8, height: 6, channels: 4 });
+    const pending = session.grabAsync({ timeout: 5000 });
+    setTimeout(() => session.push(image), 20);
+    const frame = await pending;
+    expect(Buffer.from(frame.data)).toEqual(Buffer.from(image.data));
+    expect(() => session.push(makeImage(4, 4, 4, () => 0))).toThrow(TypeError);
+    session.close();
+  });
+
+  test("closing the session rejects a pending grabAsync", async () => {
+    const session = new addon.CaptureSession({ width: 8, height: 6, channels: 4 });
+    const pending = session.grabAsync({ timeout: 5000 });
+    setTimeout(() => session.close(), 20);
+    await expect(pending).rejects.toThrow("Capture session is closed");
+    expect(session.closed).toBe(true);
+  });
+
+  test("grab throws instead of blocking while a grabAsync waits", async () => {
+    const session = new addon.CaptureSession({ width: 8, height: 6, channels: 4 });
+    const pending = session.grabAsync({ timeout: 5000 });
+    await new Promise((resolve) => setTimeout(resolve, 20));
+    expect(() => session.grab({ timeout: 5000 })).toThrow("Capture session is busy");
+    session.push(image);
+    await pending;
+    expect(Buffer.from(session.grab().data)).toEqual(Buffer.from(image.data));
+    session.close();
+  });
+
+  test("captureWindowAsync validates its arguments and rejects for a missing window", async () => {
+    expect(() => addon.captureWindowAsync()).toThrow(TypeError);
+    expect(() => addon.captureWindowAsync("window", { format: "jpeg" })).toThrow(TypeError);
+    await expect(addon.captureWindowAsync("no window has this title 7f3c", { timeout: 50 })).rejects.toThrow(
+      "Window not found"
+    );
+  });
+});
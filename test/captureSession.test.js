@@ -0,0 +1,45 @@
+const { addon, describeAddon, makeImage } = require("./addon");
+
+describeAddon("CaptureSession on an in-memory source", () => {
+  const image = makeImage(8, 6, 4, (x, y, c) => (x * 31 + y * 17 + c * 5) & 0xff);
+
+  test("grab returns the pushed frame as BGRA", () => {
+    const session = new addon.CaptureSession(image);
+    const frame = session.grab({ format: "bgra" });
+    expect(frame.width).toBe(8);
+    expect(frame.height).toBe(6);
+    expect(Buffer.from(frame.data)).toEqual(Buffer.from(image.data));
+    session.close();
+  });
+
+  test("grab can be repeated on the same session", () => {
+    const session = new addon.CaptureSession(image);
+    const first = session.grab({ format: "gray" });
+    const second = session.grab({ format: "gray" });
+    expect(first.width).toBe(8);
+    expect(Buffer.from(second.data)).toEqual(Buffer.from(first.data));
+    expect(session.grab({ regions: [[2, 1, 3, 2]] })).toHaveLength(1);
+    session.close();
+  });
+
+  test("close marks the session closed and is idempotent", () => {
+    const session = new addon.CaptureSession(image);
+    expect(session.closed).toBe(false);
+    session.close();
+    expect(session.closed).toBe(true);
+    expect(() => session.close()).not.toThrow();
+    expect(session.closed).toBe(true);
+  });
+
+  test("grab on a closed session throws", () => {
+    const session = new addon.CaptureSession(image);
+    session.close();
+    expect(() => session.grab()).toThrow("Capture session is closed");
+    expect(() => session.grabAsync()).toThrow("Capture session is closed");
+  });
+
+  test("invalid sources are rejected", () => {
+    expect(() => new addon.CaptureSession()).toThrow(TypeError);
+    expect(() => new addon.CaptureSession({ width: 4, height: 4, data: new Uint8Array(7) })).toThrow(TypeError);
+  });
+});
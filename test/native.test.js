@@ -0,0 +1,29 @@
+const { execFileSync } = require("child_process");
+const fs = require("fs");
+const os = require("os");
+const path = require("path");
+const { compile } = require("../bench/native");
+
+// Standalone C++ tests of the platform independent headers (rings, readback planning, frame sources). Unlike the addon tests,
+// they run on any platform with a C++14 compiler.
+const nativeDir = path.join(__dirname, "native");
+const sources = fs.readdirSync(nativeDir).filter((file) => file.endsWith(".cpp"));
+
+describe("native headers", () => {
+  let buildDir;
+
+  beforeAll(() => {
+    buildDir = fs.mkdtempSync(path.join(os.tmpdir(), "native-test-"));
+  });
+
+  afterAll(() => {
+    fs.rmSync(buildDir, { recursive: true, force: true });
+  });
+
+  test.each(sources)("%s", (file) => {
+    const output = path.join(buildDir, path.basename(file, ".cpp") + (process.platform === "win32" ? ".exe" : ""));
+    if (!compile(path.join(nativeDir, file), output)) return;
+    // Throws with the failed checks in its output when the test exits non-zero
+    execFileSync(output, [], { encoding: "utf8" });
+  }, 120000);
+});
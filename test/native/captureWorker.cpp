@@ -0,0 +1,193 @@
+// CaptureShared, the body of the grabAsync() worker, run on a worker thread against a MemoryFrameSource.
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <frameSource.h>
+#include "check.h"
+
+const int WIDTH = 4;
+const int HEIGHT = 2;
+
+/**
+ * Counts released frames, so a test can tell that every acquired frame was given back.
+ */
+class CountingFrameSource : public MemoryFrameSource
+{
+public:
+    CountingFrameSource() : MemoryFrameSource(WIDTH, HEIGHT) {}
+
+    void ReleaseFrame() override { ++released; }
+
+    int released = 0;
+};
+
+struct WorkerResult
+{
+    SharedCaptureStatus status = SharedCaptureStatus::Closed;
+    uint8_t firstByte = 0;
+};
+
+// Starts a worker the way grabAsync() queues one: it waits up to `timeoutMs` for a frame and copies its first byte
+std::future<WorkerResult> StartWorker(SharedFrameSource &shared, int timeoutMs)
+{
+    return std::async(std::launch::async, [&shared, timeoutMs]
+                      {
+        WorkerResult result;
+        FrameView frame;
+        result.status = CaptureShared(
+            shared, [&](FrameSource &source)
+            { return source.AcquireFrame(frame, timeoutMs); },
+            [&]
+            { result.firstByte = frame.data[0]; });
+        return result; });
+}
+
+void PushFilled(MemoryFrameSource &source, uint8_t value)
+{
+    std::vector<uint8_t> pixels(WIDTH * HEIGHT * 4, value);
+    source.PushFrame(pixels.data(), WIDTH * 4);
+}
+
+void PendingWorkerTakesFramePushedLater()
+{
+    CountingFrameSource *source = new CountingFrameSource();
+    SharedFrameSource shared{std::unique_ptr<FrameSource>(source)};
+
+    std::future<WorkerResult> worker = StartWorker(shared, 10000);
+    // The worker is waiting for a frame that does not exist yet
+    CHECK(worker.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout);
+
+    std::thread producer([source]
+                         { PushFilled(*source, 9); });
+    producer.join();
+
+    const WorkerResult result = worker.get();
+    CHECK(result.status == SharedCaptureStatus::Captured);
+    CHECK_EQ(result.firstByte, 9);
+    CHECK_EQ(source->released, 1);
+}
+
+void CloseRejectsPendingWorker()
+{
+    CountingFrameSource *source = new CountingFrameSource();
+    SharedFrameSource shared{std::unique_ptr<FrameSource>(source)};
+
+    std::future<WorkerResult> worker = StartWorker(shared, 10000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    // Close() must not wait for the shared mutex the worker holds
+    source->Close();
+
+    CHECK(worker.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    CHECK(worker.get().status == SharedCaptureStatus::Closed);
+    CHECK_EQ(source->released, 0);
+}
+
+void ClosedSourceRejectsNewWorker()
+{
+    SharedFrameSource shared{std::unique_ptr<FrameSource>(new CountingFrameSource())};
+    PushFilled(static_cast<MemoryFrameSource &>(*shared.source), 1);
+    shared.source->Close();
+
+    CHECK(StartWorker(shared, 10000).get().status == SharedCaptureStatus::Closed);
+}
+
+void WorkerTimesOut()
+{
+    SharedFrameSource shared{std::unique_ptr<FrameSource>(new CountingFrameSource())};
+    const auto start = std::chrono::steady_clock::now();
+    const WorkerResult result = StartWorker(shared, 50).get();
+    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    CHECK(result.status == SharedCaptureStatus::TimedOut);
+    CHECK(elapsedMs >= 45);
+    CHECK(!shared.source->IsClosed());
+}
+
+void ReleasesFrameWhenReadThrows()
+{
+    CountingFrameSource *source = new CountingFrameSource();
+    SharedFrameSource shared{std::unique_ptr<FrameSource>(source)};
+    PushFilled(*source, 1);
+
+    bool threw = false;
+    try
+    {
+        FrameView frame;
+        CaptureShared(
+            shared, [&](FrameSource &frameSource)
+            { return frameSource.AcquireFrame(frame, 0); },
+            []
+            { throw std::runtime_error("Failed to encode the frame as PNG"); });
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK_EQ(source->released, 1);
+    // The mutex was released with the frame, so the next worker gets through
+    CHECK(StartWorker(shared, 0).get().status == SharedCaptureStatus::Captured);
+}
+
+void GrabDoesNotWaitForABusySource()
+{
+    SharedFrameSource shared{std::unique_ptr<FrameSource>(new CountingFrameSource())};
+    std::future<WorkerResult> worker = StartWorker(shared, 10000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // The JS-thread grab gives up at once instead of waiting for the worker's frame
+    bool acquired = false;
+    FrameView frame;
+    const auto start = std::chrono::steady_clock::now();
+    const SharedCaptureStatus status = CaptureShared(
+        shared, [&](FrameSource &source)
+        { return acquired = source.AcquireFrame(frame, 10000); },
+        [] {}, false);
+    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    CHECK(status == SharedCaptureStatus::Busy);
+    CHECK(!acquired);
+    CHECK(elapsedMs < 1000);
+
+    PushFilled(static_cast<MemoryFrameSource &>(*shared.source), 4);
+    CHECK(worker.get().status == SharedCaptureStatus::Captured);
+    // Once the worker is done the source is free again
+    CHECK(CaptureShared(
+              shared, [&](FrameSource &source)
+              { return source.AcquireFrame(frame, 0); },
+              [] {}, false) == SharedCaptureStatus::Captured);
+}
+
+void WorkersTakeTurns()
+{
+    CountingFrameSource *source = new CountingFrameSource();
+    SharedFrameSource shared{std::unique_ptr<FrameSource>(source)};
+    PushFilled(*source, 3);
+
+    std::vector<std::future<WorkerResult>> workers;
+    for (int i = 0; i < 8; ++i)
+        workers.push_back(StartWorker(shared, 1000));
+    bool captured = true;
+    for (std::future<WorkerResult> &worker : workers)
+    {
+        const WorkerResult result = worker.get();
+        captured = captured && result.status == SharedCaptureStatus::Captured && result.firstByte == 3;
+    }
+    CHECK(captured);
+    CHECK_EQ(source->released, 8);
+}
+
+int main()
+{
+    RUN_TEST(PendingWorkerTakesFramePushedLater);
+    RUN_TEST(CloseRejectsPendingWorker);
+    RUN_TEST(ClosedSourceRejectsNewWorker);
+    RUN_TEST(WorkerTimesOut);
+    RUN_TEST(ReleasesFrameWhenReadThrows);
+    RUN_TEST(GrabDoesNotWaitForABusySource);
+    RUN_TEST(WorkersTakeTurns);
+    return CheckFailures();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdio>
+
+/**
+ * Minimal assertions for the standalone native tests. A failed check is reported and counted, and the test keeps
+ * going; main() returns CheckFailures() so the runner sees a non-zero exit code.
+ */
+inline int &CheckFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                           \
+    do                                                                             \
+    {                                                                              \
+        if (!(condition))                                                          \
+        {                                                                          \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++CheckFailures();                                                     \
+        }                                                                          \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                 \
+    do                                                                                             \
+    {                                                                                              \
+        const auto checkActual = (actual);                                                         \
+        const auto checkExpected = (expected);                                                     \
+        if (!(checkActual == checkExpected))                                                       \
+        {                                                                                          \
+            std::printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #actual, \
+                        #expected, static_cast<long long>(checkActual), static_cast<long long>(checkExpected)); \
+            ++CheckFailures();                                                                     \
+        }                                                                                          \
+    } while (0)
+
+/**
+ * Runs one named test case.
+ */
+#define RUN_TEST(test)                      \
+    do                                      \
+    {                                       \
+        const int failuresBefore = CheckFailures(); \
+        test();                             \
+        std::printf("%s %s\n", CheckFailures() == failuresBefore ? "ok  " : "FAIL", #test); \
+    } while (0)
@@ -0,0 +1,185 @@
+// FrameRing fed by a synthetic source: frames are numbered by their sequence and their first byte.
+#include <atomic>
+#include <thread>
+#include <frameRing.h>
+#include "check.h"
+
+void PushFrame(FrameRing &ring, uint64_t sequence, int width = 4, int height = 2)
+{
+    FrameSlot *slot = ring.BeginWrite(width, height, 4);
+    slot->data[0] = static_cast<uint8_t>(sequence);
+    ring.CommitWrite(slot, sequence);
+}
+
+void ReadsInOrder()
+{
+    FrameRing ring(3);
+    for (uint64_t i = 1; i <= 3; ++i)
+        PushFrame(ring, i);
+    CHECK_EQ(ring.Stats().queued, 3u);
+
+    for (uint64_t i = 1; i <= 3; ++i)
+    {
+        FrameSlot *slot = ring.BeginReadNext();
+        CHECK(slot != nullptr);
+        CHECK_EQ(slot->sequence, i);
+        CHECK_EQ(slot->data[0], i);
+        ring.EndRead(slot);
+    }
+    CHECK(ring.BeginReadNext() == nullptr);
+
+    FrameRingStats stats = ring.Stats();
+    CHECK_EQ(stats.delivered, 3u);
+    CHECK_EQ(stats.dropped, 0u);
+    CHECK_EQ(stats.queued, 0u);
+}
+
+void DropsOldestWhenFull()
+{
+    FrameRing ring(2);
+    for (uint64_t i = 1; i <= 5; ++i)
+        PushFrame(ring, i);
+
+    // Only the two newest frames are kept
+    FrameRingStats stats = ring.Stats();
+    CHECK_EQ(stats.queued, 2u);
+    CHECK_EQ(stats.dropped, 3u);
+
+    FrameSlot *slot = ring.BeginReadNext();
+    CHECK_EQ(slot->sequence, 4u);
+    ring.EndRead(slot);
+    slot = ring.BeginReadNext();
+    CHECK_EQ(slot->sequence, 5u);
+    ring.EndRead(slot);
+    CHECK_EQ(ring.Stats().delivered, 2u);
+}
+
+void DropsOldestWhileReaderHoldsSlot()
+{
+    FrameRing ring(1);
+    PushFrame(ring, 1);
+    FrameSlot *held = ring.BeginReadNext();
+
+    // The reader keeps slot 1; the producer cycles through the remaining two slots
+    for (uint64_t i = 2; i <= 6; ++i)
+        PushFrame(ring, i);
+    CHECK_EQ(held->sequence, 1u);
+    CHECK_EQ(held->data[0], 1);
+    ring.EndRead(held);
+
+    FrameSlot *slot = ring.BeginReadNext();
+    CHECK_EQ(slot->sequence, 6u);
+    ring.EndRead(slot);
+
+    FrameRingStats stats = ring.Stats();
+    CHECK_EQ(stats.delivered, 2u);
+    CHECK_EQ(stats.dropped, 4u);
+}
+
+void ReadLatestDropsOlder()
+{
+    FrameRing ring(4);
+    for (uint64_t i = 1; i <= 4; ++i)
+        PushFrame(ring, i);
+
+    FrameSlot *slot = ring.BeginReadLatest();
+    CHECK_EQ(slot->sequence, 4u);
+    ring.EndRead(slot);
+    CHECK(ring.BeginReadLatest() == nullptr);
+
+    FrameRingStats stats = ring.Stats();
+    CHECK_EQ(stats.delivered, 1u);
+    CHECK_EQ(stats.dropped, 3u);
+    CHECK_EQ(stats.queued, 0u);
+}
+
+void CountsSkipped()
+{
+    FrameRing ring(2);
+    for (uint64_t i = 1; i <= 10; ++i)
+    {
+        // An fps limit that stores every other frame
+        if (i % 2)
+            ring.CountSkipped();
+        else
+            PushFrame(ring, i);
+    }
+    FrameRingStats stats = ring.Stats();
+    CHECK_EQ(stats.skipped, 5u);
+    CHECK_EQ(stats.dropped, 3u);
+    CHECK_EQ(stats.queued, 2u);
+}
+
+void ReusesBuffersUntilFramesGrow()
+{
+    FrameRing ring(1);
+    PushFrame(ring, 1, 8, 8);
+    FrameSlot *slot = ring.BeginReadNext();
+    const uint8_t *buffer = slot->data.data();
+    ring.EndRead(slot);
+
+    // Smaller frames reuse the same allocations
+    for (uint64_t i = 2; i <= 10; ++i)
+    {
+        PushFrame(ring, i, 4, 4);
+        slot = ring.BeginReadNext();
+        CHECK_EQ(slot->width, 4);
+        CHECK(slot->data.size() >= 4u * 4 * 4);
+        ring.EndRead(slot);
+    }
+    bool sawFirstBuffer = false;
+    for (int i = 0; i < 3; ++i)
+    {
+        PushFrame(ring, 20 + i, 2, 2);
+        slot = ring.BeginReadNext();
+        sawFirstBuffer = sawFirstBuffer || slot->data.data() == buffer;
+        ring.EndRead(slot);
+    }
+    CHECK(sawFirstBuffer);
+}
+
+void ThreadedProducerAccountsForEveryFrame()
+{
+    const uint64_t frames = 200000;
+    FrameRing ring(2);
+    std::atomic<bool> done{false};
+    std::thread producer([&]
+                         {
+        for (uint64_t i = 1; i <= frames; ++i)
+            PushFrame(ring, i);
+        done = true; });
+
+    uint64_t lastSequence = 0;
+    bool ordered = true;
+    for (;;)
+    {
+        const bool finished = done;
+        while (FrameSlot *slot = ring.BeginReadNext())
+        {
+            ordered = ordered && slot->sequence > lastSequence && slot->data[0] == static_cast<uint8_t>(slot->sequence);
+            lastSequence = slot->sequence;
+            ring.EndRead(slot);
+        }
+        if (finished)
+            break;
+    }
+    producer.join();
+
+    CHECK(ordered);
+    CHECK_EQ(lastSequence, frames);
+    FrameRingStats stats = ring.Stats();
+    CHECK_EQ(stats.delivered + stats.dropped, frames);
+    CHECK_EQ(stats.queued, 0u);
+}
+
+int main()
+{
+    RUN_TEST(ReadsInOrder);
+    RUN_TEST(DropsOldestWhenFull);
+    RUN_TEST(DropsOldestWhileReaderHoldsSlot);
+    RUN_TEST(ReadLatestDropsOlder);
+    RUN_TEST(CountsSkipped);
+    RUN_TEST(ReusesBuffersUntilFramesGrow);
+    RUN_TEST(ThreadedProducerAccountsForEveryFrame);
+    return CheckFailures();
+}
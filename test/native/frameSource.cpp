@@ -0,0 +1,206 @@
+// MemoryFrameSource and SharedFrameSource: the frame source capture sessions use when they are given image data.
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <frameSource.h>
+#include "check.h"
+
+const int WIDTH = 4;
+const int HEIGHT = 2;
+
+void PushFilled(MemoryFrameSource &source, uint8_t value)
+{
+    std::vector<uint8_t> pixels(WIDTH * HEIGHT * 4, value);
+    source.PushFrame(pixels.data(), WIDTH * 4);
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void AcquiresPushedFrame()
+{
+    MemoryFrameSource source(WIDTH, HEIGHT);
+    PushFilled(source, 7);
+
+    FrameView frame;
+    CHECK(source.AcquireFrame(frame, 0));
+    CHECK_EQ(frame.width, WIDTH);
+    CHECK_EQ(frame.height, HEIGHT);
+    CHECK_EQ(frame.channels, 4);
+    CHECK_EQ(frame.stride, static_cast<size_t>(WIDTH * 4));
+    CHECK_EQ(frame.sequence, 1u);
+    CHECK_EQ(frame.data[0], 7);
+    CHECK_EQ(frame.data[WIDTH * HEIGHT * 4 - 1], 7);
+    source.ReleaseFrame();
+}
+
+void CopiesRowsAcrossStride()
+{
+    MemoryFrameSource source(2, 2, 1);
+    // Two rows of two pixels, each row padded to four bytes
+    const uint8_t padded[] = {1, 2, 0, 0, 3, 4, 0, 0};
+    source.PushFrame(padded, 4);
+
+    FrameView frame;
+    CHECK(source.AcquireFrame(frame, 0));
+    CHECK_EQ(frame.stride, 2u);
+    CHECK((std::vector<uint8_t>(frame.data, frame.data + 4) == std::vector<uint8_t>{1, 2, 3, 4}));
+}
+
+void RepeatsFrameUntilANewOneArrives()
+{
+    MemoryFrameSource source(WIDTH, HEIGHT);
+    PushFilled(source, 1);
+
+    FrameView first, again;
+    CHECK(source.AcquireFrame(first, 0));
+    // Without `after` the current frame is handed out again
+    CHECK(source.AcquireFrame(again, 0));
+    CHECK_EQ(again.sequence, first.sequence);
+    CHECK_EQ(again.data[0], 1);
+
+    // Asking for something newer than the current frame waits, and gives up without one
+    FrameView newer;
+    CHECK(!source.AcquireFrame(newer, 10, first.sequence));
+
+    PushFilled(source, 2);
+    CHECK(source.AcquireFrame(newer, 0, first.sequence));
+    CHECK_EQ(newer.sequence, 2u);
+    CHECK_EQ(newer.data[0], 2);
+}
+
+void SkipsToLatestFrame()
+{
+    MemoryFrameSource source(WIDTH, HEIGHT);
+    for (uint8_t i = 1; i <= 3; ++i)
+        PushFilled(source, i);
+
+    FrameView frame;
+    CHECK(source.AcquireFrame(frame, 0));
+    CHECK_EQ(frame.sequence, 3u);
+    CHECK_EQ(frame.data[0], 3);
+}
+
+void TimesOutWithoutAFrame()
+{
+    MemoryFrameSource source(WIDTH, HEIGHT);
+    FrameView frame;
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(!source.AcquireFrame(frame, 50));
+    CHECK(ElapsedMs(start) >= 45);
+    CHECK(!source.IsClosed());
+}
+
+void CloseWakesWaiter()
+{
+    MemoryFrameSource source(WIDTH, HEIGHT);
+    bool acquired = true;
+    double waitedMs = 0;
+    std::thread waiter([&]
+                       {
+        FrameView frame;
+        const auto start = std::chrono::steady_clock::now();
+        acquired = source.AcquireFrame(frame, 10000);
+        waitedMs = ElapsedMs(start); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    source.Close();
+    waiter.join();
+
+    CHECK(!acquired);
+    CHECK(waitedMs < 5000);
+    CHECK(source.IsClosed());
+}
+
+void RefusesAfterClose()
+{
+    MemoryFrameSource source(WIDTH, HEIGHT);
+    PushFilled(source, 1);
+    source.Close();
+
+    FrameView frame;
+    CHECK(!source.AcquireFrame(frame, 0));
+    // Frames pushed after closing are dropped
+    PushFilled(source, 2);
+    CHECK(!source.AcquireFrame(frame, 0));
+}
+
+void CropsRegions()
+{
+    MemoryFrameSource source(WIDTH, HEIGHT, 1);
+    const uint8_t pixels[] = {0, 1, 2, 3, 10, 11, 12, 13};
+    source.PushFrame(pixels, WIDTH);
+
+    std::vector<FrameView> views;
+    CHECK(source.AcquireRegions({FrameRect{1, 1, 2, 1}, FrameRect{3, 0, 1, 2}}, views, 0));
+    CHECK_EQ(views.size(), 2u);
+    CHECK_EQ(views[0].data[0], 11);
+    CHECK_EQ(views[0].width, 2);
+    CHECK_EQ(views[1].data[0], 3);
+    CHECK_EQ(views[1].data[views[1].stride], 13);
+    source.ReleaseFrame();
+
+    bool threw = false;
+    try
+    {
+        source.AcquireRegions({FrameRect{3, 0, 2, 1}}, views, 0);
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+void SharedSourceServesOneReaderAtATime()
+{
+    // Readers on several threads take turns through the shared mutex, the way grab() and grabAsync() do
+    SharedFrameSource shared(std::unique_ptr<FrameSource>(new MemoryFrameSource(WIDTH, HEIGHT)));
+    PushFilled(static_cast<MemoryFrameSource &>(*shared.source), 5);
+
+    std::vector<std::thread> readers;
+    std::vector<int> acquired(4, 0);
+    int inside = 0;
+    bool overlapped = false;
+    for (size_t i = 0; i < acquired.size(); ++i)
+        readers.emplace_back([&, i]
+                             {
+            for (int round = 0; round < 100; ++round)
+            {
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                FrameView frame;
+                if (!shared.source->AcquireFrame(frame, 1000))
+                    continue;
+                overlapped = overlapped || ++inside != 1;
+                acquired[i] += frame.data[0] == 5;
+                --inside;
+                shared.source->ReleaseFrame();
+            } });
+    for (std::thread &reader : readers)
+        reader.join();
+
+    CHECK(!overlapped);
+    bool all = true;
+    for (int count : acquired)
+        all = all && count == 100;
+    CHECK(all);
+}
+
+int main()
+{
+    RUN_TEST(AcquiresPushedFrame);
+    RUN_TEST(CopiesRowsAcrossStride);
+    RUN_TEST(RepeatsFrameUntilANewOneArrives);
+    RUN_TEST(SkipsToLatestFrame);
+    RUN_TEST(TimesOutWithoutAFrame);
+    RUN_TEST(CloseWakesWaiter);
+    RUN_TEST(RefusesAfterClose);
+    RUN_TEST(CropsRegions);
+    RUN_TEST(SharedSourceServesOneReaderAtATime);
+    return CheckFailures();
+}
@@ -0,0 +1,160 @@
+// PlanReadback, checked by carrying out each plan on a synthetic frame and comparing every region's pixels.
+#include <stdexcept>
+#include <readbackPlan.h>
+#include "check.h"
+
+const int FRAME_WIDTH = 64;
+const int FRAME_HEIGHT = 48;
+
+int FramePixel(int x, int y)
+{
+    return y * FRAME_WIDTH + x;
+}
+
+/**
+ * Performs the copies of `plan` and checks that each planned region holds the pixels of the requested one.
+ */
+bool PlanReadsRegions(const ReadbackPlan &plan, const std::vector<FrameRect> &requested)
+{
+    std::vector<int> readback(static_cast<size_t>(plan.width) * plan.height, -1);
+    for (const RegionCopy &copy : plan.copies)
+    {
+        if (copy.dstX < 0 || copy.dstY < 0 || copy.dstX + copy.source.width > plan.width || copy.dstY + copy.source.height > plan.height)
+            return false;
+        for (int y = 0; y < copy.source.height; ++y)
+            for (int x = 0; x < copy.source.width; ++x)
+                readback[(copy.dstY + y) * plan.width + copy.dstX + x] = FramePixel(copy.source.x + x, copy.source.y + y);
+    }
+
+    const std::vector<FrameRect> expected = requested.empty() ? std::vector<FrameRect>{{0, 0, FRAME_WIDTH, FRAME_HEIGHT}} : requested;
+    if (plan.regions.size() != expected.size())
+        return false;
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        const FrameRect &planned = plan.regions[i];
+        if (planned.width != expected[i].width || planned.height != expected[i].height)
+            return false;
+        for (int y = 0; y < planned.height; ++y)
+            for (int x = 0; x < planned.width; ++x)
+                if (readback[(planned.y + y) * plan.width + planned.x + x] != FramePixel(expected[i].x + x, expected[i].y + y))
+                    return false;
+    }
+    return true;
+}
+
+bool Rejected(const std::vector<FrameRect> &regions)
+{
+    try
+    {
+        PlanReadback(FRAME_WIDTH, FRAME_HEIGHT, regions);
+        return false;
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+}
+
+void NoRegionsReadsWholeFrame()
+{
+    ReadbackPlan plan = PlanReadback(FRAME_WIDTH, FRAME_HEIGHT, {});
+    CHECK_EQ(plan.width, FRAME_WIDTH);
+    CHECK_EQ(plan.height, FRAME_HEIGHT);
+    CHECK_EQ(plan.copies.size(), 1u);
+    CHECK(PlanReadsRegions(plan, {}));
+}
+
+void SingleRegionIsCopiedAlone()
+{
+    const std::vector<FrameRect> regions{{10, 5, 20, 8}};
+    ReadbackPlan plan = PlanReadback(FRAME_WIDTH, FRAME_HEIGHT, regions);
+    CHECK_EQ(plan.width, 20);
+    CHECK_EQ(plan.height, 8);
+    CHECK_EQ(plan.copies.size(), 1u);
+    CHECK(PlanReadsRegions(plan, regions));
+}
+
+void RegionsAtTheFrameEdgeAreAccepted()
+{
+    const std::vector<FrameRect> corners{{0, 0, 4, 4}, {FRAME_WIDTH - 4, FRAME_HEIGHT - 4, 4, 4}};
+    CHECK(PlanReadsRegions(PlanReadback(FRAME_WIDTH, FRAME_HEIGHT, corners), corners));
+    const std::vector<FrameRect> whole{{0, 0, FRAME_WIDTH, FRAME_HEIGHT}};
+    CHECK(PlanReadsRegions(PlanReadback(FRAME_WIDTH, FRAME_HEIGHT, whole), whole));
+}
+
+void RegionsCrossingTheFrameEdgeAreRejected()
+{
+    // Regions are not clipped to the frame: one pixel past any edge is an error
+    CHECK(Rejected({{FRAME_WIDTH - 4, 0, 5, 4}}));
+    CHECK(Rejected({{0, FRAME_HEIGHT - 4, 4, 5}}));
+    CHECK(Rejected({{-1, 0, 4, 4}}));
+    CHECK(Rejected({{0, -1, 4, 4}}));
+    CHECK(Rejected({{FRAME_WIDTH, 0, 1, 1}}));
+    // A bad region anywhere in the list rejects the whole list
+    CHECK(Rejected({{0, 0, 4, 4}, {60, 40, 8, 8}}));
+}
+
+void EmptyRegionsAreRejected()
+{
+    CHECK(Rejected({{5, 5, 0, 4}}));
+    CHECK(Rejected({{5, 5, 4, 0}}));
+    CHECK(Rejected({{5, 5, -4, 4}}));
+    CHECK(Rejected({{0, 0, 4, 4}, {5, 5, 0, 0}}));
+}
+
+void NearbyRegionsShareTheirBoundingBox()
+{
+    // Bounding box 20x10 = 200 pixels for 160 pixels of regions
+    const std::vector<FrameRect> regions{{10, 10, 10, 10}, {20, 10, 6, 10}, {26, 10, 4, 5}};
+    ReadbackPlan plan = PlanReadback(FRAME_WIDTH, FRAME_HEIGHT, regions);
+    CHECK_EQ(plan.copies.size(), 1u);
+    CHECK_EQ(plan.width, 20);
+    CHECK_EQ(plan.height, 10);
+    CHECK(PlanReadsRegions(plan, regions));
+}
+
+void OverlappingRegionsShareTheirBoundingBox()
+{
+    const std::vector<FrameRect> regions{{8, 8, 16, 16}, {12, 12, 16, 16}};
+    ReadbackPlan plan = PlanReadback(FRAME_WIDTH, FRAME_HEIGHT, regions);
+    CHECK_EQ(plan.copies.size(), 1u);
+    CHECK_EQ(plan.width, 20);
+    CHECK_EQ(plan.height, 20);
+    CHECK(PlanReadsRegions(plan, regions));
+}
+
+void ScatteredRegionsAreStacked()
+{
+    // Opposite corners: the bounding box is the whole frame for 32 pixels of regions
+    const std::vector<FrameRect> regions{{0, 0, 4, 4}, {FRAME_WIDTH - 6, FRAME_HEIGHT - 3, 6, 3}, {30, 20, 2, 2}};
+    ReadbackPlan plan = PlanReadback(FRAME_WIDTH, FRAME_HEIGHT, regions);
+    CHECK_EQ(plan.copies.size(), 3u);
+    CHECK_EQ(plan.width, 6);
+    CHECK_EQ(plan.height, 4 + 3 + 2);
+    CHECK(PlanReadsRegions(plan, regions));
+}
+
+void BoundingBoxSlackIsTheCutoff()
+{
+    // Two 8x8 regions (128 pixels): a 16x16 box (256) is shared, a 17x16 box (272) is not
+    const std::vector<FrameRect> atSlack{{0, 0, 8, 8}, {8, 8, 8, 8}};
+    CHECK_EQ(PlanReadback(FRAME_WIDTH, FRAME_HEIGHT, atSlack).copies.size(), 1u);
+    const std::vector<FrameRect> pastSlack{{0, 0, 8, 8}, {9, 8, 8, 8}};
+    ReadbackPlan plan = PlanReadback(FRAME_WIDTH, FRAME_HEIGHT, pastSlack);
+    CHECK_EQ(plan.copies.size(), 2u);
+    CHECK(PlanReadsRegions(plan, pastSlack));
+}
+
+int main()
+{
+    RUN_TEST(NoRegionsReadsWholeFrame);
+    RUN_TEST(SingleRegionIsCopiedAlone);
+    RUN_TEST(RegionsAtTheFrameEdgeAreAccepted);
+    RUN_TEST(RegionsCrossingTheFrameEdgeAreRejected);
+    RUN_TEST(EmptyRegionsAreRejected);
+    RUN_TEST(NearbyRegionsShareTheirBoundingBox);
+    RUN_TEST(OverlappingRegionsShareTheirBoundingBox);
+    RUN_TEST(ScatteredRegionsAreStacked);
+    RUN_TEST(BoundingBoxSlackIsTheCutoff);
+    return CheckFailures();
+}
@@ -0,0 +1,145 @@
+// SpscRing: order across wraparound, overflow counting, coalesced wakeups and a threaded producer/consumer.
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <spscRing.h>
+#include "check.h"
+
+void PopsInOrderAcrossWraparound()
+{
+    SpscRing<int, 4> ring;
+    int next = 0;
+    int expected = 0;
+    bool ordered = true;
+    // Pushes three, pops two, so the indexes run past the capacity many times
+    for (int round = 0; round < 20; ++round)
+    {
+        for (int i = 0; i < 3; ++i)
+            ring.TryPush(next++);
+        for (int i = 0; i < 2; ++i)
+        {
+            int item = -1;
+            if (!ring.TryPop(item))
+                break;
+            ordered = ordered && item == expected++;
+        }
+        while (ring.Drain([&](int item)
+                          { ordered = ordered && item == expected++; }) > 0)
+        {
+        }
+    }
+    CHECK(ordered);
+    CHECK_EQ(expected, next);
+    CHECK_EQ(ring.Overflow(), 0u);
+
+    int item = -1;
+    CHECK(!ring.TryPop(item));
+}
+
+void CountsOverflowAndKeepsOldest()
+{
+    SpscRing<int, 4> ring;
+    for (int i = 0; i < 10; ++i)
+        CHECK_EQ(ring.TryPush(i), i < 4);
+    CHECK_EQ(ring.Overflow(), 6u);
+
+    std::vector<int> drained;
+    CHECK_EQ(ring.Drain([&](int item)
+                        { drained.push_back(item); }),
+             4u);
+    CHECK((drained == std::vector<int>{0, 1, 2, 3}));
+
+    // Space freed by the drain is usable again
+    CHECK(ring.TryPush(10));
+    CHECK_EQ(ring.Overflow(), 6u);
+}
+
+void CoalescesWakeups()
+{
+    SpscRing<int, 8> ring;
+    ring.TryPush(1);
+    CHECK(ring.RequestWakeup());
+    // More records before the consumer runs need no further wakeup
+    ring.TryPush(2);
+    CHECK(!ring.RequestWakeup());
+    ring.TryPush(3);
+    CHECK(!ring.RequestWakeup());
+
+    ring.BeginDrain();
+    CHECK_EQ(ring.Drain([](int) {}), 3u);
+
+    // A record pushed after BeginDrain wakes the consumer again, even if the running drain picked it up
+    ring.BeginDrain();
+    ring.TryPush(4);
+    CHECK(ring.RequestWakeup());
+    CHECK_EQ(ring.Drain([](int) {}), 1u);
+    CHECK(!ring.RequestWakeup());
+}
+
+void ThreadedProducerLosesNoWakeup()
+{
+    // The consumer only runs when woken, the way the addon's JS-thread callback only runs when scheduled. If a
+    // record could be left in the ring without a pending wakeup, the consumer would sleep until the timeout.
+    SpscRing<uint32_t, 64> ring;
+    const uint32_t records = 50000;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool woken = false;
+
+    std::thread producer([&]
+                         {
+        for (uint32_t i = 1; i <= records; ++i)
+        {
+            ring.TryPush(i);
+            if (ring.RequestWakeup())
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                woken = true;
+                wake.notify_one();
+            }
+            // Lets the consumer keep up, so most records go through a drain rather than the overflow count
+            if (i % 16 == 0)
+                std::this_thread::yield();
+        } });
+
+    uint64_t received = 0;
+    uint32_t last = 0;
+    bool ordered = true;
+    bool lostWakeup = false;
+    while (received + ring.Overflow() < records)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!wake.wait_for(lock, std::chrono::seconds(10), [&]
+                               { return woken; }))
+            {
+                lostWakeup = true;
+                break;
+            }
+            woken = false;
+        }
+        ring.BeginDrain();
+        received += ring.Drain([&](uint32_t item)
+                               {
+            ordered = ordered && item > last;
+            last = item; });
+    }
+    producer.join();
+
+    CHECK(!lostWakeup);
+    CHECK(ordered);
+    CHECK(received > 0);
+    CHECK_EQ(received + ring.Overflow(), records);
+}
+
+int main()
+{
+    RUN_TEST(PopsInOrderAcrossWraparound);
+    RUN_TEST(CountsOverflowAndKeepsOldest);
+    RUN_TEST(CoalescesWakeups);
+    RUN_TEST(ThreadedProducerLosesNoWakeup);
+    return CheckFailures();
+}
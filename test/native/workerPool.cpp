@@ -0,0 +1,131 @@
+// WorkerPool: batches from outside the pool, nested batches from inside it, errors, shutdown and replacement.
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+#include <workerPool.h>
+#include "check.h"
+
+void RunsEveryIndexOnce()
+{
+    WorkerPool pool(4);
+    std::vector<std::atomic<int>> runs(1000);
+    pool.ParallelFor(runs.size(), [&](size_t i)
+                     { ++runs[i]; });
+    bool once = true;
+    for (std::atomic<int> &count : runs)
+        once = once && count.load() == 1;
+    CHECK(once);
+}
+
+void NestedBatchesFinishOnOneThread()
+{
+    // Every outer index waits for an inner batch; with a single worker that only finishes if the waiting
+    // worker runs the inner tasks itself
+    WorkerPool pool(1);
+    std::atomic<int> total{0};
+    pool.ParallelFor(8, [&](size_t)
+                     { pool.ParallelFor(8, [&](size_t)
+                                        { ++total; }); });
+    CHECK_EQ(total.load(), 64);
+}
+
+void NestedBatchesFinishOnManyThreads()
+{
+    WorkerPool pool(4);
+    std::atomic<int> total{0};
+    for (int round = 0; round < 50; ++round)
+        pool.ParallelFor(16, [&](size_t)
+                         { pool.ParallelFor(16, [&](size_t)
+                                            { ++total; }); });
+    CHECK_EQ(total.load(), 50 * 16 * 16);
+}
+
+void RethrowsFirstError()
+{
+    WorkerPool pool(4);
+    bool caught = false;
+    try
+    {
+        pool.ParallelFor(100, [](size_t i)
+                         { if (i == 10) throw std::runtime_error("tile failed"); });
+    }
+    catch (const std::runtime_error &)
+    {
+        caught = true;
+    }
+    CHECK(caught);
+}
+
+void SkipsIndexesOnceCancelled()
+{
+    WorkerPool pool(1);
+    std::atomic<bool> cancel{false};
+    std::atomic<int> runs{0};
+    pool.ParallelFor(100, [&](size_t)
+                     { ++runs;
+                       cancel = true; },
+                     &cancel);
+    CHECK(runs.load() < 100);
+}
+
+void RunsInlineAfterShutdown()
+{
+    WorkerPool pool(2);
+    pool.Shutdown();
+
+    int runs = 0;
+    pool.Submit([&runs]
+                { ++runs; });
+    pool.ParallelFor(10, [&runs](size_t)
+                     { ++runs; });
+    CHECK_EQ(runs, 11);
+}
+
+void ShutdownFinishesQueuedTasks()
+{
+    std::atomic<int> runs{0};
+    {
+        WorkerPool pool(2);
+        for (int i = 0; i < 100; ++i)
+            pool.Submit([&runs]
+                        { ++runs; });
+    }
+    CHECK_EQ(runs.load(), 100);
+}
+
+void ReplacedPoolKeepsWorkingForItsUsers()
+{
+    SharedPoolSlot slot;
+    std::shared_ptr<WorkerPool> old = slot.Get();
+    std::atomic<bool> release{false};
+    std::atomic<int> runs{0};
+    old->Submit([&]
+                { while (!release) std::this_thread::yield(); ++runs; });
+
+    // Returns while the old pool is still busy
+    slot.Replace(2);
+    CHECK(slot.Get() != old);
+    CHECK_EQ(slot.Get()->Size(), 2u);
+    release = true;
+
+    // The old pool stops taking tasks once it is retired, but a holder's batches still finish
+    old->ParallelFor(10, [&runs](size_t)
+                     { ++runs; });
+    while (runs.load() < 11)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    CHECK_EQ(runs.load(), 11);
+}
+
+int main()
+{
+    RUN_TEST(RunsEveryIndexOnce);
+    RUN_TEST(NestedBatchesFinishOnOneThread);
+    RUN_TEST(NestedBatchesFinishOnManyThreads);
+    RUN_TEST(RethrowsFirstError);
+    RUN_TEST(SkipsIndexesOnceCancelled);
+    RUN_TEST(RunsInlineAfterShutdown);
+    RUN_TEST(ShutdownFinishesQueuedTasks);
+    RUN_TEST(ReplacedPoolKeepsWorkingForItsUsers);
+    return CheckFailures();
+}